@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+// Cola de trabajos de mantenimiento en segundo plano (actualización de
+// patrones, etc.). Los trabajos se ejecutan de uno en uno en un hilo propio,
+// fuera del pool de los handlers, y se consultan por id mientras corren.
+// Un trabajo recibe un indicador de cancelación que debe revisar entre
+// etapas; si lanza una excepción queda en FAILED con su mensaje.
+class JobScheduler {
+public:
+    enum class Status { QUEUED, RUNNING, SUCCEEDED, FAILED, CANCELLED };
+
+    struct JobInfo {
+        std::string id;
+        std::string name;
+        Status status;
+        time_t createdAt;
+        time_t startedAt;     // 0 mientras está en cola
+        time_t finishedAt;    // 0 hasta que termina
+        std::string message;  // Resultado o error
+    };
+
+    // Devuelve el mensaje de resultado
+    using JobFunction = std::function<std::string(const std::atomic<bool>& cancelled)>;
+
+    explicit JobScheduler(size_t maxFinishedJobs = 256);
+    ~JobScheduler();
+
+    std::string submit(const std::string& name, JobFunction job);
+
+    // Un trabajo en cola se cancela en el acto; uno en curso se marca y se
+    // detiene cuando revise el indicador. false si no existe o ya terminó.
+    bool cancel(const std::string& id);
+
+    bool getJob(const std::string& id, JobInfo& out);
+    std::vector<JobInfo> listJobs();
+
+    // Encola el trabajo cada intervalSeconds; se omite una ejecución si la
+    // anterior del mismo nombre sigue en cola o en curso
+    void schedulePeriodic(const std::string& name, int intervalSeconds, JobFunction job);
+
+    // Cancela lo pendiente y espera al trabajo en curso
+    void shutdown();
+
+    static const char* statusName(Status status);
+
+private:
+    struct Job {
+        JobInfo info;
+        JobFunction function;
+        std::atomic<bool> cancelled{false};
+    };
+
+    struct Periodic {
+        std::string name;
+        std::chrono::seconds interval;
+        std::chrono::steady_clock::time_point nextRun;
+        JobFunction function;
+    };
+
+    std::string enqueue(const std::string& name, JobFunction function);
+    bool isActive(const std::string& name) const;
+    void finish(const std::shared_ptr<Job>& job, Status status, const std::string& message);
+    void runLoop();
+
+    std::map<std::string, std::shared_ptr<Job>> jobs;
+    std::deque<std::shared_ptr<Job>> pending;
+    std::deque<std::string> finishedOrder;
+    std::vector<Periodic> periodics;
+    size_t maxFinishedJobs;
+    unsigned long long nextId;
+
+    std::mutex jobsMutex;
+    std::condition_variable jobsSignal;
+    bool running;
+    std::thread runner;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// Pool acotado de hilos para el trabajo bloqueante de los handlers (SQLite,
+// OCR, TTS), separado de los hilos de E/S de Crow. La cola tiene capacidad
+// fija: si está llena, submit() rechaza el trabajo en lugar de acumularlo.
+// Un trabajo que espera en cola más de timeoutMs no se ejecuta; se llama a
+// su onTimeout para que el handler responda con un error.
+class WorkerPool {
+public:
+    WorkerPool(size_t threads, size_t queueCapacity, int timeoutMs);
+    ~WorkerPool();
+
+    // Encola un trabajo; false si la cola está llena o el pool se detuvo
+    bool submit(std::function<void()> work, std::function<void()> onTimeout);
+
+    // Deja de aceptar trabajo, cancela lo encolado y espera a los hilos
+    void shutdown();
+
+    size_t threadCount() const { return workers.size(); }
+    size_t queued();
+
+private:
+    struct Job {
+        std::function<void()> work;
+        std::function<void()> onTimeout;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsSignal;
+    size_t queueCapacity;
+    int timeoutMs;
+    std::atomic<bool> running;
+};
@@ -0,0 +1,209 @@
+#include "job_scheduler.h"
+#include <iostream>
+
+JobScheduler::JobScheduler(size_t maxFinishedJobs)
+    : maxFinishedJobs(maxFinishedJobs > 0 ? maxFinishedJobs : 1), nextId(1), running(true) {
+    runner = std::thread(&JobScheduler::runLoop, this);
+}
+
+JobScheduler::~JobScheduler() {
+    shutdown();
+}
+
+const char* JobScheduler::statusName(Status status) {
+    switch (status) {
+        case Status::QUEUED: return "queued";
+        case Status::RUNNING: return "running";
+        case Status::SUCCEEDED: return "succeeded";
+        case Status::FAILED: return "failed";
+        case Status::CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+std::string JobScheduler::submit(const std::string& name, JobFunction job) {
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (!running) {
+            return "";
+        }
+        id = enqueue(name, std::move(job));
+    }
+    jobsSignal.notify_all();
+    return id;
+}
+
+std::string JobScheduler::enqueue(const std::string& name, JobFunction function) {
+    auto job = std::make_shared<Job>();
+    job->info.id = std::to_string(nextId++);
+    job->info.name = name;
+    job->info.status = Status::QUEUED;
+    job->info.createdAt = time(nullptr);
+    job->info.startedAt = 0;
+    job->info.finishedAt = 0;
+    job->function = std::move(function);
+
+    jobs[job->info.id] = job;
+    pending.push_back(job);
+    return job->info.id;
+}
+
+bool JobScheduler::cancel(const std::string& id) {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+
+    auto job = it->second;
+    if (job->info.status == Status::QUEUED) {
+        for (auto queued = pending.begin(); queued != pending.end(); ++queued) {
+            if (*queued == job) {
+                pending.erase(queued);
+                break;
+            }
+        }
+        finish(job, Status::CANCELLED, "Cancelled before start");
+        return true;
+    }
+    if (job->info.status == Status::RUNNING) {
+        job->cancelled = true;
+        return true;
+    }
+    return false;
+}
+
+bool JobScheduler::getJob(const std::string& id, JobInfo& out) {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    out = it->second->info;
+    return true;
+}
+
+std::vector<JobScheduler::JobInfo> JobScheduler::listJobs() {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+
+    std::vector<JobInfo> result;
+    result.reserve(jobs.size());
+    for (const auto& entry : jobs) {
+        result.push_back(entry.second->info);
+    }
+    return result;
+}
+
+void JobScheduler::schedulePeriodic(const std::string& name, int intervalSeconds, JobFunction job) {
+    if (intervalSeconds <= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto interval = std::chrono::seconds(intervalSeconds);
+        periodics.push_back({name, interval, std::chrono::steady_clock::now() + interval, std::move(job)});
+    }
+    jobsSignal.notify_all();
+}
+
+void JobScheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+
+        for (auto& job : pending) {
+            finish(job, Status::CANCELLED, "Scheduler stopped");
+        }
+        pending.clear();
+        for (auto& entry : jobs) {
+            if (entry.second->info.status == Status::RUNNING) {
+                entry.second->cancelled = true;
+            }
+        }
+    }
+    jobsSignal.notify_all();
+
+    if (runner.joinable()) {
+        runner.join();
+    }
+}
+
+bool JobScheduler::isActive(const std::string& name) const {
+    for (const auto& entry : jobs) {
+        const JobInfo& info = entry.second->info;
+        if (info.name == name && (info.status == Status::QUEUED || info.status == Status::RUNNING)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobScheduler::finish(const std::shared_ptr<Job>& job, Status status, const std::string& message) {
+    job->info.status = status;
+    job->info.finishedAt = time(nullptr);
+    job->info.message = message;
+    job->function = nullptr;
+
+    // Conservar solo el historial más reciente
+    finishedOrder.push_back(job->info.id);
+    while (finishedOrder.size() > maxFinishedJobs) {
+        jobs.erase(finishedOrder.front());
+        finishedOrder.pop_front();
+    }
+}
+
+void JobScheduler::runLoop() {
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    while (running) {
+        // Encolar las ejecuciones periódicas vencidas
+        auto now = std::chrono::steady_clock::now();
+        auto wakeUp = std::chrono::steady_clock::time_point::max();
+        for (auto& periodic : periodics) {
+            if (periodic.nextRun <= now) {
+                if (!isActive(periodic.name)) {
+                    enqueue(periodic.name, periodic.function);
+                }
+                periodic.nextRun = now + periodic.interval;
+            }
+            wakeUp = std::min(wakeUp, periodic.nextRun);
+        }
+
+        if (pending.empty()) {
+            if (wakeUp == std::chrono::steady_clock::time_point::max()) {
+                jobsSignal.wait(lock);
+            } else {
+                jobsSignal.wait_until(lock, wakeUp);
+            }
+            continue;
+        }
+
+        auto job = pending.front();
+        pending.pop_front();
+        job->info.status = Status::RUNNING;
+        job->info.startedAt = time(nullptr);
+        JobFunction function = job->function;
+
+        lock.unlock();
+        Status status = Status::SUCCEEDED;
+        std::string message;
+        try {
+            message = function(job->cancelled);
+            if (job->cancelled) {
+                status = Status::CANCELLED;
+            }
+        } catch (const std::exception& e) {
+            status = Status::FAILED;
+            message = e.what();
+            std::cerr << "Error en el trabajo " << job->info.name << " (" << job->info.id << "): " << e.what() << std::endl;
+        }
+        lock.lock();
+
+        finish(job, status, message);
+    }
+}
@@ -3,23 +3,85 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 #include <crow.h>
 #include <nlohmann/json.hpp>
 #include "auth_service.h"
+#include "sqlite_pool.h"
+#include "quota_engine.h"
+#include "token_cache.h"
+#include "api_key_cache.h"
 #include "ia_migrante_client.h"
+#include "worker_pool.h"
+#include "job_scheduler.h"
 #include "ocr_client.h"
+#include "tesseract_pool.h"
+#include "ocr_cache.h"
 #include "tts_client.h"
 #include "learning_engine.h"
+#include "metrics.h"
+#include "http_client.h"
+#include "template_engine.h"
+#include "document_service_client.h"
+#include "task_pool.h"
+#include "base64.h"
+#include "multipart.h"
 
 using json = nlohmann::json;
 
 // Variables globales para configuración
+std::string serverHost = "0.0.0.0";
+int serverPort = 8080;
+int serverThreads = 0;          // Hilos de E/S de Crow; 0 = uno por núcleo
+int serverTimeoutMs = 30000;
+int workerThreads = 0;          // Pool para handlers bloqueantes; 0 = dos por núcleo
+int workerQueueSize = 1024;
+int taskThreads = 0;            // Paralelismo dentro de una petición (lotes); 0 = uno por núcleo
 std::string dbPath = "data/iam_database.db";
+int dbPoolSize = 0;  // 0 = un slot por núcleo
 std::string jwtSecret = "iam_secret_key_change_in_production";
 int tokenExpiryHours = 24;
+int jwtCacheEntries = 65536;
 std::string apiKeyPrefix = "iam_";
+int quotaFlushIntervalMs = 1000;
+int apiKeyCacheTtlSeconds = 60;
+int apiKeyLastUsedFlushMs = 5000;
 std::string knowledgeBasePath = "ia_migrante_engine/data";
+int knowledgeReloadIntervalSeconds = 30;
+int maxCacheEntries = 10000;
+std::string queryHashMode = "sha256";
+bool learningEnabled = true;
+int learningUpdateIntervalHours = 24;  // 0 = solo bajo demanda
+int learningEventQueueSize = 8192;
+std::string openaiBridgeUrl = "http://localhost:5000";
+HttpClient::Options openaiBridgeHttp;
+std::string documentServiceUrl = "http://localhost:5001";
+HttpClient::Options documentServiceHttp;
+int httpMaxIdleHandles = 32;
+std::string documentTemplatesPath = "document_service/templates";
+std::string documentTemplatesCatalog = "";   // Vacío = parsear los JSON al arrancar
+int documentCacheMaxMb = 64;
+int documentCacheTtlSeconds = 3600;
+std::string documentCacheSpillPath = "";
+int documentCacheSpillMaxMb = 0;
+int documentBatchMaxItems = 500;
+std::string ocrModelsPath = "";          // Vacío = TESSDATA_PREFIX o la ruta del sistema
+std::string ocrLanguage = "eng+spa";
+int ocrEngines = 0;                      // Motores Tesseract precargados; 0 = uno por núcleo
+std::string ocrFieldRulesPath = "legal_ocr_service/data/field_rules.json";
+bool ocrCacheEnabled = true;
+int ocrCacheTtlDays = 30;                // 0 = sin caducidad
+int ocrCacheMaxEntries = 100000;         // 0 = sin límite
+bool ocrCacheHitsCountQuota = true;      // Un resultado servido desde la caché consume cuota
+int ocrMaxFileSizeMb = 10;               // Tamaño máximo del archivo decodificado
+std::shared_ptr<OCRCache> ocrCache;
+std::unique_ptr<DocumentServiceClient> documentClient;
 std::shared_ptr<LearningEngine> learningEngine;
+KnowledgeBase* knowledgeBase = nullptr;   // Resuelta una vez al arrancar
 
 // Función para cargar la configuración
 bool loadConfig(const std::string& configPath) {
@@ -34,8 +96,37 @@ bool loadConfig(const std::string& configPath) {
         json config;
         configFile >> config;
         
-        if (config.contains("database") && config["database"].contains("path")) {
-            dbPath = config["database"]["path"];
+        if (config.contains("server")) {
+            if (config["server"].contains("host")) {
+                serverHost = config["server"]["host"];
+            }
+            if (config["server"].contains("port")) {
+                serverPort = config["server"]["port"];
+            }
+            if (config["server"].contains("threads")) {
+                serverThreads = config["server"]["threads"];
+            }
+            if (config["server"].contains("timeout_ms")) {
+                serverTimeoutMs = config["server"]["timeout_ms"];
+            }
+            if (config["server"].contains("worker_threads")) {
+                workerThreads = config["server"]["worker_threads"];
+            }
+            if (config["server"].contains("worker_queue_size")) {
+                workerQueueSize = config["server"]["worker_queue_size"];
+            }
+            if (config["server"].contains("task_threads")) {
+                taskThreads = config["server"]["task_threads"];
+            }
+        }
+        
+        if (config.contains("database")) {
+            if (config["database"].contains("path")) {
+                dbPath = config["database"]["path"];
+            }
+            if (config["database"].contains("pool_size")) {
+                dbPoolSize = config["database"]["pool_size"];
+            }
         }
         
         if (config.contains("auth")) {
@@ -45,13 +136,127 @@ bool loadConfig(const std::string& configPath) {
             if (config["auth"].contains("token_expiry_hours")) {
                 tokenExpiryHours = config["auth"]["token_expiry_hours"];
             }
+            if (config["auth"].contains("jwt_cache_entries")) {
+                jwtCacheEntries = config["auth"]["jwt_cache_entries"];
+            }
             if (config["auth"].contains("api_key_prefix")) {
                 apiKeyPrefix = config["auth"]["api_key_prefix"];
             }
+            if (config["auth"].contains("quota_flush_interval_ms")) {
+                quotaFlushIntervalMs = config["auth"]["quota_flush_interval_ms"];
+            }
+            if (config["auth"].contains("api_key_cache_ttl_seconds")) {
+                apiKeyCacheTtlSeconds = config["auth"]["api_key_cache_ttl_seconds"];
+            }
+            if (config["auth"].contains("api_key_last_used_flush_ms")) {
+                apiKeyLastUsedFlushMs = config["auth"]["api_key_last_used_flush_ms"];
+            }
+        }
+        
+        if (config.contains("learning")) {
+            if (config["learning"].contains("enabled")) {
+                learningEnabled = config["learning"]["enabled"];
+            }
+            if (config["learning"].contains("update_interval_hours")) {
+                learningUpdateIntervalHours = config["learning"]["update_interval_hours"];
+            }
+            if (config["learning"].contains("query_hash")) {
+                queryHashMode = config["learning"]["query_hash"];
+            }
+            if (config["learning"].contains("event_queue_size")) {
+                learningEventQueueSize = config["learning"]["event_queue_size"];
+            }
+        }
+        
+        if (config.contains("ia_migrante")) {
+            if (config["ia_migrante"].contains("knowledge_base_path")) {
+                knowledgeBasePath = config["ia_migrante"]["knowledge_base_path"];
+            }
+            if (config["ia_migrante"].contains("max_cache_entries")) {
+                maxCacheEntries = config["ia_migrante"]["max_cache_entries"];
+            }
+            if (config["ia_migrante"].contains("knowledge_reload_interval_seconds")) {
+                knowledgeReloadIntervalSeconds = config["ia_migrante"]["knowledge_reload_interval_seconds"];
+            }
         }
         
-        if (config.contains("ia_migrante") && config["ia_migrante"].contains("knowledge_base_path")) {
-            knowledgeBasePath = config["ia_migrante"]["knowledge_base_path"];
+        // Timeouts y reintentos por endpoint para el cliente HTTP compartido
+        auto loadEndpoint = [&config](const std::string& section, std::string& url, HttpClient::Options& options) {
+            if (!config.contains(section)) {
+                return;
+            }
+            if (config[section].contains("url")) {
+                url = config[section]["url"];
+            }
+            if (config[section].contains("timeout_ms")) {
+                options.timeoutMs = config[section]["timeout_ms"];
+            }
+            if (config[section].contains("connect_timeout_ms")) {
+                options.connectTimeoutMs = config[section]["connect_timeout_ms"];
+            }
+            if (config[section].contains("retry_attempts")) {
+                options.retryAttempts = config[section]["retry_attempts"];
+            }
+            if (config[section].contains("retry_backoff_ms")) {
+                options.retryBackoffMs = config[section]["retry_backoff_ms"];
+            }
+        };
+        loadEndpoint("openai_bridge", openaiBridgeUrl, openaiBridgeHttp);
+        loadEndpoint("document_service", documentServiceUrl, documentServiceHttp);
+        if (config.contains("document_service")) {
+            if (config["document_service"].contains("templates_path")) {
+                documentTemplatesPath = config["document_service"]["templates_path"];
+            }
+            if (config["document_service"].contains("templates_catalog")) {
+                documentTemplatesCatalog = config["document_service"]["templates_catalog"];
+            }
+            if (config["document_service"].contains("batch_max_items")) {
+                documentBatchMaxItems = config["document_service"]["batch_max_items"];
+            }
+            if (config["document_service"].contains("cache_max_mb")) {
+                documentCacheMaxMb = config["document_service"]["cache_max_mb"];
+            }
+            if (config["document_service"].contains("cache_ttl_seconds")) {
+                documentCacheTtlSeconds = config["document_service"]["cache_ttl_seconds"];
+            }
+            if (config["document_service"].contains("spill_path")) {
+                documentCacheSpillPath = config["document_service"]["spill_path"];
+            }
+            if (config["document_service"].contains("spill_max_mb")) {
+                documentCacheSpillMaxMb = config["document_service"]["spill_max_mb"];
+            }
+        }
+        if (config.contains("ocr_service")) {
+            if (config["ocr_service"].contains("models_path")) {
+                ocrModelsPath = config["ocr_service"]["models_path"];
+            }
+            if (config["ocr_service"].contains("language")) {
+                ocrLanguage = config["ocr_service"]["language"];
+            }
+            if (config["ocr_service"].contains("engines")) {
+                ocrEngines = config["ocr_service"]["engines"];
+            }
+            if (config["ocr_service"].contains("field_rules_path")) {
+                ocrFieldRulesPath = config["ocr_service"]["field_rules_path"];
+            }
+            if (config["ocr_service"].contains("cache_enabled")) {
+                ocrCacheEnabled = config["ocr_service"]["cache_enabled"];
+            }
+            if (config["ocr_service"].contains("cache_ttl_days")) {
+                ocrCacheTtlDays = config["ocr_service"]["cache_ttl_days"];
+            }
+            if (config["ocr_service"].contains("cache_max_entries")) {
+                ocrCacheMaxEntries = config["ocr_service"]["cache_max_entries"];
+            }
+            if (config["ocr_service"].contains("cache_hits_count_quota")) {
+                ocrCacheHitsCountQuota = config["ocr_service"]["cache_hits_count_quota"];
+            }
+            if (config["ocr_service"].contains("max_file_size_mb")) {
+                ocrMaxFileSizeMb = config["ocr_service"]["max_file_size_mb"];
+            }
+        }
+        if (config.contains("http_client") && config["http_client"].contains("max_idle_handles")) {
+            httpMaxIdleHandles = config["http_client"]["max_idle_handles"];
         }
         
         return true;
@@ -61,6 +266,26 @@ bool loadConfig(const std::string& configPath) {
     }
 }
 
+// Middleware de métricas: latencia y código de estado por ruta. Va primero en
+// la lista para medir también la autenticación; con los handlers asíncronos
+// after_handle se ejecuta al llamar a res.end(), así que incluye la cola del pool.
+struct MetricsMiddleware {
+    struct Context {
+        std::chrono::steady_clock::time_point start;
+    };
+    
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, Context& ctx) {
+        ctx.start = std::chrono::steady_clock::now();
+    }
+    
+    void after_handle(crow::request& req, crow::response& res, Context& ctx) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ctx.start);
+        std::string route = Metrics::routeLabel(crow::method_name(req.method), req.url);
+        Metrics::request(route).record(static_cast<uint64_t>(elapsed.count()));
+        Metrics::requestCount(route, res.code).add();
+    }
+};
+
 // Middleware para autenticación
 struct AuthMiddleware {
     struct Context {
@@ -69,6 +294,9 @@ struct AuthMiddleware {
     };
     
     void before_handle(crow::request& req, crow::response& res, Context& ctx) {
+        static LatencyHistogram& authStage = Metrics::stage("auth");
+        Metrics::ScopedTimer timer(authStage);
+        
         // Verificar token JWT
         std::string authHeader = req.get_header_value("Authorization");
         if (!authHeader.empty() && authHeader.substr(0, 7) == "Bearer ") {
@@ -95,10 +323,370 @@ struct AuthMiddleware {
     }
     
     void after_handle(crow::request& /*req*/, crow::response& /*res*/, Context& /*ctx*/) {
-        // Podemos agregar logging o acciones post-procesamiento aquí
+        // Las métricas por ruta se registran en MetricsMiddleware
+    }
+};
+
+// Autenticación con usuario y contraseña (consulta SQLite, se ejecuta en el pool)
+static crow::response handleTokenRequest(const crow::request& req) {
+    try {
+        auto params = crow::json::load(req.body);
+        if (!params) {
+            return crow::response(400, "{\"error\":\"Invalid JSON\"}");
+        }
+        
+        std::string username = params["username"].s();
+        std::string password = params["password"].s();
+        
+        AuthService::UserInfo user;
+        if (AuthService::authenticateUser(username, password, dbPath, user)) {
+            std::string token = AuthService::generateJWT(user, jwtSecret, tokenExpiryHours);
+            
+            json response;
+            response["token"] = token;
+            response["user_id"] = user.id;
+            response["username"] = user.username;
+            response["subscription_tier"] = user.subscriptionTier;
+            
+            return crow::response(200, response.dump());
+        } else {
+            return crow::response(401, "{\"error\":\"Invalid credentials\"}");
+        }
+    } catch (const std::exception& e) {
+        return crow::response(500, json{{"error", e.what()}}.dump());
+    }
+}
+
+// Trabajo de actualización incremental de patrones para JobScheduler
+static std::string runPatternUpdate(const std::atomic<bool>& cancelled) {
+    if (!learningEngine) {
+        throw std::runtime_error("Learning engine is not available");
+    }
+
+    auto result = learningEngine->updatePatterns(&cancelled);
+
+    json summary;
+    summary["feedback_processed"] = result.feedbackProcessed;
+    summary["queries_considered"] = result.queriesConsidered;
+    summary["patterns_learned"] = result.patternsLearned;
+    summary["cancelled"] = result.cancelled;
+    return summary.dump();
+}
+
+static std::string runOcrCachePrune(const std::atomic<bool>& /*cancelled*/) {
+    json summary;
+    summary["removed"] = ocrCache->prune();
+    return summary.dump();
+}
+
+static json jobToJson(const JobScheduler::JobInfo& job) {
+    json info;
+    info["id"] = job.id;
+    info["name"] = job.name;
+    info["status"] = JobScheduler::statusName(job.status);
+    info["created_at"] = job.createdAt;
+    info["started_at"] = job.startedAt;
+    info["finished_at"] = job.finishedAt;
+    info["message"] = job.message;
+    return info;
+}
+
+// Ejecuta un handler bloqueante en el pool de trabajo y completa la respuesta
+// desde allí, para no ocupar los hilos de E/S de Crow (p. ej. /health)
+static void offload(WorkerPool& workers, crow::response& res, std::function<void()> work) {
+    bool accepted = workers.submit(
+        [&res, work]() {
+            try {
+                work();
+            } catch (const std::exception& e) {
+                // replace: un what() con UTF-8 inválido no debe lanzar aquí
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump(-1, ' ', false, json::error_handler_t::replace);
+            } catch (...) {
+                // Cualquier otra excepción también responde: la conexión no queda colgada
+                res.code = 500;
+                res.body = "{\"error\":\"Internal server error\"}";
+            }
+            res.end();
+        },
+        [&res]() {
+            res.code = 503;
+            res.body = "{\"error\":\"Request timed out waiting for a worker\"}";
+            res.end();
+        });
+    
+    if (!accepted) {
+        res.code = 503;
+        res.body = "{\"error\":\"Server busy, try again later\"}";
+        res.end();
+    }
+}
+
+// Resultado de generar un documento (petición individual o elemento de un lote)
+struct GeneratedDocument {
+    int status = 200;
+    std::string error;
+    std::string contentType;
+    std::string filename;    // Para Content-Disposition: plantilla verificada + extensión permitida
+    std::string body;        // Formatos de texto
+    DocumentCache::Buffer data;   // Formatos binarios: el búfer de la caché, sin copiar
+};
+
+// Margen sobre max_file_size_mb para las cabeceras de multipart y el resto del JSON
+static const size_t MULTIPART_HEADROOM = 64 * 1024;
+
+static size_t ocrMaxFileBytes() {
+    return static_cast<size_t>(ocrMaxFileSizeMb) * 1024 * 1024;
+}
+
+// Formato OCR a partir de un Content-Type (image/png...) o, si no lo
+// identifica, de la extensión del nombre de archivo. Vacío si no se reconoce.
+static std::string ocrFormatFor(std::string_view contentType, std::string_view filename) {
+    std::string type(contentType.substr(0, contentType.find(';')));
+    type.erase(std::remove(type.begin(), type.end(), ' '), type.end());
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    if (type == "image/png") {
+        return "png";
+    }
+    if (type == "image/jpeg" || type == "image/jpg") {
+        return "jpg";
+    }
+    if (type == "image/tiff") {
+        return "tiff";
+    }
+    
+    size_t dot = filename.rfind('.');
+    if (dot == std::string_view::npos) {
+        return "";
+    }
+    std::string extension(filename.substr(dot + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return OCRClient::isSupportedFormat(extension) ? extension : "";
+}
+
+// Reconoce fileData y escribe la respuesta del OCR (JSON, o NDJSON por páginas
+// con Accept: application/x-ndjson). La cuota se cobra aquí, después de
+// consultar la caché, según ocr_service.cache_hits_count_quota.
+static void recognizeDocument(const crow::request& req, crow::response& res, int userId,
+                              std::string_view fileData, const std::string& fileType) {
+    // Con Accept: application/x-ndjson cada página sale como una línea al
+    // terminar (en orden de terminación) y el resultado completo al final
+    bool pageLines = req.get_header_value("Accept").find("application/x-ndjson") != std::string::npos;
+    std::string lines;
+    OCRClient::PageCallback onPage;
+    if (pageLines) {
+        onPage = [&lines](const OCRClient::PageResult& page) {
+            json line;
+            line["page"] = page.index + 1;
+            if (!page.error.empty()) {
+                line["error"] = page.error;
+            } else {
+                line["text"] = page.text;
+                line["confidence"] = page.confidence;
+            }
+            lines += line.dump();
+            lines += '\n';
+        };
+    }
+    
+    // Un acierto en la caché se cobra o no según ocr_service.cache_hits_count_quota
+    OCRClient::OCRResult result;
+    bool cached = OCRClient::cachedResult(fileData, fileType, result);
+    if ((!cached || ocrCacheHitsCountQuota) &&
+        !AuthService::checkQuotaAndUpdate(userId, "ocr", dbPath)) {
+        res.code = 429;
+        res.body = "{\"error\":\"Quota exceeded for OCR\"}";
+        return;
+    }
+    
+    if (!cached) {
+        result = OCRClient::processDocument(fileData, fileType, onPage);
+    } else if (onPage) {
+        for (size_t i = 0; i < result.pages.size(); i++) {
+            OCRClient::PageResult page;
+            page.index = i;
+            page.text = result.pages[i];
+            page.confidence = result.pageConfidences[i];
+            onPage(page);
+        }
     }
+    if (!result.error.empty()) {
+        json error;
+        error["error"] = result.error;
+        res.code = 422;
+        res.body = error.dump();
+        return;
+    }
+    
+    json response;
+    response["text"] = result.fullText;
+    response["confidence"] = result.confidence;
+    response["pages"] = result.pages.size();
+    response["page_confidence"] = result.pageConfidences;
+    
+    response["document_type"] = result.documentType;
+    response["cached"] = result.cached;
+    
+    if (!result.fields.empty()) {
+        json fields = json::object();
+        json details = json::array();
+        for (const auto& field : result.fields) {
+            fields[field.name] = field.value;
+            details.push_back({{"name", field.name}, {"value", field.value}, {"page", field.page + 1},
+                               {"offset", field.offset}, {"confidence", field.confidence}});
+        }
+        response["fields"] = fields;
+        response["field_details"] = details;
+    }
+    
+    if (pageLines) {
+        lines += json{{"result", response}}.dump();
+        lines += '\n';
+        res.code = 200;
+        res.set_header("Content-Type", "application/x-ndjson");
+        res.body = std::move(lines);
+        return;
+    }
+    
+    res.code = 200;
+    res.body = response.dump();
+}
+
+// Nombre de archivo seguro para una cabecera: letras, dígitos, '-' y '_'
+static std::string attachmentName(const std::string& templateId) {
+    std::string name;
+    for (unsigned char c : templateId) {
+        name += (std::isalnum(c) || c == '-' || c == '_') ? static_cast<char>(c) : '_';
+    }
+    return name.empty() ? "document" : name;
+}
+
+// Solicitud de documento ya validada
+struct DocumentSpec {
+    std::string outputFormat;
+    json parameters;
+    std::shared_ptr<const DocumentTemplate> document;
 };
 
+// Valida {document_type, parameters, output_format}: plantilla conocida y
+// formato permitido. Si no es válida deja el error (400/404) en result.
+static bool parseDocumentRequest(const json& params, DocumentSpec& spec, GeneratedDocument& result) {
+    if (!params.is_object() || !params.contains("document_type") || !params["document_type"].is_string()) {
+        result.status = 400;
+        result.error = "Missing document_type";
+        return false;
+    }
+    
+    std::string documentType = params["document_type"];
+    std::string& outputFormat = spec.outputFormat;
+    outputFormat = "txt";
+    if (params.contains("output_format")) {
+        if (!params["output_format"].is_string()) {
+            result.status = 400;
+            result.error = "Unsupported output_format";
+            return false;
+        }
+        outputFormat = params["output_format"];
+    }
+    spec.parameters = params.contains("parameters") ? params["parameters"] : json::object();
+    
+    // Solo formatos conocidos: la extensión acaba en la cabecera Content-Disposition
+    std::string extension;
+    if (outputFormat == "txt" || outputFormat == "text") {
+        extension = "txt";
+    } else if (outputFormat == "pdf" || outputFormat == "docx") {
+        extension = outputFormat;
+    } else if (outputFormat != "json") {
+        result.status = 400;
+        result.error = "Unsupported output_format";
+        return false;
+    }
+    
+    // También los binarios: el servicio de documentos solo recibe plantillas conocidas
+    spec.document = TemplateEngine::forPath(documentTemplatesPath).find(documentType);
+    if (!spec.document) {
+        result.status = 404;
+        result.error = "Unknown document type";
+        return false;
+    }
+    if (!extension.empty()) {
+        result.filename = attachmentName(spec.document->id) + "." + extension;
+    }
+    return true;
+}
+
+// Primera fase de generateDocument, sobre una solicitud ya validada: cobra la
+// cuota y renderiza en proceso los formatos de texto. Si chargeQuota devuelve
+// false el resultado es 429. Devuelve true si el documento es binario (PDF,
+// DOCX) y queda pendiente del servicio de documentos con la solicitud en remote.
+static bool prepareDocument(DocumentSpec& spec, const std::function<bool()>& chargeQuota,
+                            GeneratedDocument& result, DocumentServiceClient::DocumentRequest& remote) {
+    const DocumentTemplate& document = *spec.document;
+    bool nativeFormat = spec.outputFormat != "pdf" && spec.outputFormat != "docx";
+    
+    if (!chargeQuota()) {
+        result.status = 429;
+        result.error = "Quota exceeded for documents";
+        return false;
+    }
+    
+    try {
+        if (nativeFormat) {
+            static LatencyHistogram& renderLatency = Metrics::stage("document_render");
+            Metrics::ScopedTimer timer(renderLatency);
+            
+            auto rendered = TemplateEngine::forPath(documentTemplatesPath).renderText(document, spec.parameters);
+            if (spec.outputFormat == "json") {
+                json response;
+                response["document_type"] = document.id;
+                response["name"] = document.name;
+                response["text"] = std::move(rendered.text);
+                response["missing_fields"] = rendered.missingFields;
+                result.contentType = "application/json";
+                result.body = response.dump();
+            } else {
+                result.contentType = "text/plain; charset=utf-8";
+                result.body = std::move(rendered.text);
+            }
+            return false;
+        }
+    } catch (const std::exception& e) {
+        result.status = 500;
+        result.error = e.what();
+        return false;
+    }
+    
+    // PDF, DOCX y demás formatos binarios: servicio de documentos
+    remote.documentType = document.id;
+    remote.parameters = std::move(spec.parameters);
+    remote.outputFormat = spec.outputFormat;
+    return true;
+}
+
+// Segunda fase: la respuesta del servicio de documentos
+static void completeDocument(GeneratedDocument& result, const DocumentServiceClient::DocumentResponse& response) {
+    if (!response.success || !response.documentData) {
+        result.status = 502;
+        result.error = response.message;
+        result.filename.clear();
+        return;
+    }
+    result.contentType = response.contentType.empty() ? "application/octet-stream" : response.contentType;
+    result.data = response.documentData;
+}
+
+// Genera un documento: los formatos de texto se renderizan en proceso y los
+// binarios se piden al servicio de documentos
+static GeneratedDocument generateDocument(const json& params, const std::function<bool()>& chargeQuota) {
+    GeneratedDocument result;
+    DocumentSpec spec;
+    DocumentServiceClient::DocumentRequest remote;
+    if (parseDocumentRequest(params, spec, result) && prepareDocument(spec, chargeQuota, result, remote)) {
+        completeDocument(result, documentClient->generateDocument(remote));
+    }
+    return result;
+}
+
 int main() {
     std::cout << "Iniciando API IA Migrante..." << std::endl;
     
@@ -108,17 +696,94 @@ int main() {
         std::cout << "Usando configuración por defecto" << std::endl;
     }
     
+    // Pool de conexiones compartido por el servicio de autenticación
+    SQLitePool::configure(dbPath, dbPoolSize);
+    
+    // Caché de tokens JWT ya verificados
+    TokenCache::instance().setCapacity(jwtCacheEntries);
+    
+    // Motor de cuotas en memoria (siembra los contadores desde usage_records)
+    try {
+        QuotaEngine::configure(dbPath, quotaFlushIntervalMs);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al inicializar el motor de cuotas: " << e.what() << std::endl;
+    }
+    
+    // Caché de API keys con escritura diferida de last_used
+    try {
+        ApiKeyCache::configure(dbPath, apiKeyCacheTtlSeconds, apiKeyLastUsedFlushMs);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al inicializar la caché de API keys: " << e.what() << std::endl;
+    }
+    
+    // Cliente HTTP compartido hacia los servicios auxiliares
+    HttpClient::setMaxIdleHandles(httpMaxIdleHandles);
+    HttpClient::configure(openaiBridgeUrl, openaiBridgeHttp);
+    HttpClient::configure(documentServiceUrl, documentServiceHttp);
+    
+    // Plantillas de documentos en proceso; el servicio externo queda para PDF/DOCX
+    TemplateEngine::configure(documentTemplatesPath, documentTemplatesCatalog);
+    documentClient = std::make_unique<DocumentServiceClient>(
+        documentServiceUrl, static_cast<size_t>(documentCacheMaxMb) * 1024 * 1024, documentCacheTtlSeconds,
+        documentCacheSpillPath, static_cast<size_t>(documentCacheSpillMaxMb) * 1024 * 1024);
+    documentClient->setLocalTemplates(documentTemplatesPath);
+    
+    // Motores OCR: los modelos se cargan una vez aquí y no en cada petición
+    TesseractPool::configure(ocrModelsPath, ocrLanguage, ocrEngines);
+    OCRClient::setFieldRules(ocrFieldRulesPath);
+    if (ocrCacheEnabled) {
+        ocrCache = std::make_shared<OCRCache>(dbPath, ocrCacheTtlDays * 86400, static_cast<size_t>(ocrCacheMaxEntries));
+        OCRClient::setCache(ocrCache);
+    }
+    
+    // Base de conocimiento con recarga automática al cambiar knowledge_*.json
+    KnowledgeBase::configure(knowledgeBasePath, knowledgeReloadIntervalSeconds);
+    knowledgeBase = &KnowledgeBase::forPath(knowledgeBasePath);
+    
     // Inicializar el motor de aprendizaje
     try {
-        learningEngine = std::make_shared<LearningEngine>(dbPath);
+        learningEngine = std::make_shared<LearningEngine>(dbPath, maxCacheEntries,
+                                                          QueryNormalizer::hashModeFromString(queryHashMode),
+                                                          learningEventQueueSize,
+                                                          []() { return knowledgeBase->dictionary(); });
         std::cout << "Motor de aprendizaje inicializado correctamente" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Error al inicializar el motor de aprendizaje: " << e.what() << std::endl;
         std::cout << "Continuando sin el motor de aprendizaje" << std::endl;
     }
     
+    // Pool acotado para el trabajo bloqueante; la espera en cola está limitada por timeout_ms
+    size_t workerCount = workerThreads > 0 ? workerThreads : 2 * std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool workers(workerCount, workerQueueSize, serverTimeoutMs);
+    
+    // Hilos para repartir el trabajo de una misma petición (lotes de documentos)
+    TaskPool::configure(taskThreads);
+    
+    // Trabajos de mantenimiento en segundo plano
+    JobScheduler jobs;
+    if (learningEngine && learningEnabled && learningUpdateIntervalHours > 0) {
+        jobs.schedulePeriodic("update-patterns", learningUpdateIntervalHours * 3600, runPatternUpdate);
+    }
+    if (ocrCache) {
+        jobs.schedulePeriodic("prune-ocr-cache", 3600, runOcrCachePrune);
+    }
+    
     // Configurar el servidor Crow
-    crow::App<crow::CORSHandler, AuthMiddleware> app;
+    crow::App<MetricsMiddleware, crow::CORSHandler, AuthMiddleware> app;
+    
+    // Medidores leídos al exportar /metrics
+    Metrics::gauge("iam_worker_queue_depth", "Trabajos en cola del pool de handlers",
+                   [&workers]() { return static_cast<double>(workers.queued()); });
+    Metrics::gauge("iam_worker_threads", "Hilos del pool de handlers",
+                   [&workers]() { return static_cast<double>(workers.threadCount()); });
+    Metrics::gauge("iam_ocr_cache_hits", "Documentos servidos desde la caché de OCR",
+                   []() { return ocrCache ? static_cast<double>(ocrCache->stats().hits) : 0.0; });
+    Metrics::gauge("iam_ocr_cache_misses", "Documentos que no estaban en la caché de OCR",
+                   []() { return ocrCache ? static_cast<double>(ocrCache->stats().misses) : 0.0; });
+    Metrics::gauge("iam_learning_pending_events", "Interacciones y feedback pendientes de escribir",
+                   []() { return learningEngine ? static_cast<double>(learningEngine->pendingEvents()) : 0.0; });
+    Metrics::gauge("iam_learning_dropped_events", "Interacciones y feedback descartados con la cola llena",
+                   []() { return learningEngine ? static_cast<double>(learningEngine->droppedEvents()) : 0.0; });
     
     // Configurar CORS
     auto& cors = app.get_middleware<crow::CORSHandler>();
@@ -138,401 +803,845 @@ int main() {
     
     // Endpoint para autenticación
     CROW_ROUTE(app, "/auth/token").methods("POST"_method)
-    ([&](const crow::request& req) {
-        try {
-            auto params = crow::json::load(req.body);
-            if (!params) {
-                return crow::response(400, "{\"error\":\"Invalid JSON\"}");
+    ([&](const crow::request& req, crow::response& res) {
+        offload(workers, res, [&]() {
+            res = handleTokenRequest(req);
+        });
+    });
+    
+    // Endpoint para generar API Key
+    CROW_ROUTE(app, "/auth/api-key").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
+                return res;
             }
             
-            std::string username = params["username"].s();
-            std::string password = params["password"].s();
-            
-            AuthService::UserInfo user;
-            if (AuthService::authenticateUser(username, password, dbPath, user)) {
-                std::string token = AuthService::generateJWT(user, jwtSecret, tokenExpiryHours);
+            try {
+                std::string apiKey = AuthService::generateAPIKey(ctx.user.id, dbPath, apiKeyPrefix);
+                if (apiKey.empty()) {
+                    res.code = 500;
+                    res.body = "{\"error\":\"Failed to generate API key\"}";
+                    return res;
+                }
                 
                 json response;
-                response["token"] = token;
-                response["user_id"] = user.id;
-                response["username"] = user.username;
-                response["subscription_tier"] = user.subscriptionTier;
+                response["api_key"] = apiKey;
                 
-                return crow::response(200, response.dump());
-            } else {
-                return crow::response(401, "{\"error\":\"Invalid credentials\"}");
+                res.code = 200;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
             }
-        } catch (const std::exception& e) {
-            return crow::response(500, "{\"error\":\"" + std::string(e.what()) + "\"}");
-        }
+            
+            return res;
+        });
     });
     
-    // Endpoint para generar API Key
-    CROW_ROUTE(app, "/auth/api-key").methods("POST"_method)
+    // Endpoint para desactivar una API Key propia
+    CROW_ROUTE(app, "/auth/api-key").methods("DELETE"_method)
     .middleware<AuthMiddleware>()
-    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
-            return res;
-        }
-        
-        try {
-            std::string apiKey = AuthService::generateAPIKey(ctx.user.id, dbPath, apiKeyPrefix);
-            if (apiKey.empty()) {
-                res.code = 500;
-                res.body = "{\"error\":\"Failed to generate API key\"}";
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
                 return res;
             }
             
-            json response;
-            response["api_key"] = apiKey;
+            try {
+                auto params = crow::json::load(req.body);
+                if (!params || !params.has("api_key")) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Missing api_key\"}";
+                    return res;
+                }
+                
+                std::string apiKey = params["api_key"].s();
+                if (!AuthService::deactivateAPIKey(ctx.user.id, apiKey, dbPath)) {
+                    res.code = 404;
+                    res.body = "{\"error\":\"API key not found\"}";
+                    return res;
+                }
+                
+                res.code = 200;
+                res.body = "{\"status\":\"success\"}";
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
             
-            res.code = 200;
-            res.body = response.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            return res;
+        });
     });
     
     // Endpoint para consultas de inmigración
     CROW_ROUTE(app, "/api/v1/immigration/query").methods("POST"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
-            return res;
-        }
-        
-        try {
-            // Verificar cuota
-            if (!AuthService::checkQuotaAndUpdate(ctx.user.id, "query", dbPath)) {
-                res.code = 429;
-                res.body = "{\"error\":\"Quota exceeded for queries\"}";
-                return res;
-            }
-            
-            auto params = crow::json::load(req.body);
-            if (!params) {
-                res.code = 400;
-                res.body = "{\"error\":\"Invalid JSON\"}";
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
                 return res;
             }
             
-            std::string query = params["query"].s();
-            std::string language = params.has("language") ? params["language"].s() : "es";
-            
-            // Si tenemos motor de aprendizaje, intentar buscar en caché o patrones aprendidos
-            if (learningEngine) {
-                auto patternMatch = learningEngine->findMatchingPattern(query);
-                if (patternMatch.confidence > 0.7) {
-                    // Usar respuesta aprendida
-                    json response;
-                    response["response"] = patternMatch.responseTemplate;
-                    response["source"] = patternMatch.isExactMatch ? "cache" : "learned";
-                    response["confidence"] = patternMatch.confidence;
-                    
-                    res.code = 200;
-                    res.body = response.dump();
+            try {
+                // Verificar cuota
+                if (!AuthService::checkQuotaAndUpdate(ctx.user.id, "query", dbPath)) {
+                    res.code = 429;
+                    res.body = "{\"error\":\"Quota exceeded for queries\"}";
                     return res;
                 }
+                
+                auto params = crow::json::load(req.body);
+                if (!params) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Invalid JSON\"}";
+                    return res;
+                }
+                
+                std::string query = params["query"].s();
+                std::string language = params.has("language") ? params["language"].s() : "es";
+                
+                // Si tenemos motor de aprendizaje, intentar buscar en caché o patrones aprendidos
+                if (learningEngine) {
+                    auto patternMatch = learningEngine->findMatchingPattern(query);
+                    if (patternMatch.confidence > 0.7) {
+                        // Usar respuesta aprendida
+                        json response;
+                        response["response"] = patternMatch.responseTemplate;
+                        response["source"] = patternMatch.isExactMatch ? "cache" : "learned";
+                        response["confidence"] = patternMatch.confidence;
+                        
+                        res.code = 200;
+                        res.body = response.dump();
+                        return res;
+                    }
+                }
+                
+                // Si no hay coincidencia, usar el motor IA Migrante
+                auto result = IAMigranteClient::processQuery(query, language, *knowledgeBase);
+                
+                // Guardar en caché/aprendizaje si disponible
+                if (learningEngine) {
+                    learningEngine->recordInteraction(query, result.response, result.confidence);
+                }
+                
+                json response;
+                response["response"] = result.response;
+                response["source"] = result.source;
+                response["confidence"] = result.confidence;
+                
+                res.code = 200;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
             }
             
-            // Si no hay coincidencia, usar el motor IA Migrante
-            auto result = IAMigranteClient::processQuery(query, language, knowledgeBasePath);
-            
-            // Guardar en caché/aprendizaje si disponible
-            if (learningEngine) {
-                learningEngine->recordInteraction(query, result.response, result.confidence);
-            }
-            
-            json response;
-            response["response"] = result.response;
-            response["source"] = result.source;
-            response["confidence"] = result.confidence;
-            
-            res.code = 200;
-            res.body = response.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            return res;
+        });
     });
     
     // Endpoint para feedback
     CROW_ROUTE(app, "/api/v1/feedback").methods("POST"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
+                return res;
+            }
+            
+            try {
+                if (!learningEngine) {
+                    res.code = 503;
+                    res.body = "{\"error\":\"Learning engine is not available\"}";
+                    return res;
+                }
+                
+                auto params = crow::json::load(req.body);
+                if (!params) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Invalid JSON\"}";
+                    return res;
+                }
+                
+                int queryId = params["query_id"].i();
+                int score = params["score"].i();
+                std::string feedbackText = params.has("feedback") ? params["feedback"].s() : "";
+                
+                learningEngine->recordFeedback(queryId, ctx.user.id, score, feedbackText);
+                
+                res.code = 200;
+                res.body = "{\"status\":\"success\"}";
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
+            
             return res;
+        });
+    });
+    
+    // Endpoint para OCR
+    CROW_ROUTE(app, "/api/v1/documents/ocr").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+        // Un cuerpo que no cabe ni en base64 se rechaza sin parsear el JSON
+        if (ctx.authenticated && req.body.size() / 4 * 3 > ocrMaxFileBytes() + MULTIPART_HEADROOM) {
+            res.code = 413;
+            res.body = "{\"error\":\"File too large\"}";
+            res.end();
+            return;
         }
         
-        try {
-            if (!learningEngine) {
-                res.code = 503;
-                res.body = "{\"error\":\"Learning engine is not available\"}";
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
                 return res;
             }
             
-            auto params = crow::json::load(req.body);
-            if (!params) {
-                res.code = 400;
-                res.body = "{\"error\":\"Invalid JSON\"}";
-                return res;
+            try {
+                auto params = crow::json::load(req.body);
+                if (!params || !params.has("file_data") || !params.has("file_type")) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Missing file data or type\"}";
+                    return res;
+                }
+                
+                std::string fileType = params["file_type"].s();
+                if (!OCRClient::isSupportedFormat(fileType)) {
+                    res.code = 415;
+                    res.body = "{\"error\":\"Unsupported file type\"}";
+                    return res;
+                }
+                
+                // Se comprueba el tamaño antes de decodificar: 4 caracteres base64 = 3 bytes
+                if (params["file_data"].size() / 4 * 3 > ocrMaxFileBytes()) {
+                    res.code = 413;
+                    res.body = "{\"error\":\"File too large\"}";
+                    return res;
+                }
+                
+                std::vector<uint8_t> fileData;
+                if (!Base64::decode(params["file_data"].s(), fileData) || fileData.empty()) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"file_data is not valid base64\"}";
+                    return res;
+                }
+                
+                recognizeDocument(req, res, ctx.user.id,
+                                  std::string_view(reinterpret_cast<const char*>(fileData.data()), fileData.size()),
+                                  fileType);
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
             }
             
-            int queryId = params["query_id"].i();
-            int score = params["score"].i();
-            std::string feedbackText = params.has("feedback") ? params["feedback"].s() : "";
-            
-            learningEngine->recordFeedback(queryId, ctx.user.id, score, feedbackText);
+            return res;
+        });
+    });
+    
+    // Subida directa para OCR, sin base64 ni JSON: el cuerpo es el archivo
+    // (formato por ?type= o Content-Type image/png, image/jpeg, image/tiff) o
+    // multipart/form-data con el archivo en el campo "file". El OCR lee los
+    // bytes directamente del cuerpo de la petición, sin copiarlos.
+    CROW_ROUTE(app, "/api/v1/documents/ocr/upload").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+        if (!ctx.authenticated) {
+            res.end();
+            return;
+        }
+        
+        // El tamaño se comprueba antes de ocupar un hilo de trabajo
+        if (req.body.size() > ocrMaxFileBytes() + MULTIPART_HEADROOM) {
+            res.code = 413;
+            res.body = "{\"error\":\"File too large\"}";
+            res.end();
+            return;
+        }
+        
+        offload(workers, res, [&]() -> crow::response& {
+            try {
+                std::string contentType = req.get_header_value("Content-Type");
+                std::string_view fileData = req.body;
+                std::string fileType;
+                
+                std::string_view boundary = Multipart::boundary(contentType);
+                if (!boundary.empty()) {
+                    Multipart::Part file;
+                    if (!Multipart::find(req.body, boundary, "file", file)) {
+                        res.code = 400;
+                        res.body = "{\"error\":\"Missing file part\"}";
+                        return res;
+                    }
+                    fileData = file.data;
+                    
+                    Multipart::Part type;
+                    if (Multipart::find(req.body, boundary, "type", type)) {
+                        fileType = std::string(type.data);
+                    } else {
+                        fileType = ocrFormatFor(file.contentType, file.filename);
+                    }
+                } else {
+                    const char* type = req.url_params.get("type");
+                    fileType = type ? std::string(type) : ocrFormatFor(contentType, "");
+                }
+                
+                if (fileData.empty()) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Missing file data\"}";
+                    return res;
+                }
+                if (fileData.size() > ocrMaxFileBytes()) {
+                    res.code = 413;
+                    res.body = "{\"error\":\"File too large\"}";
+                    return res;
+                }
+                if (!OCRClient::isSupportedFormat(fileType)) {
+                    res.code = 415;
+                    res.body = "{\"error\":\"Unsupported file type\"}";
+                    return res;
+                }
+                
+                recognizeDocument(req, res, ctx.user.id, fileData, fileType);
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
             
-            res.code = 200;
-            res.body = "{\"status\":\"success\"}";
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
+            return res;
+        });
+    });
+    
+    // Plantillas disponibles y sus preguntas: se sirven del catálogo local en
+    // memoria, sin llamar al servicio de documentos ni pasar por el pool
+    CROW_ROUTE(app, "/api/v1/documents/templates").methods("GET"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
+        if (!ctx.authenticated) {
+            res.end();
+            return;
         }
         
-        return res;
+        json response;
+        response["templates"] = documentClient->getAvailableTemplates();
+        
+        res.code = 200;
+        res.body = response.dump();
+        res.end();
     });
     
-    // Endpoint para OCR
-    CROW_ROUTE(app, "/api/v1/documents/ocr").methods("POST"_method)
+    CROW_ROUTE(app, "/api/v1/documents/templates/<string>/questions").methods("GET"_method)
     .middleware<AuthMiddleware>()
-    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx, const std::string& templateId) {
         if (!ctx.authenticated) {
-            return res;
+            res.end();
+            return;
         }
         
-        try {
-            // Verificar cuota
-            if (!AuthService::checkQuotaAndUpdate(ctx.user.id, "ocr", dbPath)) {
-                res.code = 429;
-                res.body = "{\"error\":\"Quota exceeded for OCR\"}";
+        std::vector<std::string> questions;
+        if (!TemplateEngine::forPath(documentTemplatesPath).questions(templateId, questions)) {
+            res.code = 404;
+            res.body = "{\"error\":\"Unknown document type\"}";
+            res.end();
+            return;
+        }
+        
+        json response;
+        response["template"] = templateId;
+        response["questions"] = questions;
+        
+        res.code = 200;
+        res.body = response.dump();
+        res.end();
+    });
+    
+    // Endpoint para generar documentos desde plantillas
+    CROW_ROUTE(app, "/api/v1/documents/generate").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
                 return res;
             }
             
-            auto params = crow::json::load(req.body);
-            if (!params || !params.has("file_data") || !params.has("file_type")) {
+            json params = json::parse(req.body, nullptr, false);
+            if (params.is_discarded()) {
                 res.code = 400;
-                res.body = "{\"error\":\"Missing file data or type\"}";
+                res.body = "{\"error\":\"Invalid JSON\"}";
                 return res;
             }
             
-            // En un sistema real, decodificaríamos base64 aquí
-            // Para este ejemplo, usamos datos simulados
-            std::vector<uint8_t> fileData = {0x01, 0x02, 0x03, 0x04}; // Simulado
-            std::string fileType = params["file_type"].s();
+            GeneratedDocument document = generateDocument(params, [&ctx]() {
+                return AuthService::checkQuotaAndUpdate(ctx.user.id, "document", dbPath);
+            });
             
-            auto result = OCRClient::processDocument(fileData, fileType);
-            
-            json response;
-            response["text"] = result.fullText;
-            response["confidence"] = result.confidence;
-            
-            if (!result.extractedFields.empty()) {
-                json fields = json::object();
-                for (const auto& field : result.extractedFields) {
-                    fields[field.first] = field.second;
-                }
-                response["fields"] = fields;
+            res.code = document.status;
+            if (document.status != 200) {
+                res.body = json{{"error", document.error}}.dump();
+                return res;
             }
-            
-            res.code = 200;
-            res.body = response.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            res.set_header("Content-Type", document.contentType);
+            if (!document.filename.empty()) {
+                res.set_header("Content-Disposition", "attachment; filename=\"" + document.filename + "\"");
+            }
+            if (document.data) {
+                // Crow solo admite el cuerpo como std::string: es la única copia del documento
+                res.body.assign(document.data->begin(), document.data->end());
+            } else {
+                res.body = std::move(document.body);
+            }
+            return res;
+        });
     });
     
-    // Endpoint para TTS
-    CROW_ROUTE(app, "/api/v1/tts").methods("POST"_method)
+    // Generación por lotes: las solicitudes idénticas se generan una vez. Los
+    // formatos de texto se renderizan en los hilos del TaskPool y los binarios
+    // se envían juntos al servicio de documentos (HttpClient::performAll). La
+    // respuesta es NDJSON, una línea por documento en el orden en que terminan
+    // (con su "index" en el lote) y una línea final de resumen. La cuota de
+    // todo el lote se reserva de una vez antes de generar nada.
+    CROW_ROUTE(app, "/api/v1/documents/batch").methods("POST"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
-            return res;
-        }
-        
-        try {
-            // Verificar cuota
-            if (!AuthService::checkQuotaAndUpdate(ctx.user.id, "tts", dbPath)) {
-                res.code = 429;
-                res.body = "{\"error\":\"Quota exceeded for TTS\"}";
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
                 return res;
             }
             
-            auto params = crow::json::load(req.body);
-            if (!params || !params.has("text")) {
+            json params = json::parse(req.body, nullptr, false);
+            if (params.is_discarded() || !params.contains("documents") || !params["documents"].is_array()) {
                 res.code = 400;
-                res.body = "{\"error\":\"Missing text\"}";
+                res.body = "{\"error\":\"Missing documents array\"}";
+                return res;
+            }
+            const json& items = params["documents"];
+            if (items.size() > static_cast<size_t>(documentBatchMaxItems)) {
+                res.code = 413;
+                res.body = json{{"error", "Too many documents in batch"}, {"max_items", documentBatchMaxItems}}.dump();
                 return res;
             }
             
-            std::string text = params["text"].s();
-            std::string voice = params.has("voice") ? params["voice"].s() : "es_female";
-            std::string format = params.has("format") ? params["format"].s() : "mp3";
-            float speed = params.has("speed") ? params["speed"].d() : 1.0f;
+            // Agrupar las solicitudes idénticas (json ordena las claves, dump() es canónico)
+            std::vector<std::vector<size_t>> groups;
+            std::unordered_map<std::string, size_t> groupByKey;
+            for (size_t i = 0; i < items.size(); i++) {
+                std::string key = items[i].dump();
+                auto it = groupByKey.find(key);
+                if (it == groupByKey.end()) {
+                    groupByKey.emplace(std::move(key), groups.size());
+                    groups.push_back({i});
+                } else {
+                    groups[it->second].push_back(i);
+                }
+            }
             
-            TTSClient::TTSOptions options;
-            options.voice = voice;
-            options.speed = speed;
-            options.format = (format == "mp3") ? TTSClient::AudioFormat::MP3 :
-                           (format == "ogg") ? TTSClient::AudioFormat::OGG :
-                           TTSClient::AudioFormat::WAV;
+            std::mutex outputMutex;
+            std::string output;
+            size_t failed = 0;
             
-            auto result = TTSClient::synthesizeSpeech(text, options);
+            // Una línea por documento pedido del grupo, con su índice en el lote
+            auto emit = [&](const std::vector<size_t>& indexes, GeneratedDocument& document) {
+                json line;
+                line["status"] = document.status;
+                if (document.status != 200) {
+                    line["error"] = document.error;
+                } else {
+                    line["content_type"] = document.contentType;
+                    if (!document.data) {
+                        line["content"] = std::move(document.body);
+                    } else if (document.contentType.rfind("text/", 0) == 0 || document.contentType == "application/json") {
+                        line["content"] = std::string(document.data->begin(), document.data->end());
+                    } else {
+                        line["content_base64"] = crow::utility::base64encode(document.data->data(), document.data->size());
+                    }
+                }
+                
+                std::string lines;
+                for (size_t index : indexes) {
+                    line["index"] = index;
+                    lines += line.dump();
+                    lines += '\n';
+                }
+                
+                std::lock_guard<std::mutex> lock(outputMutex);
+                output += lines;
+                if (document.status != 200) {
+                    failed += indexes.size();
+                }
+            };
             
-            // Establecer el tipo de contenido adecuado
-            res.set_header("Content-Type", result.mimeType);
-            res.set_header("Content-Disposition", "attachment; filename=\"speech." + format + "\"");
+            std::vector<GeneratedDocument> documents(groups.size());
+            std::vector<DocumentSpec> specs(groups.size());
+            std::vector<char> valid(groups.size(), 0);
+            std::vector<DocumentServiceClient::DocumentRequest> remote(groups.size());
+            std::vector<char> pending(groups.size(), 0);
+            
+            // Se valida todo el lote antes de cobrar. Se cobra cada documento
+            // válido pedido (aunque se genere una sola vez), todos en una sola
+            // reserva: si no caben en la cuota no se genera ni se cobra ninguno.
+            // Los inválidos no se cobran; un fallo al generar uno ya cobrado
+            // no se devuelve. "charged" en el resumen es lo cobrado.
+            int charged = 0;
+            for (size_t g = 0; g < groups.size(); g++) {
+                valid[g] = parseDocumentRequest(items[groups[g].front()], specs[g], documents[g]);
+                if (valid[g]) {
+                    charged += static_cast<int>(groups[g].size());
+                }
+            }
+            if (charged > 0 && !AuthService::checkQuotaAndUpdate(ctx.user.id, "document", dbPath, charged)) {
+                res.code = 429;
+                res.body = json{{"error", "Quota exceeded for documents"}, {"requested", charged}, {"charged", 0}}.dump();
+                return res;
+            }
+            
+            TaskPool::shared().parallelFor(groups.size(), [&](size_t g) {
+                if (valid[g]) {
+                    pending[g] = prepareDocument(specs[g], []() { return true; }, documents[g], remote[g]);
+                }
+                if (!pending[g]) {
+                    emit(groups[g], documents[g]);
+                }
+            });
+            
+            // Los binarios se piden todos a la vez al servicio de documentos
+            std::vector<size_t> remoteGroups;
+            std::vector<DocumentServiceClient::DocumentRequest> requests;
+            for (size_t g = 0; g < groups.size(); g++) {
+                if (pending[g]) {
+                    remoteGroups.push_back(g);
+                    requests.push_back(std::move(remote[g]));
+                }
+            }
+            if (!requests.empty()) {
+                auto responses = documentClient->generateDocuments(requests);
+                for (size_t k = 0; k < remoteGroups.size(); k++) {
+                    size_t g = remoteGroups[k];
+                    completeDocument(documents[g], responses[k]);
+                    emit(groups[g], documents[g]);
+                }
+            }
+            
+            json summary;
+            summary["total"] = items.size();
+            summary["unique"] = groups.size();
+            summary["failed"] = failed;
+            summary["charged"] = charged;
+            output += json{{"summary", summary}}.dump();
+            output += '\n';
             
-            // Establecer el cuerpo de la respuesta con los datos binarios
-            res.body = std::string(result.audioData.begin(), result.audioData.end());
             res.code = 200;
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            res.set_header("Content-Type", "application/x-ndjson");
+            res.body = std::move(output);
+            return res;
+        });
+    });
+    
+    // Endpoint para TTS
+    CROW_ROUTE(app, "/api/v1/tts").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
+                return res;
+            }
+            
+            try {
+                // Verificar cuota
+                if (!AuthService::checkQuotaAndUpdate(ctx.user.id, "tts", dbPath)) {
+                    res.code = 429;
+                    res.body = "{\"error\":\"Quota exceeded for TTS\"}";
+                    return res;
+                }
+                
+                auto params = crow::json::load(req.body);
+                if (!params || !params.has("text")) {
+                    res.code = 400;
+                    res.body = "{\"error\":\"Missing text\"}";
+                    return res;
+                }
+                
+                std::string text = params["text"].s();
+                std::string voice = params.has("voice") ? params["voice"].s() : "es_female";
+                std::string format = params.has("format") ? params["format"].s() : "mp3";
+                float speed = params.has("speed") ? params["speed"].d() : 1.0f;
+                
+                TTSClient::TTSOptions options;
+                options.voice = voice;
+                options.speed = speed;
+                options.format = (format == "mp3") ? TTSClient::AudioFormat::MP3 :
+                               (format == "ogg") ? TTSClient::AudioFormat::OGG :
+                               TTSClient::AudioFormat::WAV;
+                
+                auto result = TTSClient::synthesizeSpeech(text, options);
+                
+                // Establecer el tipo de contenido adecuado
+                res.set_header("Content-Type", result.mimeType);
+                res.set_header("Content-Disposition", "attachment; filename=\"speech." + format + "\"");
+                
+                // Establecer el cuerpo de la respuesta con los datos binarios
+                res.body = std::string(result.audioData.begin(), result.audioData.end());
+                res.code = 200;
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
+            
+            return res;
+        });
     });
     
     // Endpoint para obtener voces disponibles
     CROW_ROUTE(app, "/api/v1/tts/voices").methods("GET"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
-            return res;
-        }
-        
-        try {
-            auto voices = TTSClient::getAvailableVoices();
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
+                return res;
+            }
             
-            json response;
-            response["voices"] = voices;
+            try {
+                auto voices = TTSClient::getAvailableVoices();
+                
+                json response;
+                response["voices"] = voices;
+                
+                res.code = 200;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
             
-            res.code = 200;
-            res.body = response.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            return res;
+        });
     });
     
     // Endpoint para estadísticas de aprendizaje
     CROW_ROUTE(app, "/api/v1/learning/stats").methods("GET"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated || ctx.user.role != "admin") {
-            res.code = 403;
-            res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
-            return res;
-        }
-        
-        try {
-            if (!learningEngine) {
-                res.code = 503;
-                res.body = "{\"error\":\"Learning engine is not available\"}";
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated || ctx.user.role != "admin") {
+                res.code = 403;
+                res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
                 return res;
             }
             
-            auto stats = learningEngine->getStatistics();
-            
-            json response;
-            response["total_patterns"] = stats.totalPatterns;
-            response["total_queries"] = stats.totalQueries;
-            response["feedback_count"] = stats.feedbackCount;
-            response["average_confidence"] = stats.averageConfidence;
-            response["patterns_last_month"] = stats.patternsLastMonth;
+            try {
+                if (!learningEngine) {
+                    res.code = 503;
+                    res.body = "{\"error\":\"Learning engine is not available\"}";
+                    return res;
+                }
+                
+                auto stats = learningEngine->getStatistics();
+                
+                json response;
+                response["total_patterns"] = stats.totalPatterns;
+                response["total_queries"] = stats.totalQueries;
+                response["feedback_count"] = stats.feedbackCount;
+                response["average_confidence"] = stats.averageConfidence;
+                response["patterns_last_month"] = stats.patternsLastMonth;
+                response["pending_events"] = stats.pendingEvents;
+                response["events_written"] = stats.eventsWritten;
+                response["event_batches"] = stats.eventBatches;
+                response["event_queue_full"] = stats.eventQueueFull;
+                response["events_dropped"] = stats.eventsDropped;
+                
+                res.code = 200;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
             
-            res.code = 200;
-            res.body = response.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            return res;
+        });
     });
     
     // Endpoint para actualizar patrones
     CROW_ROUTE(app, "/api/v1/learning/update-patterns").methods("POST"_method)
     .middleware<AuthMiddleware>()
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated || ctx.user.role != "admin") {
+                res.code = 403;
+                res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
+                return res;
+            }
+            
+            try {
+                if (!learningEngine) {
+                    res.code = 503;
+                    res.body = "{\"error\":\"Learning engine is not available\"}";
+                    return res;
+                }
+                
+                // Se ejecuta en segundo plano; el estado se consulta en /api/v1/jobs/<id>
+                std::string jobId = jobs.submit("update-patterns", runPatternUpdate);
+                if (jobId.empty()) {
+                    res.code = 503;
+                    res.body = "{\"error\":\"Job scheduler is not available\"}";
+                    return res;
+                }
+                
+                json response;
+                response["status"] = "accepted";
+                response["job_id"] = jobId;
+                
+                res.code = 202;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
+            
+            return res;
+        });
+    });
+    
+    // Endpoints de trabajos en segundo plano
+    CROW_ROUTE(app, "/api/v1/jobs").methods("GET"_method)
+    .middleware<AuthMiddleware>()
     ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
         if (!ctx.authenticated || ctx.user.role != "admin") {
             res.code = 403;
             res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
-            return res;
+            res.end();
+            return;
         }
         
-        try {
-            if (!learningEngine) {
-                res.code = 503;
-                res.body = "{\"error\":\"Learning engine is not available\"}";
+        json response = json::array();
+        for (const auto& job : jobs.listJobs()) {
+            response.push_back(jobToJson(job));
+        }
+        
+        res.code = 200;
+        res.body = response.dump();
+        res.end();
+    });
+    
+    CROW_ROUTE(app, "/api/v1/jobs/<string>").methods("GET"_method, "DELETE"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& req, crow::response& res, AuthMiddleware::Context& ctx, const std::string& jobId) {
+        if (!ctx.authenticated || ctx.user.role != "admin") {
+            res.code = 403;
+            res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
+            res.end();
+            return;
+        }
+        
+        if (req.method == "DELETE"_method && !jobs.cancel(jobId)) {
+            res.code = 409;
+            res.body = "{\"error\":\"Job not found or already finished\"}";
+            res.end();
+            return;
+        }
+        
+        JobScheduler::JobInfo job;
+        if (!jobs.getJob(jobId, job)) {
+            res.code = 404;
+            res.body = "{\"error\":\"Job not found\"}";
+            res.end();
+            return;
+        }
+        
+        res.code = 200;
+        res.body = jobToJson(job).dump();
+        res.end();
+    });
+    
+    // Endpoint para recargar la base de conocimiento sin reiniciar
+    CROW_ROUTE(app, "/api/v1/knowledge/reload").methods("POST"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated || ctx.user.role != "admin") {
+                res.code = 403;
+                res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
                 return res;
             }
             
-            // Este proceso puede ser lento, por lo que podría ejecutarse en un hilo separado
-            // Para este ejemplo lo hacemos de manera síncrona
-            learningEngine->updatePatterns();
+            try {
+                auto stats = knowledgeBase->reload();
+                
+                json response;
+                response["status"] = "success";
+                response["version"] = stats.version;
+                response["loaded_at"] = stats.loadedAt;
+                response["languages"] = stats.languages;
+                response["responses"] = stats.responses;
+                
+                res.code = 200;
+                res.body = response.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
             
-            res.code = 200;
-            res.body = "{\"status\":\"success\", \"message\":\"Patterns updated successfully\"}";
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        }
-        
-        return res;
+            return res;
+        });
     });
     
     // Endpoint para obtener info de usuario
     CROW_ROUTE(app, "/api/v1/user").methods("GET"_method)
     .middleware<AuthMiddleware>()
     ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
-        if (!ctx.authenticated) {
-            return res;
-        }
-        
-        try {
-            json userInfo;
-            userInfo["id"] = ctx.user.id;
-            userInfo["username"] = ctx.user.username;
-            userInfo["subscription_tier"] = ctx.user.subscriptionTier;
-            userInfo["role"] = ctx.user.role;
-            
-            // Obtener estadísticas de uso
-            auto usageStats = AuthService::getUserUsage(ctx.user.id, dbPath);
-            userInfo["usage"]["queries"] = usageStats.queries;
-            userInfo["usage"]["documents"] = usageStats.documents;
-            userInfo["usage"]["openai"] = usageStats.openai;
-            userInfo["usage"]["ocr"] = usageStats.ocr;
-            userInfo["usage"]["tts"] = usageStats.tts;
-            
-            // Obtener límites de cuota
-            auto quotaLimits = AuthService::getQuotaLimits(ctx.user.subscriptionTier, dbPath);
-            userInfo["quota"]["daily_queries"] = quotaLimits.dailyQueries;
-            userInfo["quota"]["monthly_documents"] = quotaLimits.monthlyDocuments;
-            userInfo["quota"]["openai_usage"] = quotaLimits.openaiUsage;
-            userInfo["quota"]["monthly_ocr"] = quotaLimits.monthlyOcr;
-            userInfo["quota"]["monthly_tts_minutes"] = quotaLimits.monthlyTtsMinutes;
+        offload(workers, res, [&]() -> crow::response& {
+            if (!ctx.authenticated) {
+                return res;
+            }
             
-            res.code = 200;
-            res.body = userInfo.dump();
-        } catch (const std::exception& e) {
-            res.code = 500;
-            res.body = "{\"error\":\"" + std::string(e.what()) + "\"}";
+            try {
+                json userInfo;
+                userInfo["id"] = ctx.user.id;
+                userInfo["username"] = ctx.user.username;
+                userInfo["subscription_tier"] = ctx.user.subscriptionTier;
+                userInfo["role"] = ctx.user.role;
+                
+                // Obtener estadísticas de uso
+                auto usageStats = AuthService::getUserUsage(ctx.user.id, dbPath);
+                userInfo["usage"]["queries"] = usageStats.queries;
+                userInfo["usage"]["documents"] = usageStats.documents;
+                userInfo["usage"]["openai"] = usageStats.openai;
+                userInfo["usage"]["ocr"] = usageStats.ocr;
+                userInfo["usage"]["tts"] = usageStats.tts;
+                
+                // Obtener límites de cuota
+                auto quotaLimits = AuthService::getQuotaLimits(ctx.user.subscriptionTier, dbPath);
+                userInfo["quota"]["daily_queries"] = quotaLimits.dailyQueries;
+                userInfo["quota"]["monthly_documents"] = quotaLimits.monthlyDocuments;
+                userInfo["quota"]["openai_usage"] = quotaLimits.openaiUsage;
+                userInfo["quota"]["monthly_ocr"] = quotaLimits.monthlyOcr;
+                userInfo["quota"]["monthly_tts_minutes"] = quotaLimits.monthlyTtsMinutes;
+                
+                res.code = 200;
+                res.body = userInfo.dump();
+            } catch (const std::exception& e) {
+                res.code = 500;
+                res.body = json{{"error", e.what()}}.dump();
+            }
+            
+            return res;
+        });
+    });
+    
+    // Métricas en formato de texto de Prometheus
+    CROW_ROUTE(app, "/metrics").methods("GET"_method)
+    .middleware<AuthMiddleware>()
+    ([&](const crow::request& /*req*/, crow::response& res, AuthMiddleware::Context& ctx) {
+        if (!ctx.authenticated || ctx.user.role != "admin") {
+            res.code = 403;
+            res.body = "{\"error\":\"Unauthorized. Admin role required.\"}";
+            res.end();
+            return;
         }
         
-        return res;
+        res.code = 200;
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
+        res.body = Metrics::exportPrometheus();
+        res.end();
     });
     
     // Endpoint de diagnóstico
@@ -546,8 +1655,29 @@ int main() {
     });
     
     // Iniciar servidor
-    std::cout << "Iniciando servidor API en puerto 8080..." << std::endl;
-    app.port(8080).multithreaded().run();
+    unsigned int ioThreads = serverThreads > 0 ? serverThreads : std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Iniciando servidor API en " << serverHost << ":" << serverPort
+              << " (" << ioThreads << " hilos de E/S, " << workers.threadCount() << " de trabajo)..." << std::endl;
+    app.bindaddr(serverHost)
+        .port(serverPort)
+        .concurrency(ioThreads)
+        .timeout(static_cast<std::uint8_t>(std::min(255, std::max(1, serverTimeoutMs / 1000))))
+        .run();
+    
+    // Terminar los handlers y trabajos en curso antes de persistir el uso pendiente
+    workers.shutdown();
+    jobs.shutdown();
+    
+    // El destructor escribe los eventos de aprendizaje que quedaron en cola
+    learningEngine.reset();
+    
+    // Persistir el uso pendiente antes de salir
+    try {
+        QuotaEngine::forPath(dbPath).flush();
+        ApiKeyCache::forPath(dbPath).flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Error al persistir el uso pendiente: " << e.what() << std::endl;
+    }
     
     return 0;
 }
@@ -0,0 +1,90 @@
+#include "worker_pool.h"
+#include <iostream>
+
+WorkerPool::WorkerPool(size_t threads, size_t queueCapacity, int timeoutMs)
+    : queueCapacity(queueCapacity > 0 ? queueCapacity : 1), timeoutMs(timeoutMs), running(true) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 4;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::submit(std::function<void()> work, std::function<void()> onTimeout) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (!running || jobs.size() >= queueCapacity) {
+            return false;
+        }
+
+        auto deadline = timeoutMs > 0
+            ? std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs)
+            : std::chrono::steady_clock::time_point::max();
+        jobs.push_back({std::move(work), std::move(onTimeout), deadline});
+    }
+    jobsSignal.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown() {
+    std::deque<Job> pending;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+        pending.swap(jobs);
+    }
+    jobsSignal.notify_all();
+
+    // Responder a lo que quedó en cola para no dejar conexiones colgadas
+    for (auto& job : pending) {
+        if (job.onTimeout) {
+            job.onTimeout();
+        }
+    }
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t WorkerPool::queued() {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    return jobs.size();
+}
+
+void WorkerPool::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsSignal.wait(lock, [this] { return !running || !jobs.empty(); });
+            if (!running && jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        try {
+            if (std::chrono::steady_clock::now() > job.deadline) {
+                if (job.onTimeout) {
+                    job.onTimeout();
+                }
+            } else {
+                job.work();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error no controlado en el pool de trabajo: " << e.what() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <ctime>
+#include <cstdint>
+#include <sqlite3.h>
+#include "auth_service.h"
+
+// Caché de lectura de API keys (api_key -> UserInfo) con TTL.
+// Cada entrada guarda su último uso en un atómico, así que un acierto solo
+// toma el shared_lock; el hilo de fondo recorre las entradas y escribe los
+// last_used cambiados en una sola transacción, fuera de la ruta crítica.
+class ApiKeyCache {
+public:
+    static ApiKeyCache& forPath(const std::string& dbPath);
+
+    // Ajusta TTL y el intervalo de escritura de last_used antes de usar la caché
+    static void configure(const std::string& dbPath, int ttlSeconds, int flushIntervalMs);
+
+    // Busca la key en caché y, si no está o caducó, en la base de datos
+    bool lookup(const std::string& apiKey, AuthService::UserInfo& outUser);
+
+    // Invalidación explícita (p. ej. al desactivar una key)
+    void invalidate(const std::string& apiKey);
+    void invalidateUser(int userId);
+
+    // Escribe inmediatamente los last_used pendientes
+    void flush();
+
+    ~ApiKeyCache();
+
+private:
+    ApiKeyCache(const std::string& dbPath, int ttlSeconds, int flushIntervalMs);
+
+    struct Entry {
+        AuthService::UserInfo user;
+        time_t loadedAt = 0;
+        std::atomic<time_t> lastUsed{0};
+        std::atomic<time_t> flushedUsed{0};   // Último valor ya tomado para escribir (si falla, vuelve a retired)
+    };
+
+    bool loadFromDatabase(const std::string& apiKey, AuthService::UserInfo& outUser);
+    // Con entriesMutex tomado: quita la key y guarda su último uso pendiente
+    void remove(const std::string& apiKey);
+    void retire(const std::string& apiKey, const Entry& entry);
+    bool writeBatch(const std::unordered_map<std::string, time_t>& batch);
+    void requeue(const std::unordered_map<std::string, time_t>& batch);
+    void flushLoop();
+
+    std::string dbPath;
+    sqlite3* writerDb;
+
+    std::unordered_map<std::string, Entry> entries;
+    std::shared_mutex entriesMutex;
+    // Cambia con cada invalidación: una carga desde la base de datos que se
+    // cruzó con una invalidación no se guarda en la caché
+    uint64_t generation = 0;
+
+    // Últimos usos pendientes de escribir de keys que ya no están en la caché,
+    // y los de lotes cuya escritura falló
+    std::unordered_map<std::string, time_t> retired;
+    std::mutex retiredMutex;
+    std::mutex writerMutex;
+
+    std::atomic<int> ttlSeconds;
+    std::atomic<int> flushIntervalMs;
+    std::atomic<bool> running;
+    std::mutex flushMutex;
+    std::condition_variable flushSignal;
+    std::thread flushThread;
+};
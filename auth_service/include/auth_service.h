@@ -4,6 +4,7 @@
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <ctime>
 #include <sqlite3.h>
 
 class AuthService {
@@ -34,15 +35,23 @@ public:
     static bool authenticateUser(const std::string& username, const std::string& password, 
                                  const std::string& dbPath, UserInfo& outUser);
     
+    // Valida un JWT HS256 consultando primero la caché de tokens verificados
     static bool validateJWT(const std::string& token, const std::string& secret, UserInfo& outUser);
     
+    // Verificación completa (firma HMAC, cabecera y expiración) sin caché
+    static bool verifyJWT(const std::string& token, const std::string& secret, UserInfo& outUser, time_t& outExpiry);
+    
     static bool validateAPIKey(const std::string& apiKey, const std::string& dbPath, UserInfo& outUser);
     
     static std::string generateJWT(const UserInfo& user, const std::string& secret, int expiryHours);
     
     static std::string generateAPIKey(int userId, const std::string& dbPath, const std::string& prefix);
     
-    static bool checkQuotaAndUpdate(int userId, const std::string& actionType, const std::string& dbPath);
+    // Desactiva una API key del usuario y la retira de la caché
+    static bool deactivateAPIKey(int userId, const std::string& apiKey, const std::string& dbPath);
+    
+    // count > 1 reserva varias unidades a la vez: o caben todas o no se registra ninguna
+    static bool checkQuotaAndUpdate(int userId, const std::string& actionType, const std::string& dbPath, int count = 1);
     
     static UsageStats getUserUsage(int userId, const std::string& dbPath);
     
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <ctime>
+#include <cstdint>
+#include <sqlite3.h>
+#include "auth_service.h"
+
+// Motor de cuotas en memoria.
+// Mantiene contadores por usuario y tipo de acción (ventana diaria y mensual,
+// alineadas con 'start of day'/'start of month' de SQLite, en UTC), sembrados
+// desde usage_records al arrancar. La verificación es un incremento atómico;
+// los registros de uso se persisten por lotes en un hilo de fondo.
+class QuotaEngine {
+public:
+    enum Action {
+        QUERY = 0,
+        DOCUMENT,
+        OPENAI,
+        OCR,
+        TTS,
+        ACTION_COUNT
+    };
+
+    // Motor compartido para una ruta de base de datos
+    static QuotaEngine& forPath(const std::string& dbPath);
+
+    // Ajusta el intervalo de escritura por lotes antes de usar el motor
+    static void configure(const std::string& dbPath, int flushIntervalMs);
+
+    // Verifica la cuota y, si hay margen para las count unidades, registra el
+    // uso de todas; si no caben, no registra ninguna
+    bool checkAndRecord(int userId, const std::string& actionType, int count = 1);
+
+    // Uso del mes actual (incluye registros aún no persistidos)
+    AuthService::UsageStats getUsage(int userId);
+
+    // Persiste inmediatamente los registros pendientes
+    void flush();
+
+    ~QuotaEngine();
+
+private:
+    QuotaEngine(const std::string& dbPath, int flushIntervalMs);
+
+    // Ventana (32 bits altos) y cuenta (32 bits bajos) en una sola palabra,
+    // para que el cambio de ventana y los incrementos no se pisen
+    struct Counter {
+        std::atomic<uint64_t> state{0};
+    };
+
+    struct UserState {
+        Counter daily[ACTION_COUNT];
+        Counter monthly[ACTION_COUNT];
+        std::atomic<int> dailyQueryLimit{0};
+        std::atomic<time_t> tierCheckedAt{0};
+    };
+
+    struct UsageRecord {
+        int userId;
+        Action action;
+        time_t timestamp;
+    };
+
+    static int actionFromString(const std::string& actionType);
+    static const char* actionName(Action action);
+    static long long dayWindow(time_t now);
+    static long long monthWindow(time_t now);
+    static uint64_t pack(long long window, int count);
+    static int currentCount(const Counter& counter, long long window);
+    // Suma amount en la ventana indicada si la cuenta no pasa de limit (< 0 = sin límite)
+    static bool tryIncrement(Counter& counter, long long window, int limit, int amount = 1);
+
+    UserState& getUserState(int userId);
+    void refreshTier(int userId, UserState& state, time_t now);
+    void loadQuotaLimits(time_t now);
+    void seedFromDatabase();
+    void flushLoop();
+    bool writeBatch(const std::vector<UsageRecord>& batch);
+    void requeue(std::vector<UsageRecord>& batch);
+
+    std::string dbPath;
+    sqlite3* writerDb;
+
+    // Límites diarios de consultas por nivel (tabla quotas), recargados cada
+    // TIER_REFRESH_SECONDS junto con los niveles de los usuarios
+    std::unordered_map<std::string, int> dailyQueryLimits;
+    std::atomic<time_t> limitsLoadedAt{0};
+    std::mutex limitsMutex;
+
+    std::unordered_map<int, std::unique_ptr<UserState>> users;
+    std::shared_mutex usersMutex;
+
+    std::vector<UsageRecord> pending;
+    std::mutex pendingMutex;
+    std::mutex writerMutex;
+
+    std::atomic<int> flushIntervalMs;
+    std::atomic<bool> running;
+    std::condition_variable flushSignal;
+    std::thread flushThread;
+};
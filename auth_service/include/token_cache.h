@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <ctime>
+#include "auth_service.h"
+
+// Caché LRU acotada y particionada de tokens JWT ya verificados.
+// La clave es el token completo y cada entrada recuerda el secreto con el que
+// se verificó: un acierto exige el mismo token y el mismo secreto, así que
+// cambiar el secreto invalida lo cacheado. El valor es el UserInfo
+// decodificado y su expiración; un acierto evita el HMAC y el análisis del JSON.
+class TokenCache {
+public:
+    explicit TokenCache(size_t capacity = 65536, size_t shardCount = 16);
+
+    static TokenCache& instance();
+
+    bool get(const std::string& token, const std::string& secret, AuthService::UserInfo& outUser);
+    void put(const std::string& token, const std::string& secret,
+             const AuthService::UserInfo& user, time_t expiresAt);
+    void clear();
+
+    void setCapacity(size_t capacity);
+
+private:
+    struct Entry {
+        std::string token;
+        std::string secret;
+        AuthService::UserInfo user;
+        time_t expiresAt;
+    };
+
+    struct Shard {
+        std::list<Entry> entries;  // Más reciente al frente
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::mutex mutex;
+    };
+
+    Shard& shardFor(const std::string& token);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<size_t> shardCapacity;
+};
@@ -0,0 +1,256 @@
+#include "api_key_cache.h"
+#include "sqlite_pool.h"
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <chrono>
+
+// Registro de cachés por ruta de base de datos
+static std::unordered_map<std::string, std::unique_ptr<ApiKeyCache>> caches;
+static std::mutex cachesMutex;
+
+ApiKeyCache& ApiKeyCache::forPath(const std::string& dbPath) {
+    std::lock_guard<std::mutex> lock(cachesMutex);
+    auto it = caches.find(dbPath);
+    if (it == caches.end()) {
+        it = caches.emplace(dbPath, std::unique_ptr<ApiKeyCache>(new ApiKeyCache(dbPath, 60, 5000))).first;
+    }
+    return *it->second;
+}
+
+void ApiKeyCache::configure(const std::string& dbPath, int ttlSeconds, int flushIntervalMs) {
+    if (ttlSeconds < 0) {
+        ttlSeconds = 0;
+    }
+    if (flushIntervalMs <= 0) {
+        flushIntervalMs = 5000;
+    }
+
+    std::lock_guard<std::mutex> lock(cachesMutex);
+    auto it = caches.find(dbPath);
+    if (it == caches.end()) {
+        caches.emplace(dbPath, std::unique_ptr<ApiKeyCache>(new ApiKeyCache(dbPath, ttlSeconds, flushIntervalMs)));
+    } else {
+        it->second->ttlSeconds = ttlSeconds;
+        it->second->flushIntervalMs = flushIntervalMs;
+    }
+}
+
+ApiKeyCache::ApiKeyCache(const std::string& dbPath, int ttlSeconds, int flushIntervalMs)
+    : dbPath(dbPath), writerDb(nullptr), ttlSeconds(ttlSeconds), flushIntervalMs(flushIntervalMs), running(true) {
+    int rc = sqlite3_open(dbPath.c_str(), &writerDb);
+    if (rc) {
+        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(writerDb) << std::endl;
+        sqlite3_close(writerDb);
+        throw std::runtime_error("Error al abrir la base de datos de API keys");
+    }
+    sqlite3_exec(writerDb, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(writerDb, 5000);
+
+    flushThread = std::thread(&ApiKeyCache::flushLoop, this);
+}
+
+ApiKeyCache::~ApiKeyCache() {
+    {
+        std::lock_guard<std::mutex> lock(flushMutex);
+        running = false;
+    }
+    flushSignal.notify_all();
+    if (flushThread.joinable()) {
+        flushThread.join();
+    }
+
+    flush();
+
+    if (writerDb) {
+        sqlite3_close(writerDb);
+    }
+}
+
+bool ApiKeyCache::lookup(const std::string& apiKey, AuthService::UserInfo& outUser) {
+    time_t now = time(nullptr);
+
+    uint64_t loadGeneration;
+    {
+        std::shared_lock<std::shared_mutex> lock(entriesMutex);
+        auto it = entries.find(apiKey);
+        if (it != entries.end() && now - it->second.loadedAt < ttlSeconds.load()) {
+            outUser = it->second.user;
+            if (it->second.lastUsed.load(std::memory_order_relaxed) != now) {
+                it->second.lastUsed.store(now, std::memory_order_relaxed);
+            }
+            return true;
+        }
+        loadGeneration = generation;
+    }
+
+    if (!loadFromDatabase(apiKey, outUser)) {
+        // La key ya no es válida: olvidar cualquier copia caducada
+        std::unique_lock<std::shared_mutex> lock(entriesMutex);
+        remove(apiKey);
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(entriesMutex);
+    if (generation != loadGeneration) {
+        // Hubo una invalidación durante la lectura: la fila leída puede ser
+        // de una key ya desactivada, así que no se guarda ni se da por buena
+        lock.unlock();
+        return lookup(apiKey, outUser);
+    }
+    Entry& entry = entries[apiKey];
+    entry.user = outUser;
+    entry.loadedAt = now;
+    entry.lastUsed.store(now, std::memory_order_relaxed);
+
+    return true;
+}
+
+void ApiKeyCache::invalidate(const std::string& apiKey) {
+    std::unique_lock<std::shared_mutex> lock(entriesMutex);
+    generation++;
+    remove(apiKey);
+}
+
+void ApiKeyCache::invalidateUser(int userId) {
+    std::unique_lock<std::shared_mutex> lock(entriesMutex);
+    generation++;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.user.id == userId) {
+            retire(it->first, it->second);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ApiKeyCache::remove(const std::string& apiKey) {
+    auto it = entries.find(apiKey);
+    if (it != entries.end()) {
+        retire(it->first, it->second);
+        entries.erase(it);
+    }
+}
+
+void ApiKeyCache::retire(const std::string& apiKey, const Entry& entry) {
+    time_t used = entry.lastUsed.load();
+    if (used > entry.flushedUsed.load()) {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired[apiKey] = used;
+    }
+}
+
+bool ApiKeyCache::loadFromDatabase(const std::string& apiKey, AuthService::UserInfo& outUser) {
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
+        return false;
+    }
+
+    auto stmt = conn.prepare("SELECT u.id, u.username, COALESCE(s.tier, 'free') as tier "
+                             "FROM users u "
+                             "JOIN api_keys k ON u.id = k.user_id "
+                             "LEFT JOIN subscriptions s ON u.id = s.user_id AND s.end_date > datetime('now') "
+                             "WHERE k.api_key = ? AND k.is_active = 1 "
+                             "ORDER BY s.end_date DESC LIMIT 1");
+    if (!stmt) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt.get(), 1, apiKey.c_str(), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        return false;
+    }
+
+    outUser.id = sqlite3_column_int(stmt.get(), 0);
+    outUser.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+    outUser.subscriptionTier = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2));
+    outUser.role = "user";  // Por defecto
+
+    return true;
+}
+
+void ApiKeyCache::flush() {
+    // Un solo escritor a la vez: flushedUsed solo lo actualiza quien escribe
+    std::lock_guard<std::mutex> writerLock(writerMutex);
+
+    std::unordered_map<std::string, time_t> batch;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        batch.swap(retired);
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(entriesMutex);
+        for (auto& entry : entries) {
+            time_t used = entry.second.lastUsed.load();
+            if (used > entry.second.flushedUsed.load()) {
+                batch[entry.first] = used;
+                entry.second.flushedUsed.store(used);
+            }
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    if (!writeBatch(batch)) {
+        // flushedUsed ya avanzó: el lote vuelve a retired para el siguiente flush
+        requeue(batch);
+    }
+}
+
+// Escribe el lote en una sola transacción: o entra entero o no entra nada
+bool ApiKeyCache::writeBatch(const std::unordered_map<std::string, time_t>& batch) {
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(writerDb, "UPDATE api_keys SET last_used = datetime(?, 'unixepoch') WHERE api_key = ?",
+                                -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Error al preparar la actualización de last_used: " << sqlite3_errmsg(writerDb) << std::endl;
+        return false;
+    }
+
+    bool written = sqlite3_exec(writerDb, "BEGIN", nullptr, nullptr, nullptr) == SQLITE_OK;
+    for (auto it = batch.begin(); written && it != batch.end(); ++it) {
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(it->second));
+        sqlite3_bind_text(stmt, 2, it->first.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            written = false;
+        }
+        sqlite3_reset(stmt);
+    }
+    if (written && sqlite3_exec(writerDb, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        written = false;
+    }
+    if (!written) {
+        std::cerr << "Error al actualizar last_used: " << sqlite3_errmsg(writerDb) << std::endl;
+        sqlite3_exec(writerDb, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+
+    sqlite3_finalize(stmt);
+    return written;
+}
+
+void ApiKeyCache::requeue(const std::unordered_map<std::string, time_t>& batch) {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    for (const auto& entry : batch) {
+        time_t& used = retired[entry.first];
+        if (entry.second > used) {
+            used = entry.second;
+        }
+    }
+}
+
+void ApiKeyCache::flushLoop() {
+    std::unique_lock<std::mutex> lock(flushMutex);
+    while (running) {
+        flushSignal.wait_for(lock, std::chrono::milliseconds(flushIntervalMs.load()), [this] { return !running; });
+        if (!running) {
+            continue;
+        }
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
@@ -1,8 +1,14 @@
 #include "auth_service.h"
+#include "sqlite_pool.h"
+#include "quota_engine.h"
+#include "token_cache.h"
+#include "api_key_cache.h"
+#include "metrics.h"
 #include <iostream>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <openssl/crypto.h>
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <iomanip>
@@ -13,70 +19,128 @@ using json = nlohmann::json;
 
 bool AuthService::authenticateUser(const std::string& username, const std::string& password, 
                                  const std::string& dbPath, UserInfo& outUser) {
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
         return false;
     }
     
     // En un sistema real, verificaríamos el hash de la contraseña
     // Para este ejemplo, comparamos directamente (no es seguro para producción)
-    const char* sql = "SELECT id, username FROM users WHERE username = ? AND password_hash = ?";
-    sqlite3_stmt* stmt;
+    auto stmt = conn.prepare("SELECT id, username FROM users WHERE username = ? AND password_hash = ?");
+    if (!stmt) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt.get(), 1, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt.get(), 2, password.c_str(), -1, SQLITE_STATIC);
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        sqlite3_close(db);
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
         return false;
     }
     
-    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, password.c_str(), -1, SQLITE_STATIC);
+    outUser.id = sqlite3_column_int(stmt.get(), 0);
+    outUser.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 1));
+    // No hay columna de rol: la cuenta 'admin' creada por setup_db.sh es la administradora
+    outUser.role = (outUser.username == "admin") ? "admin" : "user";
+    outUser.subscriptionTier = "free";  // Por defecto
+    
+    // Obtener nivel de suscripción
+    auto subStmt = conn.prepare("SELECT tier FROM subscriptions WHERE user_id = ? AND end_date > datetime('now') ORDER BY end_date DESC LIMIT 1");
+    if (subStmt) {
+        sqlite3_bind_int(subStmt.get(), 1, outUser.id);
+        if (sqlite3_step(subStmt.get()) == SQLITE_ROW) {
+            outUser.subscriptionTier = reinterpret_cast<const char*>(sqlite3_column_text(subStmt.get(), 0));
+        }
+    }
     
-    bool authenticated = false;
+    // Actualizar último login
+    auto updateStmt = conn.prepare("UPDATE users SET last_login = datetime('now') WHERE id = ?");
+    if (updateStmt) {
+        sqlite3_bind_int(updateStmt.get(), 1, outUser.id);
+        sqlite3_step(updateStmt.get());
+    }
     
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        outUser.id = sqlite3_column_int(stmt, 0);
-        outUser.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        outUser.role = "user";  // Por defecto
-        
-        // Obtener nivel de suscripción
-        sqlite3_finalize(stmt);
-        const char* subSql = "SELECT tier FROM subscriptions WHERE user_id = ? AND end_date > datetime('now') ORDER BY end_date DESC LIMIT 1";
-        rc = sqlite3_prepare_v2(db, subSql, -1, &stmt, nullptr);
-        
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, outUser.id);
-            if (sqlite3_step(stmt) == SQLITE_ROW) {
-                outUser.subscriptionTier = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            } else {
-                outUser.subscriptionTier = "free";  // Por defecto
-            }
+    return true;
+}
+
+static std::string base64UrlEncode(const std::string& input) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    
+    std::string output;
+    output.reserve((input.size() + 2) / 3 * 4);
+    
+    size_t i = 0;
+    for (; i + 2 < input.size(); i += 3) {
+        uint32_t chunk = (static_cast<uint8_t>(input[i]) << 16) |
+                         (static_cast<uint8_t>(input[i + 1]) << 8) |
+                         static_cast<uint8_t>(input[i + 2]);
+        output += alphabet[(chunk >> 18) & 0x3F];
+        output += alphabet[(chunk >> 12) & 0x3F];
+        output += alphabet[(chunk >> 6) & 0x3F];
+        output += alphabet[chunk & 0x3F];
+    }
+    
+    // Resto sin relleno '=' (base64url según RFC 7515)
+    size_t remaining = input.size() - i;
+    if (remaining == 1) {
+        uint32_t chunk = static_cast<uint8_t>(input[i]) << 16;
+        output += alphabet[(chunk >> 18) & 0x3F];
+        output += alphabet[(chunk >> 12) & 0x3F];
+    } else if (remaining == 2) {
+        uint32_t chunk = (static_cast<uint8_t>(input[i]) << 16) | (static_cast<uint8_t>(input[i + 1]) << 8);
+        output += alphabet[(chunk >> 18) & 0x3F];
+        output += alphabet[(chunk >> 12) & 0x3F];
+        output += alphabet[(chunk >> 6) & 0x3F];
+    }
+    
+    return output;
+}
+
+static bool base64UrlDecode(const std::string& input, std::string& output) {
+    output.clear();
+    output.reserve(input.size() * 3 / 4);
+    
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '-') {
+            value = 62;
+        } else if (c == '_') {
+            value = 63;
+        } else {
+            return false;
         }
         
-        // Actualizar último login
-        sqlite3_finalize(stmt);
-        const char* updateSql = "UPDATE users SET last_login = datetime('now') WHERE id = ?";
-        rc = sqlite3_prepare_v2(db, updateSql, -1, &stmt, nullptr);
-        
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, outUser.id);
-            sqlite3_step(stmt);
+        buffer = (buffer << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output += static_cast<char>((buffer >> bits) & 0xFF);
         }
-        
-        authenticated = true;
     }
     
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    return true;
+}
+
+static std::string hmacSha256(const std::string& data, const std::string& secret) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+         digest, &digestLength);
     
-    return authenticated;
+    return std::string(reinterpret_cast<const char*>(digest), digestLength);
 }
 
 std::string AuthService::generateJWT(const UserInfo& user, const std::string& secret, int expiryHours) {
-    // Este es un ejemplo simplificado. En producción, usa una biblioteca JWT adecuada
     // Header - algoritmo y tipo de token
     json header = {
         {"alg", "HS256"},
@@ -98,39 +162,83 @@ std::string AuthService::generateJWT(const UserInfo& user, const std::string& se
         {"iat", std::chrono::system_clock::to_time_t(now)}
     };
     
-    // Codificar header y payload en base64
-    std::string headerBase64 = "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9";  // Simplificado
-    std::string payloadBase64 = "eyJ1c2VyX2lkIjoxLCJ1c2VybmFtZSI6ImFkbWluIn0";  // Simplificado
+    // Codificar header y payload en base64url
+    std::string headerBase64 = base64UrlEncode(header.dump());
+    std::string payloadBase64 = base64UrlEncode(payload.dump());
     
-    // Firma
+    // Firma HMAC-SHA256
     std::string dataToSign = headerBase64 + "." + payloadBase64;
-    std::string signature = "signaturewouldgohere";  // Simplificado
+    std::string signature = base64UrlEncode(hmacSha256(dataToSign, secret));
     
     // Combinar todo
-    return headerBase64 + "." + payloadBase64 + "." + signature;
+    return dataToSign + "." + signature;
 }
 
 bool AuthService::validateJWT(const std::string& token, const std::string& secret, UserInfo& outUser) {
-    // Este es un ejemplo simplificado. En producción, valida correctamente la firma y expiración
+    // Solo un token idéntico, verificado antes con el mismo secreto, evita el HMAC y el JSON
+    if (TokenCache::instance().get(token, secret, outUser)) {
+        return true;
+    }
+    
+    time_t expiry;
+    if (!verifyJWT(token, secret, outUser, expiry)) {
+        return false;
+    }
     
+    TokenCache::instance().put(token, secret, outUser, expiry);
+    return true;
+}
+
+bool AuthService::verifyJWT(const std::string& token, const std::string& secret, UserInfo& outUser, time_t& outExpiry) {
     // Dividir token en 3 partes: header.payload.signature
     size_t firstDot = token.find('.');
-    size_t secondDot = token.find('.', firstDot + 1);
+    size_t secondDot = firstDot == std::string::npos ? std::string::npos : token.find('.', firstDot + 1);
     
-    if (firstDot == std::string::npos || secondDot == std::string::npos) {
+    if (firstDot == std::string::npos || secondDot == std::string::npos ||
+        token.find('.', secondDot + 1) != std::string::npos) {
         return false;
     }
     
-    std::string payloadBase64 = token.substr(firstDot + 1, secondDot - firstDot - 1);
-    
-    // En un sistema real, decodificaríamos base64 y verificaríamos la firma
-    // Para este ejemplo, simplificamos
+    // Verificar la firma antes de decodificar nada
+    std::string expected = hmacSha256(token.substr(0, secondDot), secret);
+    std::string signature;
+    if (!base64UrlDecode(token.substr(secondDot + 1), signature) || signature.size() != expected.size() ||
+        CRYPTO_memcmp(signature.data(), expected.data(), expected.size()) != 0) {
+        return false;
+    }
     
-    // Simular decodificación y extracción de datos del usuario
-    outUser.id = 1;  // Simulado
-    outUser.username = "admin";  // Simulado
-    outUser.subscriptionTier = "enterprise";  // Simulado
-    outUser.role = "admin";  // Simulado
+    try {
+        std::string headerJson, payloadJson;
+        if (!base64UrlDecode(token.substr(0, firstDot), headerJson) ||
+            !base64UrlDecode(token.substr(firstDot + 1, secondDot - firstDot - 1), payloadJson)) {
+            return false;
+        }
+        
+        json header = json::parse(headerJson);
+        if (header.value("alg", "") != "HS256") {
+            return false;
+        }
+        
+        json payload = json::parse(payloadJson);
+        if (!payload.contains("exp") || !payload.contains("user_id")) {
+            return false;
+        }
+        
+        // Verificar expiración
+        time_t exp = payload["exp"].get<time_t>();
+        if (exp <= std::time(nullptr)) {
+            return false;
+        }
+        
+        outUser.id = payload["user_id"].get<int>();
+        outUser.username = payload.value("username", "");
+        outUser.subscriptionTier = payload.value("subscription_tier", "free");
+        outUser.role = payload.value("role", "user");
+        outExpiry = exp;
+    } catch (const std::exception& e) {
+        std::cerr << "Token JWT inválido: " << e.what() << std::endl;
+        return false;
+    }
     
     return true;
 }
@@ -148,31 +256,20 @@ std::string AuthService::generateAPIKey(int userId, const std::string& dbPath, c
     std::string apiKey = ss.str();
     
     // Guardar en la base de datos
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
         return "";
     }
     
-    const char* sql = "INSERT INTO api_keys (user_id, api_key) VALUES (?, ?)";
-    sqlite3_stmt* stmt;
-    
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        sqlite3_close(db);
+    auto stmt = conn.prepare("INSERT INTO api_keys (user_id, api_key) VALUES (?, ?)");
+    if (!stmt) {
         return "";
     }
     
-    sqlite3_bind_int(stmt, 1, userId);
-    sqlite3_bind_text(stmt, 2, apiKey.c_str(), -1, SQLITE_STATIC);
-    
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    sqlite3_bind_int(stmt.get(), 1, userId);
+    sqlite3_bind_text(stmt.get(), 2, apiKey.c_str(), -1, SQLITE_STATIC);
     
-    if (rc != SQLITE_DONE) {
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
         return "";
     }
     
@@ -180,212 +277,89 @@ std::string AuthService::generateAPIKey(int userId, const std::string& dbPath, c
 }
 
 bool AuthService::validateAPIKey(const std::string& apiKey, const std::string& dbPath, UserInfo& outUser) {
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return false;
-    }
-    
-    const char* sql = "SELECT u.id, u.username, COALESCE(s.tier, 'free') as tier "
-                      "FROM users u "
-                      "JOIN api_keys k ON u.id = k.user_id "
-                      "LEFT JOIN subscriptions s ON u.id = s.user_id AND s.end_date > datetime('now') "
-                      "WHERE k.api_key = ? AND k.is_active = 1 "
-                      "ORDER BY s.end_date DESC LIMIT 1";
-    
-    sqlite3_stmt* stmt;
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        sqlite3_close(db);
+    // Caché de lectura con TTL; last_used se escribe en diferido y por lotes
+    try {
+        return ApiKeyCache::forPath(dbPath).lookup(apiKey, outUser);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al validar la API key: " << e.what() << std::endl;
         return false;
     }
-    
-    sqlite3_bind_text(stmt, 1, apiKey.c_str(), -1, SQLITE_STATIC);
-    
-    bool validated = false;
-    
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        outUser.id = sqlite3_column_int(stmt, 0);
-        outUser.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        outUser.subscriptionTier = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        outUser.role = "user";  // Por defecto
-        
-        // Actualizar último uso
-        sqlite3_finalize(stmt);
-        const char* updateSql = "UPDATE api_keys SET last_used = datetime('now') WHERE api_key = ?";
-        rc = sqlite3_prepare_v2(db, updateSql, -1, &stmt, nullptr);
-        
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, apiKey.c_str(), -1, SQLITE_STATIC);
-            sqlite3_step(stmt);
-        }
-        
-        validated = true;
-    }
-    
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    
-    return validated;
 }
 
-bool AuthService::checkQuotaAndUpdate(int userId, const std::string& actionType, const std::string& dbPath) {
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return false;
-    }
-    
-    // Obtener nivel de suscripción del usuario
-    std::string tier = "free";
-    const char* tierSql = "SELECT tier FROM subscriptions WHERE user_id = ? AND end_date > datetime('now') ORDER BY end_date DESC LIMIT 1";
-    sqlite3_stmt* stmt;
-    
-    rc = sqlite3_prepare_v2(db, tierSql, -1, &stmt, nullptr);
-    if (rc == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, userId);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            tier = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+bool AuthService::deactivateAPIKey(int userId, const std::string& apiKey, const std::string& dbPath) {
+    bool deactivated = false;
+    {
+        auto conn = SQLitePool::forPath(dbPath).acquire();
+        if (!conn) {
+            return false;
         }
-    }
-    sqlite3_finalize(stmt);
-    
-    // Verificar cuota según el tipo de acción
-    bool withinQuota = false;
-    
-    if (actionType == "query") {
-        // Verificar queries diarias
-        const char* querySql = "SELECT COUNT(*) FROM usage_records "
-                             "WHERE user_id = ? AND action_type = 'query' "
-                             "AND timestamp > datetime('now', 'start of day')";
         
-        rc = sqlite3_prepare_v2(db, querySql, -1, &stmt, nullptr);
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, userId);
-            if (sqlite3_step(stmt) == SQLITE_ROW) {
-                int queryCount = sqlite3_column_int(stmt, 0);
-                
-                // Obtener límite de consultas diarias
-                sqlite3_finalize(stmt);
-                const char* limitSql = "SELECT daily_queries FROM quotas WHERE tier = ?";
-                rc = sqlite3_prepare_v2(db, limitSql, -1, &stmt, nullptr);
-                
-                if (rc == SQLITE_OK) {
-                    sqlite3_bind_text(stmt, 1, tier.c_str(), -1, SQLITE_STATIC);
-                    if (sqlite3_step(stmt) == SQLITE_ROW) {
-                        int queryLimit = sqlite3_column_int(stmt, 0);
-                        withinQuota = (queryCount < queryLimit);
-                    }
-                }
-            }
+        auto stmt = conn.prepare("UPDATE api_keys SET is_active = 0 WHERE api_key = ? AND user_id = ?");
+        if (!stmt) {
+            return false;
         }
-    } else if (actionType == "document" || actionType == "openai" || actionType == "ocr" || actionType == "tts") {
-        // Implementar verificaciones similares para otros tipos de acciones
-        // Por simplicidad, asumimos que está dentro de la cuota
-        withinQuota = true;
+        
+        sqlite3_bind_text(stmt.get(), 1, apiKey.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt.get(), 2, userId);
+        deactivated = sqlite3_step(stmt.get()) == SQLITE_DONE && sqlite3_changes(conn.db()) > 0;
     }
     
-    sqlite3_finalize(stmt);
-    
-    // Si está dentro de la cuota, registrar el uso
-    if (withinQuota) {
-        const char* insertSql = "INSERT INTO usage_records (user_id, action_type) VALUES (?, ?)";
-        rc = sqlite3_prepare_v2(db, insertSql, -1, &stmt, nullptr);
-        
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_int(stmt, 1, userId);
-            sqlite3_bind_text(stmt, 2, actionType.c_str(), -1, SQLITE_STATIC);
-            sqlite3_step(stmt);
+    if (deactivated) {
+        try {
+            ApiKeyCache::forPath(dbPath).invalidate(apiKey);
+        } catch (const std::exception& e) {
+            std::cerr << "Error al invalidar la API key: " << e.what() << std::endl;
         }
     }
     
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    
-    return withinQuota;
+    return deactivated;
 }
 
-AuthService::UsageStats AuthService::getUserUsage(int userId, const std::string& dbPath) {
-    UsageStats stats = {0, 0, 0, 0, 0};
-    
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
-        return stats;
+bool AuthService::checkQuotaAndUpdate(int userId, const std::string& actionType, const std::string& dbPath, int count) {
+    static LatencyHistogram& quotaStage = Metrics::stage("quota");
+    Metrics::ScopedTimer timer(quotaStage);
+    
+    // Los contadores viven en memoria; el uso se persiste por lotes en segundo plano
+    try {
+        return QuotaEngine::forPath(dbPath).checkAndRecord(userId, actionType, count);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al verificar la cuota: " << e.what() << std::endl;
+        return false;
     }
-    
-    // Obtener estadísticas del mes actual
-    const char* sql = "SELECT action_type, COUNT(*) FROM usage_records "
-                    "WHERE user_id = ? AND timestamp > datetime('now', 'start of month') "
-                    "GROUP BY action_type";
-    
-    sqlite3_stmt* stmt;
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    
-    if (rc == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, userId);
-        
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            std::string actionType = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            int count = sqlite3_column_int(stmt, 1);
-            
-            if (actionType == "query") {
-                stats.queries = count;
-            } else if (actionType == "document") {
-                stats.documents = count;
-            } else if (actionType == "openai") {
-                stats.openai = count;
-            } else if (actionType == "ocr") {
-                stats.ocr = count;
-            } else if (actionType == "tts") {
-                stats.tts = count;
-            }
-        }
+}
+
+AuthService::UsageStats AuthService::getUserUsage(int userId, const std::string& dbPath) {
+    // Estadísticas del mes actual, incluidos los registros aún no persistidos
+    try {
+        return QuotaEngine::forPath(dbPath).getUsage(userId);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al obtener el uso: " << e.what() << std::endl;
+        return UsageStats{0, 0, 0, 0, 0};
     }
-    
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    
-    return stats;
 }
 
 AuthService::QuotaLimits AuthService::getQuotaLimits(const std::string& subscriptionTier, const std::string& dbPath) {
     QuotaLimits limits = {0, 0, 0, 0, 0};
     
-    sqlite3* db;
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_close(db);
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
         return limits;
     }
     
-    const char* sql = "SELECT daily_queries, monthly_documents, openai_usage, monthly_ocr, monthly_tts_minutes "
-                    "FROM quotas WHERE tier = ?";
+    auto stmt = conn.prepare("SELECT daily_queries, monthly_documents, openai_usage, monthly_ocr, monthly_tts_minutes "
+                             "FROM quotas WHERE tier = ?");
     
-    sqlite3_stmt* stmt;
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    
-    if (rc == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, subscriptionTier.c_str(), -1, SQLITE_STATIC);
+    if (stmt) {
+        sqlite3_bind_text(stmt.get(), 1, subscriptionTier.c_str(), -1, SQLITE_STATIC);
         
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            limits.dailyQueries = sqlite3_column_int(stmt, 0);
-            limits.monthlyDocuments = sqlite3_column_int(stmt, 1);
-            limits.openaiUsage = sqlite3_column_int(stmt, 2);
-            limits.monthlyOcr = sqlite3_column_int(stmt, 3);
-            limits.monthlyTtsMinutes = sqlite3_column_int(stmt, 4);
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+            limits.dailyQueries = sqlite3_column_int(stmt.get(), 0);
+            limits.monthlyDocuments = sqlite3_column_int(stmt.get(), 1);
+            limits.openaiUsage = sqlite3_column_int(stmt.get(), 2);
+            limits.monthlyOcr = sqlite3_column_int(stmt.get(), 3);
+            limits.monthlyTtsMinutes = sqlite3_column_int(stmt.get(), 4);
         }
     }
     
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    
     return limits;
 }
@@ -0,0 +1,371 @@
+#include "quota_engine.h"
+#include "sqlite_pool.h"
+#include <iostream>
+#include <stdexcept>
+#include <chrono>
+
+// Cada cuánto se vuelve a consultar el nivel de suscripción de un usuario,
+// y los límites de la tabla quotas
+static const time_t TIER_REFRESH_SECONDS = 300;
+
+// Registro de motores por ruta de base de datos
+static std::unordered_map<std::string, std::unique_ptr<QuotaEngine>> engines;
+static std::mutex enginesMutex;
+
+QuotaEngine& QuotaEngine::forPath(const std::string& dbPath) {
+    std::lock_guard<std::mutex> lock(enginesMutex);
+    auto it = engines.find(dbPath);
+    if (it == engines.end()) {
+        it = engines.emplace(dbPath, std::unique_ptr<QuotaEngine>(new QuotaEngine(dbPath, 1000))).first;
+    }
+    return *it->second;
+}
+
+void QuotaEngine::configure(const std::string& dbPath, int flushIntervalMs) {
+    if (flushIntervalMs <= 0) {
+        flushIntervalMs = 1000;
+    }
+
+    std::lock_guard<std::mutex> lock(enginesMutex);
+    auto it = engines.find(dbPath);
+    if (it == engines.end()) {
+        engines.emplace(dbPath, std::unique_ptr<QuotaEngine>(new QuotaEngine(dbPath, flushIntervalMs)));
+    } else {
+        it->second->flushIntervalMs = flushIntervalMs;
+    }
+}
+
+QuotaEngine::QuotaEngine(const std::string& dbPath, int flushIntervalMs)
+    : dbPath(dbPath), writerDb(nullptr), flushIntervalMs(flushIntervalMs), running(true) {
+    int rc = sqlite3_open(dbPath.c_str(), &writerDb);
+    if (rc) {
+        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(writerDb) << std::endl;
+        sqlite3_close(writerDb);
+        throw std::runtime_error("Error al abrir la base de datos de cuotas");
+    }
+    sqlite3_exec(writerDb, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(writerDb, 5000);
+
+    loadQuotaLimits(time(nullptr));
+    seedFromDatabase();
+
+    flushThread = std::thread(&QuotaEngine::flushLoop, this);
+}
+
+QuotaEngine::~QuotaEngine() {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        running = false;
+    }
+    flushSignal.notify_all();
+    if (flushThread.joinable()) {
+        flushThread.join();
+    }
+
+    // Persistir lo que quede antes de cerrar
+    flush();
+
+    if (writerDb) {
+        sqlite3_close(writerDb);
+    }
+}
+
+bool QuotaEngine::checkAndRecord(int userId, const std::string& actionType, int count) {
+    int action = actionFromString(actionType);
+    if (action < 0 || count < 1) {
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    UserState& state = getUserState(userId);
+
+    if (now - state.tierCheckedAt.load() >= TIER_REFRESH_SECONDS) {
+        refreshTier(userId, state, now);
+    }
+
+    Counter& daily = state.daily[action];
+    Counter& monthly = state.monthly[action];
+
+    // Los demás tipos de acción no tienen límite todavía; solo se contabilizan
+    int limit = action == QUERY ? state.dailyQueryLimit.load() : -1;
+    if (!tryIncrement(daily, dayWindow(now), limit, count)) {
+        return false;
+    }
+    tryIncrement(monthly, monthWindow(now), -1, count);
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.insert(pending.end(), count, UsageRecord{userId, static_cast<Action>(action), now});
+    }
+
+    return true;
+}
+
+AuthService::UsageStats QuotaEngine::getUsage(int userId) {
+    AuthService::UsageStats stats = {0, 0, 0, 0, 0};
+    long long month = monthWindow(time(nullptr));
+
+    std::shared_lock<std::shared_mutex> lock(usersMutex);
+    auto it = users.find(userId);
+    if (it == users.end()) {
+        return stats;
+    }
+
+    UserState& state = *it->second;
+    stats.queries = currentCount(state.monthly[QUERY], month);
+    stats.documents = currentCount(state.monthly[DOCUMENT], month);
+    stats.openai = currentCount(state.monthly[OPENAI], month);
+    stats.ocr = currentCount(state.monthly[OCR], month);
+    stats.tts = currentCount(state.monthly[TTS], month);
+
+    return stats;
+}
+
+void QuotaEngine::flush() {
+    std::vector<UsageRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        batch.swap(pending);
+    }
+    if (!batch.empty() && !writeBatch(batch)) {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        requeue(batch);
+    }
+}
+
+void QuotaEngine::requeue(std::vector<UsageRecord>& batch) {
+    // Se reintentan en la siguiente escritura, antes que los registros nuevos
+    batch.insert(batch.end(), pending.begin(), pending.end());
+    pending.swap(batch);
+}
+
+int QuotaEngine::actionFromString(const std::string& actionType) {
+    if (actionType == "query") {
+        return QUERY;
+    } else if (actionType == "document") {
+        return DOCUMENT;
+    } else if (actionType == "openai") {
+        return OPENAI;
+    } else if (actionType == "ocr") {
+        return OCR;
+    } else if (actionType == "tts") {
+        return TTS;
+    }
+    return -1;
+}
+
+const char* QuotaEngine::actionName(Action action) {
+    static const char* names[ACTION_COUNT] = {"query", "document", "openai", "ocr", "tts"};
+    return names[action];
+}
+
+long long QuotaEngine::dayWindow(time_t now) {
+    return static_cast<long long>(now / 86400);
+}
+
+long long QuotaEngine::monthWindow(time_t now) {
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    return static_cast<long long>(utc.tm_year) * 12 + utc.tm_mon;
+}
+
+uint64_t QuotaEngine::pack(long long window, int count) {
+    return (static_cast<uint64_t>(window) << 32) | static_cast<uint32_t>(count);
+}
+
+int QuotaEngine::currentCount(const Counter& counter, long long window) {
+    // Una cuenta de otra ventana (día o mes anterior) equivale a cero
+    uint64_t state = counter.state.load();
+    return (state >> 32) == static_cast<uint64_t>(window) ? static_cast<int>(state & 0xffffffffu) : 0;
+}
+
+bool QuotaEngine::tryIncrement(Counter& counter, long long window, int limit, int amount) {
+    uint64_t state = counter.state.load();
+    while (true) {
+        int count = (state >> 32) == static_cast<uint64_t>(window) ? static_cast<int>(state & 0xffffffffu) : 0;
+        if (limit >= 0 && count > limit - amount) {
+            return false;
+        }
+        // El reinicio por cambio de ventana y el incremento son el mismo CAS
+        if (counter.state.compare_exchange_weak(state, pack(window, count + amount))) {
+            return true;
+        }
+    }
+}
+
+QuotaEngine::UserState& QuotaEngine::getUserState(int userId) {
+    {
+        std::shared_lock<std::shared_mutex> lock(usersMutex);
+        auto it = users.find(userId);
+        if (it != users.end()) {
+            return *it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(usersMutex);
+    auto& state = users[userId];
+    if (!state) {
+        state = std::make_unique<UserState>();
+    }
+    return *state;
+}
+
+void QuotaEngine::refreshTier(int userId, UserState& state, time_t now) {
+    // Un solo hilo recarga los límites cuando vencen; los demás siguen con los anteriores
+    time_t loadedAt = limitsLoadedAt.load();
+    if (now - loadedAt >= TIER_REFRESH_SECONDS && limitsLoadedAt.compare_exchange_strong(loadedAt, now)) {
+        loadQuotaLimits(now);
+    }
+
+    std::string tier = "free";
+
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (conn) {
+        auto stmt = conn.prepare("SELECT tier FROM subscriptions WHERE user_id = ? AND end_date > datetime('now') ORDER BY end_date DESC LIMIT 1");
+        if (stmt) {
+            sqlite3_bind_int(stmt.get(), 1, userId);
+            if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+                tier = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+            }
+        }
+    }
+
+    int limit = 0;
+    {
+        std::lock_guard<std::mutex> lock(limitsMutex);
+        auto it = dailyQueryLimits.find(tier);
+        if (it != dailyQueryLimits.end()) {
+            limit = it->second;
+        }
+    }
+
+    state.dailyQueryLimit = limit;
+    state.tierCheckedAt = now;
+}
+
+// Lee la tabla quotas con una conexión del pool (no bloquea la escritura por
+// lotes) y reemplaza los límites; si falla se conservan los anteriores
+void QuotaEngine::loadQuotaLimits(time_t now) {
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    auto stmt = conn.prepare("SELECT tier, daily_queries FROM quotas");
+    if (!stmt) {
+        std::cerr << "Error al cargar los límites de cuota: "
+                  << (conn.db() ? sqlite3_errmsg(conn.db()) : "sin conexión") << std::endl;
+        return;
+    }
+
+    std::unordered_map<std::string, int> limits;
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        std::string tier = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+        limits[tier] = sqlite3_column_int(stmt.get(), 1);
+    }
+
+    std::lock_guard<std::mutex> lock(limitsMutex);
+    dailyQueryLimits.swap(limits);
+    limitsLoadedAt = now;
+}
+
+void QuotaEngine::seedFromDatabase() {
+    std::lock_guard<std::mutex> writerLock(writerMutex);
+
+    // Una sola pasada por el mes en curso: total mensual y parte de hoy
+    const char* sql = "SELECT user_id, action_type, "
+                      "SUM(CASE WHEN timestamp > datetime('now', 'start of day') THEN 1 ELSE 0 END), "
+                      "COUNT(*) "
+                      "FROM usage_records "
+                      "WHERE timestamp > datetime('now', 'start of month') "
+                      "GROUP BY user_id, action_type";
+
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(writerDb, sql, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Error al sembrar los contadores de cuota: " << sqlite3_errmsg(writerDb) << std::endl;
+        return;
+    }
+
+    time_t now = time(nullptr);
+    long long day = dayWindow(now);
+    long long month = monthWindow(now);
+
+    std::unique_lock<std::shared_mutex> lock(usersMutex);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int userId = sqlite3_column_int(stmt, 0);
+        int action = actionFromString(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+        if (action < 0) {
+            continue;
+        }
+
+        auto& state = users[userId];
+        if (!state) {
+            state = std::make_unique<UserState>();
+        }
+
+        state->daily[action].state = pack(day, sqlite3_column_int(stmt, 2));
+        state->monthly[action].state = pack(month, sqlite3_column_int(stmt, 3));
+    }
+
+    sqlite3_finalize(stmt);
+}
+
+void QuotaEngine::flushLoop() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    while (running) {
+        flushSignal.wait_for(lock, std::chrono::milliseconds(flushIntervalMs.load()), [this] { return !running; });
+
+        std::vector<UsageRecord> batch;
+        batch.swap(pending);
+        if (batch.empty()) {
+            continue;
+        }
+
+        lock.unlock();
+        bool written = writeBatch(batch);
+        lock.lock();
+        if (!written) {
+            requeue(batch);
+        }
+    }
+}
+
+bool QuotaEngine::writeBatch(const std::vector<UsageRecord>& batch) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+
+    const char* sql = "INSERT INTO usage_records (user_id, action_type, timestamp) VALUES (?, ?, datetime(?, 'unixepoch'))";
+    sqlite3_stmt* stmt;
+    int rc = sqlite3_prepare_v2(writerDb, sql, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Error al preparar el registro de uso: " << sqlite3_errmsg(writerDb) << std::endl;
+        return false;
+    }
+
+    if (sqlite3_exec(writerDb, "BEGIN", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Error al iniciar el lote de uso: " << sqlite3_errmsg(writerDb) << std::endl;
+        sqlite3_finalize(stmt);
+        return false;
+    }
+
+    // El lote es todo o nada: si falla una fila se deshace y se reintenta entero
+    bool ok = true;
+    for (const auto& record : batch) {
+        sqlite3_bind_int(stmt, 1, record.userId);
+        sqlite3_bind_text(stmt, 2, actionName(record.action), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(record.timestamp));
+
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            std::cerr << "Error al registrar uso: " << sqlite3_errmsg(writerDb) << std::endl;
+            ok = false;
+            break;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (ok && sqlite3_exec(writerDb, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Error al confirmar el lote de uso: " << sqlite3_errmsg(writerDb) << std::endl;
+        ok = false;
+    }
+    if (!ok) {
+        sqlite3_exec(writerDb, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+    return ok;
+}
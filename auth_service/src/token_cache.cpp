@@ -0,0 +1,81 @@
+#include "token_cache.h"
+#include <functional>
+
+TokenCache::TokenCache(size_t capacity, size_t shardCount) {
+    if (shardCount == 0) {
+        shardCount = 1;
+    }
+    for (size_t i = 0; i < shardCount; i++) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    setCapacity(capacity);
+}
+
+TokenCache& TokenCache::instance() {
+    static TokenCache cache;
+    return cache;
+}
+
+void TokenCache::setCapacity(size_t capacity) {
+    size_t perShard = capacity / shards.size();
+    shardCapacity = perShard > 0 ? perShard : 1;
+}
+
+TokenCache::Shard& TokenCache::shardFor(const std::string& token) {
+    return *shards[std::hash<std::string>()(token) % shards.size()];
+}
+
+bool TokenCache::get(const std::string& token, const std::string& secret, AuthService::UserInfo& outUser) {
+    Shard& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // El índice compara el token completo, no solo su hash
+    auto it = shard.index.find(token);
+    if (it == shard.index.end()) {
+        return false;
+    }
+
+    // Los tokens expirados, o verificados con otro secreto, se descartan al consultarlos
+    if (it->second->expiresAt <= time(nullptr) || it->second->secret != secret) {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    outUser = it->second->user;
+    return true;
+}
+
+void TokenCache::put(const std::string& token, const std::string& secret,
+                     const AuthService::UserInfo& user, time_t expiresAt) {
+    Shard& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(token);
+    if (it != shard.index.end()) {
+        it->second->secret = secret;
+        it->second->user = user;
+        it->second->expiresAt = expiresAt;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    shard.entries.push_front({token, secret, user, expiresAt});
+    shard.index[token] = shard.entries.begin();
+
+    // Desalojar los menos usados recientemente
+    size_t capacity = shardCapacity.load();
+    while (shard.entries.size() > capacity) {
+        shard.index.erase(shard.entries.back().token);
+        shard.entries.pop_back();
+    }
+}
+
+void TokenCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->index.clear();
+    }
+}
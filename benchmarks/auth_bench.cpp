@@ -0,0 +1,71 @@
+#include "bench.h"
+#include "auth_service.h"
+#include <sqlite3.h>
+
+// Ruta anterior: abrir, preparar y cerrar la base de datos en cada petición.
+// Se conserva aquí solo como referencia para comparar con el pool.
+static bool legacyValidateAPIKey(const std::string& apiKey, const std::string& dbPath, AuthService::UserInfo& outUser) {
+    sqlite3* db;
+    if (sqlite3_open(dbPath.c_str(), &db)) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    const char* sql = "SELECT u.id, u.username, COALESCE(s.tier, 'free') as tier "
+                      "FROM users u "
+                      "JOIN api_keys k ON u.id = k.user_id "
+                      "LEFT JOIN subscriptions s ON u.id = s.user_id AND s.end_date > datetime('now') "
+                      "WHERE k.api_key = ? AND k.is_active = 1 "
+                      "ORDER BY s.end_date DESC LIMIT 1";
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, apiKey.c_str(), -1, SQLITE_STATIC);
+
+    bool validated = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        outUser.id = sqlite3_column_int(stmt, 0);
+        outUser.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        outUser.subscriptionTier = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        outUser.role = "user";
+
+        sqlite3_finalize(stmt);
+        if (sqlite3_prepare_v2(db, "UPDATE api_keys SET last_used = datetime('now') WHERE api_key = ?", -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, apiKey.c_str(), -1, SQLITE_STATIC);
+            sqlite3_step(stmt);
+        }
+        validated = true;
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return validated;
+}
+
+IAM_BENCHMARK(auth_sqlite_pool) {
+    std::string dbPath = bench::createTestDatabase("auth");
+    const std::string apiKey = "iam_7f8e92a3b5c6d4e2a1f9b8c7d6e5f4a3";
+    AuthService::UserInfo user;
+
+    bench::measure("validateAPIKey (open/prepare/close)", 2000, [&] {
+        legacyValidateAPIKey(apiKey, dbPath, user);
+    });
+    bench::measure("validateAPIKey (caché)", 2000, [&] {
+        AuthService::validateAPIKey(apiKey, dbPath, user);
+    });
+
+    bench::measure("authenticateUser (pool)", 2000, [&] {
+        AuthService::authenticateUser("admin", "admin123", dbPath, user);
+    });
+
+    bench::measure("checkQuotaAndUpdate query (contadores)", 2000, [&] {
+        AuthService::checkQuotaAndUpdate(1, "query", dbPath);
+    });
+    bench::measure("getQuotaLimits (pool)", 2000, [&] {
+        AuthService::getQuotaLimits("enterprise", dbPath);
+    });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+// Mini-arnés de pruebas de rendimiento para iam_bench.
+// Cada archivo de benchmarks/ registra sus casos con IAM_BENCHMARK y
+// bench_main.cpp los ejecuta (opcionalmente filtrados por nombre).
+namespace bench {
+
+struct Case {
+    std::string name;
+    std::function<void()> run;
+};
+
+std::vector<Case>& registry();
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> run) {
+        registry().push_back({name, std::move(run)});
+    }
+};
+
+// Crea una base de datos temporal con el esquema de scripts/setup_db.sh,
+// el usuario admin (enterprise) y su API key. Devuelve la ruta.
+std::string createTestDatabase(const std::string& name);
+
+// Ejecuta fn `iterations` veces y muestra latencia media, p50, p99 y ops/s
+template <typename Fn>
+void measure(const std::string& label, size_t iterations, Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+
+    // Calentamiento
+    for (size_t i = 0; i < iterations / 20 + 1; i++) {
+        fn();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+
+    auto start = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto t0 = clock::now();
+        fn();
+        samples.push_back(std::chrono::duration<double, std::micro>(clock::now() - t0).count());
+    }
+    double totalSeconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+
+    auto percentile = [&](double p) {
+        size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+        return samples[idx];
+    };
+
+    std::cout << std::left << std::setw(44) << label << std::right << std::fixed << std::setprecision(2)
+              << " media " << std::setw(9) << sum / samples.size() << " us"
+              << "  p50 " << std::setw(9) << percentile(0.50) << " us"
+              << "  p99 " << std::setw(9) << percentile(0.99) << " us"
+              << "  " << std::setw(12) << std::setprecision(0) << iterations / totalSeconds << " ops/s"
+              << std::endl;
+}
+
+} // namespace bench
+
+#define IAM_BENCHMARK(name) \
+    static void bench_##name(); \
+    static bench::Registrar registrar_##name(#name, bench_##name); \
+    static void bench_##name()
@@ -0,0 +1,78 @@
+#include "bench.h"
+#include <cstdio>
+#include <sqlite3.h>
+
+namespace bench {
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+std::string createTestDatabase(const std::string& name) {
+    std::string path = "/tmp/iam_bench_" + name + ".db";
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+
+    // Mismo esquema que scripts/setup_db.sh
+    const char* schema =
+        "CREATE TABLE users (id INTEGER PRIMARY KEY AUTOINCREMENT, username TEXT NOT NULL UNIQUE, "
+        "password_hash TEXT NOT NULL, created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, last_login TIMESTAMP);"
+        "CREATE TABLE subscriptions (id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL, tier TEXT NOT NULL, "
+        "start_date TIMESTAMP DEFAULT CURRENT_TIMESTAMP, end_date TIMESTAMP, auto_renew BOOLEAN DEFAULT 0);"
+        "CREATE TABLE api_keys (id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL, api_key TEXT NOT NULL UNIQUE, "
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, last_used TIMESTAMP, is_active BOOLEAN DEFAULT 1);"
+        "CREATE TABLE usage_records (id INTEGER PRIMARY KEY AUTOINCREMENT, user_id INTEGER NOT NULL, action_type TEXT NOT NULL, "
+        "units_used INTEGER DEFAULT 1, timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP);"
+        "CREATE TABLE quotas (tier TEXT PRIMARY KEY, daily_queries INTEGER NOT NULL, monthly_documents INTEGER NOT NULL, "
+        "openai_usage INTEGER NOT NULL, monthly_ocr INTEGER NOT NULL, monthly_tts_minutes INTEGER NOT NULL, "
+        "has_advanced_features BOOLEAN DEFAULT 0);"
+        "CREATE TABLE query_cache (id INTEGER PRIMARY KEY AUTOINCREMENT, query_hash TEXT NOT NULL UNIQUE, query_text TEXT NOT NULL, "
+        "response_text TEXT NOT NULL, confidence FLOAT, last_used TIMESTAMP DEFAULT CURRENT_TIMESTAMP, use_count INTEGER DEFAULT 1, "
+        "valid_until TIMESTAMP);"
+        "CREATE TABLE learning_feedback (id INTEGER PRIMARY KEY AUTOINCREMENT, query_id INTEGER, user_id INTEGER NOT NULL, "
+        "feedback_score INTEGER, feedback_text TEXT, timestamp TIMESTAMP DEFAULT CURRENT_TIMESTAMP);"
+        "CREATE TABLE learned_patterns (id INTEGER PRIMARY KEY AUTOINCREMENT, pattern_type TEXT NOT NULL, pattern_text TEXT NOT NULL, "
+        "response_template TEXT NOT NULL, confidence FLOAT, created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, last_used TIMESTAMP, "
+        "use_count INTEGER DEFAULT 0);"
+        "INSERT INTO quotas VALUES ('free', 10, 2, 5, 5, 10, 0), ('basic', 50, 20, 30, 50, 60, 0), "
+        "('professional', 200, 100, 200, 200, 300, 1), ('enterprise', 1000000, 500, 1000, 1000, 1000, 1);"
+        "INSERT INTO users (id, username, password_hash) VALUES (1, 'admin', 'admin123');"
+        "INSERT INTO subscriptions (user_id, tier, end_date) VALUES (1, 'enterprise', datetime('now', '+10 years'));"
+        "INSERT INTO api_keys (user_id, api_key) VALUES (1, 'iam_7f8e92a3b5c6d4e2a1f9b8c7d6e5f4a3');";
+
+    sqlite3* db;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "No se pudo crear la base de datos de pruebas: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return path;
+    }
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, schema, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Error al crear el esquema de pruebas: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+    }
+    sqlite3_close(db);
+
+    return path;
+}
+
+} // namespace bench
+
+int main(int argc, char** argv) {
+    // Uso: iam_bench [filtro]  — ejecuta solo los casos cuyo nombre contiene el filtro
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    for (const auto& benchCase : bench::registry()) {
+        if (!filter.empty() && benchCase.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        std::cout << "== " << benchCase.name << std::endl;
+        benchCase.run();
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
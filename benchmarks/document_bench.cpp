@@ -0,0 +1,108 @@
+#include "bench.h"
+#include "template_engine.h"
+#include "task_pool.h"
+
+// Rellenado anterior: un find/replace por variable sobre todo el texto
+static std::string legacyFill(const std::string& templ, const std::unordered_map<std::string, std::string>& vars) {
+    std::string result = templ;
+    for (const auto& var : vars) {
+        std::string placeholder = "{{" + var.first + "}}";
+        size_t pos = result.find(placeholder);
+        while (pos != std::string::npos) {
+            result.replace(pos, placeholder.length(), var.second);
+            pos = result.find(placeholder, pos + var.second.length());
+        }
+    }
+    return result;
+}
+
+IAM_BENCHMARK(document_render) {
+    TemplateEngine& engine = TemplateEngine::forPath("document_service/templates");
+    auto document = engine.find("daca_initial_103");
+    if (!document) {
+        std::cerr << "document_render: ejecutar desde la raíz del repositorio" << std::endl;
+        return;
+    }
+
+    nlohmann::json parameters = nlohmann::json::object();
+    for (const auto& field : document->fields) {
+        parameters[field] = "Valor de prueba para " + field;
+    }
+    bench::measure("renderText (" + document->id + ")", 100000, [&] {
+        engine.renderText(*document, parameters);
+    });
+
+    // Plantilla grande con muchas variables, como las respuestas aprendidas
+    std::string templ;
+    std::unordered_map<std::string, std::string> vars;
+    for (int i = 0; i < 200; i++) {
+        std::string name = "campo_" + std::to_string(i);
+        templ += "Sección " + std::to_string(i) + ": {{" + name + "}} y de nuevo {{" + name + "}}.\n";
+        vars[name] = "valor " + std::to_string(i);
+    }
+    bench::measure("fill find/replace (200 variables)", 2000, [&] {
+        legacyFill(templ, vars);
+    });
+    CompiledTemplate compiled = CompiledTemplate::compile(templ);
+    bench::measure("CompiledTemplate::render (200 variables)", 2000, [&] {
+        compiled.render(vars);
+    });
+    bench::measure("compile + render (200 variables)", 2000, [&] {
+        CompiledTemplate::compile(templ).render(vars);
+    });
+}
+
+IAM_BENCHMARK(template_catalog) {
+    const std::string templatesPath = "document_service/templates";
+    const std::string catalogPath = "/tmp/iam_bench_templates.cat";
+
+    auto documents = TemplateEngine::loadDirectory(templatesPath);
+    if (documents.empty() || !TemplateCatalog::write(catalogPath, documents, TemplateCatalog::fingerprintOf(templatesPath))) {
+        std::cerr << "template_catalog: ejecutar desde la raíz del repositorio" << std::endl;
+        return;
+    }
+
+    bench::measure("loadDirectory (" + std::to_string(documents.size()) + " JSON)", 20, [&] {
+        TemplateEngine::loadDirectory(templatesPath);
+    });
+    bench::measure("TemplateCatalog::open + ids()", 2000, [&] {
+        TemplateCatalog::open(catalogPath)->ids();
+    });
+    auto catalog = TemplateCatalog::open(catalogPath);
+    std::vector<std::string> questions;
+    bench::measure("TemplateCatalog::questions", 100000, [&] {
+        catalog->questions("daca_initial_103", questions);
+    });
+}
+
+IAM_BENCHMARK(document_batch) {
+    TemplateEngine& engine = TemplateEngine::forPath("document_service/templates");
+    std::vector<std::shared_ptr<const DocumentTemplate>> documents;
+    for (const auto& id : engine.templateIds()) {
+        documents.push_back(engine.find(id));
+    }
+    if (documents.empty()) {
+        std::cerr << "document_batch: ejecutar desde la raíz del repositorio" << std::endl;
+        return;
+    }
+
+    // Un lote de 256 documentos con todos los campos rellenos
+    std::vector<nlohmann::json> parameters(documents.size(), nlohmann::json::object());
+    for (size_t d = 0; d < documents.size(); d++) {
+        for (const auto& field : documents[d]->fields) {
+            parameters[d][field] = "Valor de prueba para " + field;
+        }
+    }
+    const size_t batchSize = 256;
+
+    bench::measure("lote de 256 en serie", 200, [&] {
+        for (size_t i = 0; i < batchSize; i++) {
+            engine.renderText(*documents[i % documents.size()], parameters[i % documents.size()]);
+        }
+    });
+    bench::measure("lote de 256 en TaskPool (" + std::to_string(TaskPool::shared().threadCount()) + " hilos)", 200, [&] {
+        TaskPool::shared().parallelFor(batchSize, [&](size_t i) {
+            engine.renderText(*documents[i % documents.size()], parameters[i % documents.size()]);
+        });
+    });
+}
@@ -0,0 +1,41 @@
+#include "bench.h"
+#include "auth_service.h"
+#include "token_cache.h"
+
+IAM_BENCHMARK(auth_jwt) {
+    const std::string secret = "iam_secret_key_change_in_production";
+
+    AuthService::UserInfo user;
+    user.id = 1;
+    user.username = "admin";
+    user.subscriptionTier = "enterprise";
+    user.role = "admin";
+
+    std::string token = AuthService::generateJWT(user, secret, 24);
+    AuthService::UserInfo decoded;
+    time_t expiry;
+
+    // Un solo hilo: las ops/s equivalen a validaciones por segundo por núcleo
+    bench::measure("generateJWT", 100000, [&] {
+        AuthService::generateJWT(user, secret, 24);
+    });
+    bench::measure("verifyJWT (HMAC + JSON, sin caché)", 100000, [&] {
+        AuthService::verifyJWT(token, secret, decoded, expiry);
+    });
+    bench::measure("validateJWT (caché de tokens)", 1000000, [&] {
+        AuthService::validateJWT(token, secret, decoded);
+    });
+
+    // Peor caso: tokens distintos que siempre fallan en la caché
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 1000; i++) {
+        user.id = i;
+        tokens.push_back(AuthService::generateJWT(user, secret, 24));
+    }
+    size_t next = 0;
+    TokenCache::instance().setCapacity(16);
+    bench::measure("validateJWT (fallos de caché)", 100000, [&] {
+        AuthService::validateJWT(tokens[next++ % tokens.size()], secret, decoded);
+    });
+    TokenCache::instance().setCapacity(65536);
+}
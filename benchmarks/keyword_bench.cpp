@@ -0,0 +1,88 @@
+#include "bench.h"
+#include "keyword_dictionary.h"
+#include "query_normalizer.h"
+#include <algorithm>
+#include <regex>
+
+namespace {
+
+// Implementación anterior de IAMigranteClient::detectIntentFromQuery
+std::string legacyDetectIntent(const std::string& query) {
+    std::string lowerQuery = query;
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+
+    if (lowerQuery.find("visa") != std::string::npos) {
+        return "visa_info";
+    } else if (lowerQuery.find("ciudadania") != std::string::npos ||
+               lowerQuery.find("ciudadanía") != std::string::npos ||
+               lowerQuery.find("citizenship") != std::string::npos) {
+        return "citizenship";
+    } else if (lowerQuery.find("green card") != std::string::npos ||
+               lowerQuery.find("residencia") != std::string::npos) {
+        return "green_card";
+    } else if (lowerQuery.find("asilo") != std::string::npos ||
+               lowerQuery.find("asylum") != std::string::npos) {
+        return "asylum";
+    } else if (lowerQuery.find("deportacion") != std::string::npos ||
+               lowerQuery.find("deportación") != std::string::npos ||
+               lowerQuery.find("deportation") != std::string::npos) {
+        return "deportation";
+    } else if (lowerQuery.find("daca") != std::string::npos) {
+        return "daca";
+    } else if (lowerQuery.find("tps") != std::string::npos) {
+        return "tps";
+    } else if (lowerQuery.find("i-") != std::string::npos) {
+        std::regex formRegex("i-[0-9]+");
+        std::smatch match;
+        if (std::regex_search(lowerQuery, match, formRegex)) {
+            return match.str(0);
+        }
+    }
+    return "general_immigration";
+}
+
+// Implementación anterior de IAMigranteClient::extractKeywords
+std::vector<std::string> legacyExtractKeywords(const std::string& query) {
+    std::vector<std::string> keywords;
+    std::string lowerQuery = query;
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+
+    std::vector<std::string> keywordList = {
+        "visa", "green card", "ciudadania", "ciudadanía", "citizenship",
+        "residencia", "asilo", "asylum", "deportacion", "deportación",
+        "deportation", "daca", "tps", "i-130", "i-485", "i-765", "i-601",
+        "i-751", "n-400", "eb1", "eb2", "eb3", "eb4", "eb5", "h1b",
+        "h2a", "h2b", "j1", "f1", "b1", "b2"
+    };
+    for (const auto& keyword : keywordList) {
+        if (lowerQuery.find(keyword) != std::string::npos) {
+            keywords.push_back(keyword);
+        }
+    }
+    return keywords;
+}
+
+} // namespace
+
+IAM_BENCHMARK(keyword_scan) {
+    const std::vector<std::string> queries = {
+        "¿Cuánto tarda el formulario I-485 después de la entrevista?",
+        "Necesito información sobre la visa de trabajo H1B",
+        "How long does the naturalization process take after filing the N-400?",
+        "Mi permiso de trabajo venció y tengo una audiencia de deportación"
+    };
+    size_t next = 0;
+
+    bench::measure("detectIntent + extractKeywords (anterior)", 100000, [&] {
+        const std::string& query = queries[next++ % queries.size()];
+        legacyDetectIntent(query);
+        legacyExtractKeywords(query);
+    });
+
+    auto dictionary = KeywordDictionary::builtin();
+    std::string normalized;
+    bench::measure("KeywordDictionary::scan (normalización incluida)", 1000000, [&] {
+        QueryNormalizer::normalize(queries[next++ % queries.size()], normalized);
+        dictionary->scan(normalized);
+    });
+}
@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "knowledge_index.h"
+#include "ia_migrante_client.h"
+#include <random>
+
+namespace {
+
+// Base de conocimiento sintética: categorías con respuestas de ~60 palabras
+KnowledgeIndex::Categories syntheticKnowledge(size_t categories, size_t perCategory) {
+    const std::vector<std::string> vocabulary = {
+        "visa", "residencia", "permiso", "trabajo", "asilo", "familia", "formulario", "entrevista",
+        "consulado", "ciudadania", "naturalizacion", "deportacion", "audiencia", "juez", "abogado",
+        "empleador", "peticion", "estatus", "ajuste", "renovacion", "pasaporte", "estudiante",
+        "turista", "inversion", "refugiado", "proteccion", "temporal", "permanente", "tarjeta",
+        "solicitud", "cuota", "documentos", "evidencia", "matrimonio", "hijos", "padres", "fecha",
+        "prioridad", "boletin", "uscis", "daca", "tps", "i-130", "i-485", "i-765", "n-400", "h1b"
+    };
+
+    std::mt19937 rng(42);
+    KnowledgeIndex::Categories data;
+    for (size_t c = 0; c < categories; c++) {
+        auto& responses = data["categoria_" + std::to_string(c)];
+        for (size_t r = 0; r < perCategory; r++) {
+            std::string text;
+            for (int w = 0; w < 60; w++) {
+                text += vocabulary[rng() % vocabulary.size()] + " ";
+            }
+            responses.push_back(text + "termino" + std::to_string(c * perCategory + r));
+        }
+    }
+    return data;
+}
+
+// Recorrido anterior de KnowledgeBase::findResponse cuando falla la intención
+const std::string* legacyFindResponse(const KnowledgeIndex::Categories& data, const std::vector<std::string>& keywords) {
+    for (const auto& keyword : keywords) {
+        for (const auto& category : data) {
+            for (const auto& response : category.second) {
+                if (response.find(keyword) != std::string::npos) {
+                    return &response;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+IAM_BENCHMARK(knowledge_search) {
+    KnowledgeIndex::Categories data = syntheticKnowledge(50, 100);
+    KnowledgeIndex index(data);
+
+    // Palabras clave que no aparecen: el peor caso recorre todas las respuestas
+    std::vector<std::string> missing = {"arraigo", "schengen", "nie"};
+
+    bench::measure("findResponse (bucle anterior, 5000 respuestas, sin acierto)", 2000, [&] {
+        legacyFindResponse(data, missing);
+    });
+    bench::measure("KnowledgeIndex::search (5000 respuestas, sin acierto)", 100000, [&] {
+        index.search("arraigo schengen nie", 3);
+    });
+    bench::measure("KnowledgeIndex::search (5000 respuestas, top 3)", 2000, [&] {
+        index.search("renovacion del permiso de trabajo termino4321", 3);
+    });
+}
+
+IAM_BENCHMARK(knowledge_base) {
+    // Base de conocimiento real del repositorio (ejecutar desde la raíz)
+    KnowledgeBase& kb = KnowledgeBase::forPath("ia_migrante_engine/data");
+    const std::vector<std::string> keywords = {"permiso de trabajo", "i-765"};
+
+    bench::measure("KnowledgeBase::findResponse (intención conocida)", 100000, [&] {
+        kb.findResponse("green_card", keywords, "es");
+    });
+    bench::measure("KnowledgeBase::findResponse (por palabras clave)", 100000, [&] {
+        kb.findResponse("general_immigration", keywords, "es");
+    });
+    bench::measure("IAMigranteClient::processQuery", 50000, [&] {
+        IAMigranteClient::processQuery("¿Cómo renuevo mi permiso de trabajo?", "es", kb);
+    });
+}
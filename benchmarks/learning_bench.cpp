@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "learning_engine.h"
+#include <sqlite3.h>
+
+namespace {
+
+// Ruta anterior: INSERT OR REPLACE con subconsulta correlacionada y su propia
+// transacción implícita (un fsync por consulta), dentro de la petición.
+void legacyRecordInteraction(sqlite3* db, const std::string& queryHash, const std::string& query,
+                             const std::string& response, float confidence) {
+    const char* sql = "INSERT OR REPLACE INTO query_cache (query_hash, query_text, response_text, confidence, last_used, use_count, valid_until) "
+                      "VALUES (?, ?, ?, ?, datetime('now'), COALESCE((SELECT use_count + 1 FROM query_cache WHERE query_hash = ?), 1), datetime('now', '+3 days'))";
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, queryHash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, query.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, response.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 4, confidence);
+    sqlite3_bind_text(stmt, 5, queryHash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+} // namespace
+
+IAM_BENCHMARK(learning_record) {
+    std::string dbPath = bench::createTestDatabase("learning");
+    const std::string response = "Para solicitar la residencia permanente necesita presentar el formulario I-485.";
+    size_t next = 0;
+
+    sqlite3* db;
+    sqlite3_open(dbPath.c_str(), &db);
+    bench::measure("recordInteraction (síncrono, anterior)", 2000, [&] {
+        std::string query = "consulta de prueba " + std::to_string(next++ % 500);
+        legacyRecordInteraction(db, std::to_string(std::hash<std::string>()(query)), query, response, 0.8f);
+    });
+    sqlite3_close(db);
+
+    LearningEngine engine(dbPath);
+    bench::measure("recordInteraction (cola de escritura diferida)", 20000, [&] {
+        engine.recordInteraction("consulta de prueba " + std::to_string(next++ % 500), response, 0.8f);
+    });
+    bench::measure("recordFeedback (cola de escritura diferida)", 20000, [&] {
+        engine.recordFeedback(static_cast<int>(next++ % 500) + 1, 1, 3, "");
+    });
+
+    auto stats = engine.getStatistics();
+    std::cout << "  eventos escritos " << stats.eventsWritten << " en " << stats.eventBatches
+              << " lotes, cola llena " << stats.eventQueueFull << " veces, descartados "
+              << stats.eventsDropped << std::endl;
+}
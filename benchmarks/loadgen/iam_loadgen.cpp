@@ -0,0 +1,236 @@
+#include "metrics.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Generador de carga de tasa fija para iam_api.
+// Reproduce una mezcla de peticiones grabada (JSONL) a un ritmo constante. La
+// petición i tiene una hora prevista start + i/rate; la latencia se mide desde
+// esa hora y no desde el envío real, así que si el servidor se atasca y las
+// conexiones no llegan a tiempo, la espera cuenta en los percentiles
+// (corrección de la omisión coordinada). También se informa del tiempo de
+// servicio sin corregir para comparar.
+
+namespace {
+
+struct Request {
+    std::string method;
+    std::string path;
+    std::string body;
+};
+
+struct Options {
+    std::string url = "http://127.0.0.1:8080";
+    std::string mixPath = "benchmarks/loadgen/query_mix.jsonl";
+    std::string apiKey = "iam_7f8e92a3b5c6d4e2a1f9b8c7d6e5f4a3";
+    double rate = 100.0;         // Peticiones por segundo
+    double durationSeconds = 30.0;
+    double warmupSeconds = 5.0;  // No se cuentan en los resultados
+    int connections = 16;
+    long timeoutMs = 10000;
+};
+
+void usage() {
+    std::cerr << "Uso: iam_loadgen [--url URL] [--mix archivo.jsonl] [--rate N] [--duration S]\n"
+              << "                 [--warmup S] [--connections N] [--api-key KEY] [--timeout-ms N]\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--url") {
+            options.url = value;
+        } else if (arg == "--mix") {
+            options.mixPath = value;
+        } else if (arg == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (arg == "--duration") {
+            options.durationSeconds = std::atof(value.c_str());
+        } else if (arg == "--warmup") {
+            options.warmupSeconds = std::atof(value.c_str());
+        } else if (arg == "--connections") {
+            options.connections = std::atoi(value.c_str());
+        } else if (arg == "--api-key") {
+            options.apiKey = value;
+        } else if (arg == "--timeout-ms") {
+            options.timeoutMs = std::atol(value.c_str());
+        } else {
+            return false;
+        }
+    }
+    return options.rate > 0 && options.durationSeconds > 0 && options.connections > 0;
+}
+
+// Cada línea: {"method", "path", "body" (opcional), "weight" (opcional)}.
+// El peso repite la entrada; el orden de reproducción es el del archivo.
+bool loadMix(const std::string& path, std::vector<Request>& mix) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "No se pudo abrir la mezcla de peticiones: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            json entry = json::parse(line);
+            Request request;
+            request.method = entry.value("method", "GET");
+            request.path = entry.at("path").get<std::string>();
+            if (entry.contains("body")) {
+                request.body = entry["body"].is_string() ? entry["body"].get<std::string>() : entry["body"].dump();
+            }
+            int weight = std::max(1, entry.value("weight", 1));
+            for (int w = 0; w < weight; w++) {
+                mix.push_back(request);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Línea " << lineNumber << " inválida en " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    return !mix.empty();
+}
+
+size_t discardBody(char* /*data*/, size_t size, size_t count, void* /*userdata*/) {
+    return size * count;
+}
+
+void printLatencies(const std::string& label, const LatencyHistogram::Snapshot& snapshot) {
+    auto millis = [](uint64_t micros) { return micros / 1000.0; };
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(2)
+              << " p50 " << std::setw(9) << millis(snapshot.percentile(0.50)) << " ms"
+              << "  p90 " << std::setw(9) << millis(snapshot.percentile(0.90)) << " ms"
+              << "  p99 " << std::setw(9) << millis(snapshot.percentile(0.99)) << " ms"
+              << "  p99.9 " << std::setw(9) << millis(snapshot.percentile(0.999)) << " ms"
+              << "  max " << std::setw(9) << millis(snapshot.maxMicros) << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+
+    std::vector<Request> mix;
+    if (!loadMix(options.mixPath, mix)) {
+        return 1;
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    using clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration<double>(1.0 / options.rate);
+    const size_t total = static_cast<size_t>((options.warmupSeconds + options.durationSeconds) * options.rate);
+    const size_t warmupRequests = static_cast<size_t>(options.warmupSeconds * options.rate);
+
+    LatencyHistogram corrected;
+    LatencyHistogram service;
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> completed(0);
+    std::atomic<size_t> errors(0);
+    std::atomic<size_t> late(0);
+
+    std::cout << "iam_loadgen: " << options.url << ", " << mix.size() << " peticiones en la mezcla, "
+              << options.rate << " req/s durante " << options.durationSeconds << " s (+" << options.warmupSeconds
+              << " s de calentamiento), " << options.connections << " conexiones" << std::endl;
+
+    const auto start = clock::now() + std::chrono::milliseconds(100);
+
+    std::vector<std::thread> workers;
+    for (int c = 0; c < options.connections; c++) {
+        workers.emplace_back([&]() {
+            // Un handle por conexión: reutiliza la conexión HTTP (keep-alive)
+            CURL* curl = curl_easy_init();
+            struct curl_slist* headers = nullptr;
+            headers = curl_slist_append(headers, "Content-Type: application/json");
+            headers = curl_slist_append(headers, ("X-API-Key: " + options.apiKey).c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discardBody);
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, options.timeoutMs);
+            curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+            size_t i;
+            while ((i = next.fetch_add(1)) < total) {
+                auto intended = start + std::chrono::duration_cast<clock::duration>(interval * static_cast<double>(i));
+                if (clock::now() < intended) {
+                    std::this_thread::sleep_until(intended);
+                } else if (clock::now() - intended > std::chrono::milliseconds(1)) {
+                    late++;
+                }
+
+                const Request& request = mix[i % mix.size()];
+                std::string url = options.url + request.path;
+                curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+                if (request.body.empty()) {
+                    // HTTPGET reinicia el método; CUSTOMREQUEST lo fija después
+                    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+                    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+                } else {
+                    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+                    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+                    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.size()));
+                }
+
+                auto sent = clock::now();
+                CURLcode rc = curl_easy_perform(curl);
+                auto done = clock::now();
+
+                long status = 0;
+                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+                if (rc != CURLE_OK || status < 200 || status >= 300) {
+                    errors++;
+                }
+
+                if (i >= warmupRequests) {
+                    corrected.record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(done - intended).count()));
+                    service.record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(done - sent).count()));
+                    completed++;
+                }
+            }
+
+            curl_slist_free_all(headers);
+            curl_easy_cleanup(curl);
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count() - options.warmupSeconds;
+
+    curl_global_cleanup();
+
+    std::cout << "completadas " << completed << ", errores " << errors << ", enviadas tarde " << late
+              << ", tasa real " << std::fixed << std::setprecision(1) << completed / std::max(elapsed, 1e-9)
+              << " req/s" << std::endl;
+    printLatencies("latencia (corregida)", corrected.snapshot());
+    printLatencies("servicio (sin corregir)", service.snapshot());
+
+    return errors > 0 ? 2 : 0;
+}
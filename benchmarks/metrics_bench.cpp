@@ -0,0 +1,33 @@
+#include "bench.h"
+#include "metrics.h"
+#include <thread>
+
+IAM_BENCHMARK(metrics_record) {
+    LatencyHistogram& histogram = Metrics::stage("bench");
+    uint64_t value = 0;
+
+    bench::measure("LatencyHistogram::record", 1000000, [&] {
+        histogram.record(value++ & 0xFFFF);
+    });
+    bench::measure("Metrics::ScopedTimer", 1000000, [&] {
+        Metrics::ScopedTimer timer(histogram);
+    });
+    bench::measure("Metrics::request (búsqueda por ruta)", 1000000, [&] {
+        Metrics::request("POST /api/v1/immigration/query");
+    });
+
+    // Cuatro hilos registrando a la vez en el mismo histograma
+    bench::measure("LatencyHistogram::record x4 hilos (por lote de 100k)", 20, [&] {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&histogram] {
+                for (uint64_t i = 0; i < 100000; i++) {
+                    histogram.record(i & 0xFFFF);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    });
+}
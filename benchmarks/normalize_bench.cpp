@@ -0,0 +1,114 @@
+#include "bench.h"
+#include "query_normalizer.h"
+#include <algorithm>
+#include <regex>
+#include <sstream>
+#include <iomanip>
+#include <openssl/sha.h>
+
+namespace {
+
+// Consultas reales de usuarios (mezcla de español e inglés)
+const std::vector<std::string> CORPUS = {
+    "¿Cómo renuevo mi residencia temporal?",
+    "¿Qué documentos necesito para la ciudadanía?",
+    "Necesito información sobre la visa de trabajo H-1B",
+    "¿Cuánto tarda el trámite de naturalización???",
+    "How do I apply for a green card through my employer?",
+    "What documents do I need for asylum?",
+    "¡Me negaron la visa! ¿Qué puedo hacer ahora?",
+    "¿Puedo trabajar mientras espero mi permiso de residencia?",
+    "Requisitos para la reunificación familiar en España",
+    "¿Dónde presento la solicitud de asilo político?",
+    "Mi pasaporte vence el próximo mes, ¿afecta a mi visado?",
+    "How long does the naturalization process take?",
+    "¿Cuál es el costo del formulario I-485?",
+    "Tengo una orden de deportación, ¿qué opciones tengo?",
+    "¿Es posible cambiar de visa de estudiante a visa de trabajo?",
+    "What is the difference between a visa and a residence permit?",
+    "¿Necesito traducción jurada de mi acta de nacimiento?",
+    "Quiero traer a mi esposa e hijos, ¿cómo empiezo?",
+    "¿Qué pasa si mi solicitud de TPS fue rechazada...",
+    "Can I travel abroad while my green card application is pending?",
+    "¿Cuáles son los requisitos del arraigo social?",
+    "Información sobre la regularización extraordinaria 2024",
+    "¿Cómo obtengo el NIE si estoy en situación irregular?",
+    "My work permit expired — what should I do?",
+    "¿Puedo solicitar la nacionalidad después de 10 años de residencia?",
+    "Necesito una cita en extranjería urgente!!!",
+    "¿El examen de ciudadanía es en inglés o en español?",
+    "DACA renewal: ¿cuándo debo enviar los documentos?",
+    "¿Qué es el formulario N-400 y dónde lo consigo?",
+    "How do I check the status of my USCIS case?",
+    "Me casé con un ciudadano, ¿puedo ajustar mi estatus?",
+    "¿Se puede apelar una negación de asilo?",
+    "Requisitos de ingresos para patrocinar a un familiar (I-864)",
+    "¿Qué significa «residencia permanente condicional»?",
+    "Is it possible to get a visa without a job offer?",
+    "¿Cuánto cuesta renovar la tarjeta de residencia?   ",
+    "   ¿Necesito abogado para el proceso de asilo?",
+    "¿Dónde encuentro información oficial sobre visados Schengen?",
+    "Mi empleador no quiere firmar los papeles, ¿qué hago?",
+    "¿Cómo solicito el permiso de reingreso (reentry permit)?"
+};
+
+// Implementación anterior de LearningEngine::normalizeQuery/hashQuery
+std::string legacyNormalizeQuery(const std::string& query) {
+    std::string result = query;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+
+    std::string accents = "áéíóúüñÁÉÍÓÚÜÑ";
+    std::string replacements = "aeiouunAEIOUUN";
+    for (size_t i = 0; i < result.length(); i++) {
+        size_t pos = accents.find(result[i]);
+        if (pos != std::string::npos) {
+            result[i] = replacements[pos];
+        }
+    }
+
+    std::regex punct_re("[!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~]{2,}");
+    result = std::regex_replace(result, punct_re, " ");
+    std::regex space_re("\\s+");
+    result = std::regex_replace(result, space_re, " ");
+    result = std::regex_replace(result, std::regex("^\\s+|\\s+$"), "");
+    return result;
+}
+
+std::string legacyHashQuery(const std::string& query) {
+    std::string normalized = legacyNormalizeQuery(query);
+
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(normalized.data()), normalized.size(), hash);
+
+    std::stringstream ss;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    }
+    return ss.str();
+}
+
+} // namespace
+
+IAM_BENCHMARK(query_normalize) {
+    size_t next = 0;
+    std::string normalized, hex;
+
+    bench::measure("normalizeQuery (regex, anterior)", 20000, [&] {
+        legacyNormalizeQuery(CORPUS[next++ % CORPUS.size()]);
+    });
+    bench::measure("QueryNormalizer::normalize", 1000000, [&] {
+        QueryNormalizer::normalize(CORPUS[next++ % CORPUS.size()], normalized);
+    });
+
+    bench::measure("hashQuery (regex + SHA-256 + stringstream, anterior)", 20000, [&] {
+        legacyHashQuery(CORPUS[next++ % CORPUS.size()]);
+    });
+    bench::measure("hashQuery (normalize + SHA-256)", 1000000, [&] {
+        QueryNormalizer::normalize(CORPUS[next++ % CORPUS.size()], normalized);
+        QueryNormalizer::hash(normalized, QueryNormalizer::HashMode::SHA256, hex);
+    });
+    bench::measure("hashQuery (normalize + MurmurHash3 128)", 1000000, [&] {
+        QueryNormalizer::normalize(CORPUS[next++ % CORPUS.size()], normalized);
+        QueryNormalizer::hash(normalized, QueryNormalizer::HashMode::FAST128, hex);
+    });
+}
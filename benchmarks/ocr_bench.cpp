@@ -0,0 +1,64 @@
+#include "bench.h"
+#include "field_extractor.h"
+#include <regex>
+#include <unordered_map>
+
+// Extracción anterior: seis std::regex construidas en cada llamada
+static std::unordered_map<std::string, std::string> legacyExtract(const std::string& text) {
+    std::unordered_map<std::string, std::string> fields;
+    std::regex nameRegex("Applicant:\\s*([A-Z\\s]+)");
+    std::regex aNumberRegex("A-Number:\\s*(A[0-9]+)");
+    std::regex dobRegex("Date of Birth:\\s*([0-9]{2}/[0-9]{2}/[0-9]{4})");
+    std::regex countryRegex("Country of Birth:\\s*([A-Z\\s]+)");
+    std::regex receiptRegex("Receipt Number:\\s*([A-Z0-9]+)");
+    std::regex priorityRegex("Priority Date:\\s*([0-9]{2}/[0-9]{2}/[0-9]{4})");
+
+    std::smatch match;
+    for (auto* rule : {&nameRegex, &aNumberRegex, &dobRegex, &countryRegex, &receiptRegex, &priorityRegex}) {
+        if (std::regex_search(text, match, *rule) && match.size() > 1) {
+            fields[std::to_string(fields.size())] = match[1];
+        }
+    }
+    return fields;
+}
+
+IAM_BENCHMARK(ocr_fields) {
+    FieldExtractor& extractor = FieldExtractor::forPath("legal_ocr_service/data/field_rules.json");
+    if (extractor.ruleCount() == 0) {
+        std::cerr << "ocr_fields: ejecutar desde la raíz del repositorio" << std::endl;
+        return;
+    }
+
+    // Expediente I-485: los datos en la primera página y 20 más de texto corrido
+    std::string text = "DEPARTMENT OF HOMELAND SECURITY\n"
+                       "U.S. Citizenship and Immigration Services\n\n"
+                       "I-485, APPLICATION TO REGISTER PERMANENT RESIDENCE\n\n"
+                       "Applicant: JOHN DOE\n"
+                       "A-Number: A123456789\n"
+                       "Date of Birth: 01/01/1980\n"
+                       "Country of Birth: MEXICO\n"
+                       "Current Status: B-2 VISITOR\n"
+                       "Receipt Number: MSC2109876543\n"
+                       "Priority Date: 06/15/2018\n\n";
+    const std::string firstPage = text;
+    bench::measure("extractFields con std::regex (1 página)", 2000, [&] {
+        legacyExtract(firstPage);
+    });
+    bench::measure("FieldExtractor::extract (1 página)", 100000, [&] {
+        extractor.extract(firstPage);
+    });
+
+    for (int page = 0; page < 20; page++) {
+        for (int line = 0; line < 40; line++) {
+            text += "Part " + std::to_string(page) + ". Information about your eligibility category and "
+                    "immigration history, including prior applications and petitions filed on your behalf.\n";
+        }
+    }
+
+    bench::measure("extractFields con std::regex (21 páginas)", 50, [&] {
+        legacyExtract(text);
+    });
+    bench::measure("FieldExtractor::extract (21 páginas)", 2000, [&] {
+        extractor.extract(text);
+    });
+}
@@ -0,0 +1,35 @@
+#include "bench.h"
+#include "learning_engine.h"
+
+IAM_BENCHMARK(learning_find_pattern) {
+    std::string dbPath = bench::createTestDatabase("patterns");
+    LearningEngine engine(dbPath);
+
+    // Patrones con la forma que genera extractPossiblePatterns
+    const std::vector<std::string> keywords = {
+        "visa", "residencia", "asilo", "ciudadania", "deportacion", "daca", "tps", "i-485",
+        "i-130", "n-400", "h1b", "permiso de trabajo", "green card", "naturalizacion"
+    };
+    for (size_t i = 0; i < keywords.size(); i++) {
+        for (size_t j = i + 1; j < keywords.size(); j++) {
+            engine.learnNewPattern(".*(" + keywords[i] + "|" + keywords[j] + ").*",
+                                   "Respuesta sobre " + keywords[i] + " y " + keywords[j]);
+        }
+    }
+
+    const std::vector<std::string> queries = {
+        "¿Cómo renuevo mi permiso de trabajo?",
+        "Necesito información sobre la visa de trabajo H1B",
+        "How long does the naturalization process take?",
+        "¿Cuánto cuesta enviar el formulario I-485?"
+    };
+    size_t next = 0;
+
+    engine.recordInteraction(queries[0], "Respuesta en caché", 0.9f);
+    bench::measure("findMatchingPattern (acierto en caché)", 100000, [&] {
+        engine.findMatchingPattern(queries[0]);
+    });
+    bench::measure("findMatchingPattern (" + std::to_string(keywords.size() * (keywords.size() - 1) / 2) + " patrones)", 20000, [&] {
+        engine.findMatchingPattern(queries[1 + next++ % (queries.size() - 1)]);
+    });
+}
@@ -0,0 +1,23 @@
+#include "bench.h"
+#include "tts_client.h"
+
+IAM_BENCHMARK(tts_synthesize) {
+    TTSClient::TTSOptions options;
+    options.voice = "es_female";
+    options.speed = 1.0f;
+    options.format = TTSClient::AudioFormat::WAV;
+    options.sampleRate = 22050;
+
+    const std::string shortText = "Su cita está programada para el lunes.";
+    std::string longText;
+    for (int i = 0; i < 40; i++) {
+        longText += "Para solicitar la residencia permanente debe presentar el formulario I-485. ";
+    }
+
+    bench::measure("TTSClient::synthesizeSpeech (7 palabras)", 2000, [&] {
+        TTSClient::synthesizeSpeech(shortText, options);
+    });
+    bench::measure("TTSClient::synthesizeSpeech (400 palabras)", 200, [&] {
+        TTSClient::synthesizeSpeech(longText, options);
+    });
+}
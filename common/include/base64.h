@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Decodificación base64 para los archivos que llegan en JSON (file_data).
+// Acepta el alfabeto estándar y el url-safe, relleno '=' opcional, espacios
+// y saltos de línea intermedios, y un prefijo "data:<tipo>;base64,".
+class Base64 {
+public:
+    // false si hay caracteres inválidos o la longitud no es decodificable
+    static bool decode(const std::string& input, std::vector<uint8_t>& output);
+
+    // Tamaño máximo de los datos decodificados (para reservar o limitar antes de decodificar)
+    static size_t decodedSizeBound(size_t encodedLength) { return encodedLength / 4 * 3 + 3; }
+};
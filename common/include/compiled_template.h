@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class TemplateCatalog;
+
+// Texto con marcadores {{nombre}} compilado una sola vez en segmentos
+// literales y huecos. Renderizar es una pasada lineal: se resuelve cada hueco
+// una vez, se reserva el tamaño exacto y se copian los segmentos al búfer de
+// salida, sin búsquedas ni reemplazos sobre el texto.
+class CompiledTemplate {
+public:
+    // Qué escribir en un hueco sin valor
+    enum class Missing {
+        EMPTY,        // Nada
+        KEEP          // El marcador original, p. ej. "{{nombre}}"
+    };
+
+    static CompiledTemplate compile(const std::string& text);
+
+    // Nombres de los huecos distintos, en orden de aparición
+    const std::vector<std::string>& slots() const { return slotNames; }
+
+    // values[i] es el valor del hueco slots()[i] (nullptr = sin valor)
+    void renderTo(std::string& out, const std::vector<const std::string*>& values, Missing missing) const;
+    size_t renderedSize(const std::vector<const std::string*>& values, Missing missing) const;
+
+    std::string render(const std::unordered_map<std::string, std::string>& vars,
+                       Missing missing = Missing::KEEP) const;
+
+private:
+    struct Segment {
+        size_t offset;   // En literals
+        size_t length;
+        int slot;        // -1 = literal
+    };
+
+    // El catálogo binario guarda y reconstruye los segmentos tal cual
+    friend class TemplateCatalog;
+
+    std::string literals;
+    std::vector<Segment> segments;
+    std::vector<std::string> slotNames;
+};
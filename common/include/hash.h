@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Hashes no criptográficos para claves de caché (documentos, OCR, consultas).
+class Hash {
+public:
+    // MurmurHash3_x64_128 (dominio público, Austin Appleby)
+    static void murmur3_128(const void* data, size_t length, uint32_t seed, uint64_t out[2]);
+
+    // MurmurHash3 de 128 bits en 32 caracteres hexadecimales
+    static void hex128(std::string_view data, std::string& outHex);
+    static std::string hex128(std::string_view data);
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Cliente HTTP compartido por los clientes de servicios (document_service,
+// openai_bridge). Los handles de curl se toman de un pool del proceso y se
+// devuelven al terminar, y todos comparten la caché de conexiones, DNS y
+// sesiones TLS, así que las peticiones reutilizan conexiones keep-alive (y
+// multiplexan sobre HTTP/2 cuando el servidor lo admite) en lugar de abrir
+// una conexión TCP nueva cada vez.
+class HttpClient {
+public:
+    struct Options {
+        long timeoutMs = 10000;
+        long connectTimeoutMs = 2000;
+        int retryAttempts = 0;       // Reintentos ante fallos de conexión; timeouts y 502/503/504 solo en métodos idempotentes
+        int retryBackoffMs = 100;    // Se duplica en cada reintento
+    };
+
+    struct Request {
+        std::string method = "GET";
+        std::string path;
+        std::string body;
+        std::vector<std::string> headers;
+        long timeoutMs = 0;          // 0 = el del endpoint
+    };
+
+    struct Response {
+        long status = 0;
+        std::string body;
+        std::string contentType;
+        std::string error;           // Error de transporte; vacío si hubo respuesta
+
+        bool ok() const { return error.empty() && status >= 200 && status < 300; }
+    };
+
+    // Cliente compartido para una URL base
+    static HttpClient& forUrl(const std::string& baseUrl);
+
+    // Ajusta timeouts y reintentos de un endpoint antes de usarlo
+    static void configure(const std::string& baseUrl, const Options& options);
+
+    // Handles inactivos que se conservan en el pool (el resto se liberan)
+    static void setMaxIdleHandles(size_t maxIdle);
+
+    Response get(const std::string& path);
+    Response post(const std::string& path, const std::string& body,
+                  const std::string& contentType = "application/json");
+    Response perform(const Request& request);
+
+    // Ejecuta las peticiones de forma concurrente en un bucle curl_multi;
+    // las respuestas se devuelven en el mismo orden
+    std::vector<Response> performAll(const std::vector<Request>& requests);
+
+    const std::string& baseUrl() const { return url; }
+
+private:
+    explicit HttpClient(const std::string& baseUrl);
+
+    Options currentOptions();
+
+    std::string url;
+    Options options;
+    std::mutex optionsMutex;
+
+    static std::mutex clientsMutex;
+    static std::map<std::string, std::unique_ptr<HttpClient>> clients;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+// Diccionario de palabras clave e intenciones de inmigración compilado en un
+// autómata Aho-Corasick: una sola pasada sobre la consulta normalizada
+// detecta la intención, las palabras clave, los números de formulario
+// (i-485, n-400...) y las palabras interrogativas.
+// Se carga de keywords.json en el directorio de la base de conocimiento, así
+// que añadir una categoría de visa no requiere recompilar. Cada base de
+// conocimiento tiene el suyo en su instantánea (KnowledgeBase::dictionary()).
+class KeywordDictionary {
+public:
+    struct Intent {
+        std::string name;
+        std::vector<std::string> terms;
+    };
+
+    struct Definition {
+        std::vector<Intent> intents;                      // En orden de prioridad
+        std::vector<std::string> keywords;
+        std::vector<std::string> formPrefixes;            // "i-" detecta i-<dígitos>
+        std::vector<std::vector<std::string>> questions;  // Grupos equivalentes (como|how)
+    };
+
+    struct Matches {
+        std::string intent;                    // GENERAL_INTENT si no hay ninguna
+        std::vector<std::string> keywords;     // Orden del diccionario, más los formularios
+        std::vector<std::string> forms;
+        std::vector<std::string> questions;    // Alternancias "como|how" de los grupos presentes
+    };
+
+    static const char* const GENERAL_INTENT;
+
+    explicit KeywordDictionary(const Definition& definition);
+
+    // Busca en una consulta ya normalizada (QueryNormalizer)
+    Matches scan(const std::string& normalizedQuery) const;
+
+    // Lista integrada, usada si no existe keywords.json
+    static Definition builtinDefinition();
+
+    static bool loadDefinition(const std::string& filename, Definition& outDefinition);
+
+    // Diccionario compilado de builtinDefinition(), construido una sola vez
+    static std::shared_ptr<const KeywordDictionary> builtin();
+
+private:
+    enum class Kind { INTENT, KEYWORD, FORM, QUESTION };
+
+    struct Term {
+        Kind kind;
+        size_t index;
+        size_t length;
+    };
+
+    struct Node {
+        std::vector<std::pair<unsigned char, int>> children;
+        int fail = 0;
+        std::vector<size_t> outputs;  // Índices en terms
+    };
+
+    int child(int node, unsigned char c) const;
+    void insert(const std::string& text, Kind kind, size_t index);
+    void buildFailureLinks();
+
+    std::vector<std::string> intentNames;
+    std::vector<std::string> keywords;
+    std::vector<std::string> questionPatterns;
+    std::vector<Term> terms;
+    std::vector<Node> nodes;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+
+// Histograma de latencias al estilo HDR: cubos exactos hasta 16 us y, a
+// partir de ahí, 16 subcubos por potencia de dos (error relativo < 6,25 %).
+// record() solo hace incrementos atómicos relajados sobre el fragmento del
+// hilo que llama, así que los hilos no comparten líneas de caché.
+class LatencyHistogram {
+public:
+    static const size_t BUCKET_COUNT = 592;   // Hasta 2^40 us
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sumMicros = 0;
+        uint64_t maxMicros = 0;
+
+        // Latencia (us) por debajo de la cual queda la fracción p (0..1)
+        uint64_t percentile(double p) const;
+        uint64_t countAtOrBelow(uint64_t micros) const;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    Snapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t micros);
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    static const size_t SHARD_COUNT = 8;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<uint64_t> sumMicros;
+        std::atomic<uint64_t> maxMicros;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+};
+
+// Contador monotónico fragmentado por hilo
+class MetricCounter {
+public:
+    MetricCounter();
+
+    void add(uint64_t value = 1);
+    uint64_t value() const;
+
+private:
+    static const size_t SHARD_COUNT = 8;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+};
+
+// Registro de métricas del proceso, exportado en formato de texto de
+// Prometheus por /metrics. Las series se crean en el primer uso y no se
+// destruyen; las rutas calientes deben guardar la referencia devuelta
+// (p. ej. en una variable static local) para no buscar en el mapa cada vez.
+class Metrics {
+public:
+    // Latencia de las peticiones HTTP por ruta (iam_request_duration_seconds)
+    static LatencyHistogram& request(const std::string& route);
+    // Peticiones por ruta y código de estado (iam_requests_total)
+    static MetricCounter& requestCount(const std::string& route, int status);
+    // Latencia por etapa: auth, quota, pattern_match, knowledge_base, ocr, tts, sqlite_wait,
+    // ocr_wait, document_render
+    static LatencyHistogram& stage(const std::string& name);
+
+    // Valor instantáneo leído al exportar (profundidad de colas, etc.)
+    static void gauge(const std::string& name, const std::string& help, std::function<double()> read);
+
+    // Ruta con los segmentos variables (ids numéricos) sustituidos por :id
+    static std::string routeLabel(const std::string& method, const std::string& url);
+
+    static std::string exportPrometheus();
+
+    // Mide el tiempo de vida del objeto en un histograma
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(LatencyHistogram& histogram)
+            : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        LatencyHistogram& histogram;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    struct Gauge {
+        std::string help;
+        std::function<double()> read;
+    };
+
+    template <typename T>
+    static T& series(std::map<std::string, std::unique_ptr<T>>& family, const std::string& labels,
+                     const std::string& overflowLabels);
+
+    static std::shared_mutex registryMutex;
+    static std::map<std::string, std::unique_ptr<LatencyHistogram>> requestHistograms;
+    static std::map<std::string, std::unique_ptr<MetricCounter>> requestCounters;
+    static std::map<std::string, std::unique_ptr<LatencyHistogram>> stageHistograms;
+    static std::map<std::string, Gauge> gauges;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string_view>
+
+// Lectura de cuerpos multipart/form-data sin copiar: las partes son vistas
+// sobre el cuerpo original de la petición, así que un archivo subido llega al
+// OCR sin pasar por ningún búfer intermedio.
+class Multipart {
+public:
+    struct Part {
+        std::string_view name;
+        std::string_view filename;
+        std::string_view contentType;
+        std::string_view data;
+    };
+
+    // Boundary del encabezado Content-Type; vacío si no es multipart/form-data
+    static std::string_view boundary(std::string_view contentType);
+
+    // Busca la parte del campo name; false si no está o el cuerpo está mal formado
+    static bool find(std::string_view body, std::string_view boundary, std::string_view name, Part& out);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Normalización y hash de consultas sin reservas de memoria.
+// normalize() hace una sola pasada: minúsculas y eliminación de diacríticos
+// (UTF-8, Latin-1), colapso de espacios y de secuencias de puntuación, y
+// recorte de extremos. La salida nunca es más larga que la entrada, así que
+// el llamador puede pasar un búfer del mismo tamaño (o reutilizar un string).
+class QueryNormalizer {
+public:
+    enum class HashMode {
+        SHA256,     // Compatible con las claves ya guardadas en query_cache
+        FAST128     // MurmurHash3 x64 de 128 bits, no criptográfico (Hash::hex128)
+    };
+
+    // Escribe la consulta normalizada en out (capacidad >= length) y devuelve su longitud
+    static size_t normalize(const char* input, size_t length, char* out);
+
+    // Variante que reutiliza la capacidad de out
+    static void normalize(const std::string& input, std::string& out);
+
+    // Hash hexadecimal de un texto ya normalizado (64 caracteres en SHA256, 32 en FAST128)
+    static void hash(const std::string& normalized, HashMode mode, std::string& outHex);
+
+    static HashMode hashModeFromString(const std::string& name);
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Puntero a una instantánea inmutable que se reemplaza mientras otros hilos
+// la leen. Leer no toma ningún mutex: el lector se apunta en el contador de
+// la época actual y carga el puntero crudo (dos operaciones atómicas).
+// publish() cambia el puntero, alterna la época dos veces y espera a que
+// cada contador llegue a cero antes de liberar la instantánea anterior, así
+// que solo el escritor espera, y nunca a lectores que empezaron después.
+// (std::atomic_load sobre shared_ptr en libstdc++ usa un conjunto global de
+// mutex, compartido con todos los shared_ptr atómicos del proceso.)
+template <typename T>
+class SnapshotPtr {
+public:
+    // Referencia de lectura: la instantánea sigue viva mientras exista
+    class Reader {
+    public:
+        Reader(Reader&& other) noexcept : owner(other.owner), slot(other.slot), value(other.value) {
+            other.owner = nullptr;
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        Reader& operator=(Reader&&) = delete;
+
+        ~Reader() {
+            if (owner) {
+                owner->readers[slot].count.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        const T* operator->() const { return value; }
+        const T& operator*() const { return *value; }
+        const T* get() const { return value; }
+
+    private:
+        friend class SnapshotPtr;
+        Reader(const SnapshotPtr* owner, unsigned slot, const T* value) : owner(owner), slot(slot), value(value) {}
+
+        const SnapshotPtr* owner;
+        unsigned slot;
+        const T* value;
+    };
+
+    SnapshotPtr() = default;
+    explicit SnapshotPtr(std::shared_ptr<const T> initial) : owned(std::move(initial)), pointer(owned.get()) {}
+
+    SnapshotPtr(const SnapshotPtr&) = delete;
+    SnapshotPtr& operator=(const SnapshotPtr&) = delete;
+
+    Reader read() const {
+        unsigned slot = epoch.load() & 1;
+        readers[slot].count.fetch_add(1);
+        return Reader(this, slot, pointer.load());
+    }
+
+    // Publica next y libera la instantánea anterior cuando nadie la lee
+    void publish(std::shared_ptr<const T> next) {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        std::shared_ptr<const T> previous = std::move(owned);
+        owned = std::move(next);
+        pointer.store(owned.get());
+
+        // Un lector que aún vea la anterior se apuntó antes del cambio en uno
+        // de los dos contadores: se esperan ambos, cada uno después de mover
+        // a los lectores nuevos al otro
+        for (int flip = 0; flip < 2; flip++) {
+            unsigned slot = epoch.load() & 1;
+            epoch.store(slot ^ 1);
+            while (readers[slot].count.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Copia con propiedad compartida, para quien la guarde más allá de una lectura
+    std::shared_ptr<const T> share() const {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        return owned;
+    }
+
+private:
+    struct alignas(64) Counter {
+        std::atomic<long> count{0};
+    };
+
+    mutable Counter readers[2];
+    std::atomic<unsigned> epoch{0};
+    std::shared_ptr<const T> owned;
+    std::atomic<const T*> pointer{nullptr};
+    mutable std::mutex publishMutex;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <sqlite3.h>
+
+// Pool de conexiones SQLite de larga duración.
+// Cada conexión se abre una sola vez en modo WAL y mantiene su propia caché
+// de sentencias preparadas, de modo que las rutas calientes (autenticación,
+// cuotas) no pagan sqlite3_open/sqlite3_prepare_v2/sqlite3_close por petición.
+class SQLitePool {
+public:
+    class Connection {
+    public:
+        explicit Connection(const std::string& dbPath);
+        ~Connection();
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        sqlite3* get() const { return db; }
+
+        // Devuelve la sentencia cacheada para este SQL (preparándola la primera vez)
+        sqlite3_stmt* prepare(const char* sql);
+
+    private:
+        sqlite3* db;
+        std::unordered_map<std::string, sqlite3_stmt*> statements;
+    };
+
+    // Sentencia prestada de la caché de una conexión. Al destruirse se hace
+    // reset y se limpian los parámetros para liberar el bloqueo de lectura.
+    class Statement {
+    public:
+        explicit Statement(sqlite3_stmt* stmt = nullptr) : stmt(stmt) {}
+        ~Statement();
+
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+        Statement(Statement&& other) noexcept : stmt(other.stmt) { other.stmt = nullptr; }
+
+        sqlite3_stmt* get() const { return stmt; }
+        explicit operator bool() const { return stmt != nullptr; }
+
+    private:
+        sqlite3_stmt* stmt;
+    };
+
+    // Préstamo RAII de una conexión; se devuelve al pool al destruirse
+    class Handle {
+    public:
+        Handle(SQLitePool* pool, Connection* conn) : pool(pool), conn(conn) {}
+        ~Handle();
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+        Handle(Handle&& other) noexcept : pool(other.pool), conn(other.conn) { other.conn = nullptr; }
+
+        sqlite3* db() const { return conn ? conn->get() : nullptr; }
+        explicit operator bool() const { return conn != nullptr; }
+
+        Statement prepare(const char* sql) { return Statement(conn ? conn->prepare(sql) : nullptr); }
+
+    private:
+        SQLitePool* pool;
+        Connection* conn;
+    };
+
+    // Pool compartido para una ruta de base de datos
+    static SQLitePool& forPath(const std::string& dbPath);
+
+    // Ajusta el número máximo de conexiones antes de usar el pool
+    static void configure(const std::string& dbPath, size_t maxConnections);
+
+    Handle acquire();
+
+    ~SQLitePool();
+
+private:
+    SQLitePool(const std::string& dbPath, size_t maxConnections);
+
+    void release(Connection* conn);
+
+    std::string dbPath;
+    size_t maxConnections;
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<Connection*> idle;
+    std::mutex poolMutex;
+    std::condition_variable available;
+};
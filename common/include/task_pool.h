@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+// Pool de hilos para paralelismo de datos dentro de una petición (lotes de
+// documentos, páginas de OCR). parallelFor publica el lote y los hilos libres
+// se reparten los índices reclamándolos uno a uno con un contador atómico, de
+// modo que un elemento lento no deja a los demás hilos esperando. El hilo que
+// llama también trabaja en su lote, así que siempre avanza aunque el pool
+// esté ocupado con otros lotes.
+class TaskPool {
+public:
+    explicit TaskPool(size_t threads);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Pool compartido del proceso (un hilo por núcleo salvo que se configure)
+    static TaskPool& shared();
+
+    // Ajusta los hilos del pool compartido antes de usarlo (0 = uno por núcleo)
+    static void configure(size_t threads);
+
+    // Ejecuta fn(i) para cada i en [0, count) y vuelve cuando todos terminan.
+    // Si alguna llamada lanza, se relanza la primera excepción al terminar.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    size_t threadCount() const { return workers.size(); }
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        std::exception_ptr error;
+    };
+
+    // Reclama y ejecuta índices del lote; false si ya no quedaba ninguno
+    static bool runOne(Batch& batch);
+    void retire(const std::shared_ptr<Batch>& batch);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Batch>> batches;
+    std::mutex batchesMutex;
+    std::condition_variable batchesSignal;
+    bool running;
+};
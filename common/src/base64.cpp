@@ -0,0 +1,73 @@
+#include "base64.h"
+
+namespace {
+
+// Valor de cada carácter; 64 = espacio (se ignora), 65 = relleno, 255 = inválido
+struct DecodeTable {
+    uint8_t values[256];
+
+    DecodeTable() {
+        for (int i = 0; i < 256; i++) {
+            values[i] = 255;
+        }
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; i++) {
+            values[static_cast<uint8_t>(alphabet[i])] = static_cast<uint8_t>(i);
+        }
+        values[static_cast<uint8_t>('-')] = 62;
+        values[static_cast<uint8_t>('_')] = 63;
+        values[static_cast<uint8_t>(' ')] = 64;
+        values[static_cast<uint8_t>('\n')] = 64;
+        values[static_cast<uint8_t>('\r')] = 64;
+        values[static_cast<uint8_t>('\t')] = 64;
+        values[static_cast<uint8_t>('=')] = 65;
+    }
+};
+
+const DecodeTable decodeTable;
+
+}  // namespace
+
+bool Base64::decode(const std::string& input, std::vector<uint8_t>& output) {
+    size_t start = 0;
+    if (input.compare(0, 5, "data:") == 0) {
+        size_t comma = input.find(',');
+        if (comma == std::string::npos || input.rfind(";base64", comma) == std::string::npos) {
+            return false;
+        }
+        start = comma + 1;
+    }
+
+    output.clear();
+    output.reserve(decodedSizeBound(input.size() - start));
+
+    uint32_t buffer = 0;
+    int bits = 0;
+    size_t symbols = 0;
+    bool padding = false;
+    for (size_t i = start; i < input.size(); i++) {
+        uint8_t value = decodeTable.values[static_cast<uint8_t>(input[i])];
+        if (value == 64) {
+            continue;
+        }
+        if (value == 65) {
+            padding = true;
+            continue;
+        }
+        if (value == 255 || padding) {
+            // Carácter inválido, o datos después del relleno
+            return false;
+        }
+
+        buffer = (buffer << 6) | value;
+        bits += 6;
+        symbols++;
+        if (bits >= 8) {
+            bits -= 8;
+            output.push_back(static_cast<uint8_t>((buffer >> bits) & 0xFF));
+        }
+    }
+
+    // Un único símbolo suelto al final no codifica ningún byte completo
+    return symbols % 4 != 1;
+}
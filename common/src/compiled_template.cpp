@@ -0,0 +1,89 @@
+#include "compiled_template.h"
+
+CompiledTemplate CompiledTemplate::compile(const std::string& text) {
+    CompiledTemplate compiled;
+    compiled.literals.reserve(text.size());
+
+    std::unordered_map<std::string, int> slotIndex;
+    size_t literalStart = 0;
+    size_t pos = 0;
+
+    auto addLiteral = [&compiled](const std::string& source, size_t from, size_t to) {
+        if (to <= from) {
+            return;
+        }
+        // Los literales contiguos comparten segmento
+        if (!compiled.segments.empty() && compiled.segments.back().slot < 0 &&
+            compiled.segments.back().offset + compiled.segments.back().length == compiled.literals.size()) {
+            compiled.segments.back().length += to - from;
+        } else {
+            compiled.segments.push_back({compiled.literals.size(), to - from, -1});
+        }
+        compiled.literals.append(source, from, to - from);
+    };
+
+    while ((pos = text.find("{{", pos)) != std::string::npos) {
+        size_t close = text.find("}}", pos + 2);
+        if (close == std::string::npos) {
+            break;
+        }
+
+        addLiteral(text, literalStart, pos);
+
+        std::string name = text.substr(pos + 2, close - pos - 2);
+        auto it = slotIndex.find(name);
+        if (it == slotIndex.end()) {
+            it = slotIndex.emplace(name, static_cast<int>(compiled.slotNames.size())).first;
+            compiled.slotNames.push_back(name);
+        }
+        compiled.segments.push_back({0, 0, it->second});
+
+        pos = close + 2;
+        literalStart = pos;
+    }
+    addLiteral(text, literalStart, text.size());
+
+    return compiled;
+}
+
+size_t CompiledTemplate::renderedSize(const std::vector<const std::string*>& values, Missing missing) const {
+    size_t size = 0;
+    for (const auto& segment : segments) {
+        if (segment.slot < 0) {
+            size += segment.length;
+        } else if (values[segment.slot]) {
+            size += values[segment.slot]->size();
+        } else if (missing == Missing::KEEP) {
+            size += slotNames[segment.slot].size() + 4;
+        }
+    }
+    return size;
+}
+
+void CompiledTemplate::renderTo(std::string& out, const std::vector<const std::string*>& values, Missing missing) const {
+    out.reserve(out.size() + renderedSize(values, missing));
+
+    for (const auto& segment : segments) {
+        if (segment.slot < 0) {
+            out.append(literals, segment.offset, segment.length);
+        } else if (values[segment.slot]) {
+            out.append(*values[segment.slot]);
+        } else if (missing == Missing::KEEP) {
+            out.append("{{").append(slotNames[segment.slot]).append("}}");
+        }
+    }
+}
+
+std::string CompiledTemplate::render(const std::unordered_map<std::string, std::string>& vars, Missing missing) const {
+    std::vector<const std::string*> values(slotNames.size(), nullptr);
+    for (size_t i = 0; i < slotNames.size(); i++) {
+        auto it = vars.find(slotNames[i]);
+        if (it != vars.end()) {
+            values[i] = &it->second;
+        }
+    }
+
+    std::string out;
+    renderTo(out, values, missing);
+    return out;
+}
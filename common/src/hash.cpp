@@ -0,0 +1,98 @@
+#include "hash.h"
+#include <cstring>
+
+void Hash::hex128(std::string_view data, std::string& outHex) {
+    static const char* hexDigits = "0123456789abcdef";
+    uint64_t h[2];
+    murmur3_128(data.data(), data.size(), 0, h);
+
+    outHex.resize(32);
+    for (int i = 0; i < 16; i++) {
+        unsigned char byte = static_cast<unsigned char>(h[i / 8] >> (56 - 8 * (i % 8)));
+        outHex[2 * i] = hexDigits[byte >> 4];
+        outHex[2 * i + 1] = hexDigits[byte & 0x0F];
+    }
+}
+
+std::string Hash::hex128(std::string_view data) {
+    std::string hex;
+    hex128(data, hex);
+    return hex;
+}
+
+static inline uint64_t rotl64(uint64_t x, int8_t r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+void Hash::murmur3_128(const void* data, size_t length, uint32_t seed, uint64_t out[2]) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t blocks = length / 16;
+
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k1, k2;
+        std::memcpy(&k1, bytes + i * 16, 8);
+        std::memcpy(&k2, bytes + i * 16 + 8, 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* tail = bytes + blocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    switch (length & 15) {
+        case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+        case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+        case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+        case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+        case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+        case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+        case 9:
+            k2 ^= static_cast<uint64_t>(tail[8]);
+            k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+            [[fallthrough]];
+        case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+        case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+        case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+        case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+        case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+        case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+        case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+        case 1:
+            k1 ^= static_cast<uint64_t>(tail[0]);
+            k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= length;
+    h2 ^= length;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    out[0] = h1;
+    out[1] = h2;
+}
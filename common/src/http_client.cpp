@@ -0,0 +1,376 @@
+#include "http_client.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <curl/curl.h>
+
+std::mutex HttpClient::clientsMutex;
+std::map<std::string, std::unique_ptr<HttpClient>> HttpClient::clients;
+
+namespace {
+
+// Estado de libcurl del proceso: inicialización global, caché compartida de
+// conexiones/DNS/TLS y pool de handles fáciles reutilizables
+class CurlRuntime {
+public:
+    static CurlRuntime& instance() {
+        static CurlRuntime runtime;
+        return runtime;
+    }
+
+    CURL* acquire() {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!idle.empty()) {
+                CURL* handle = idle.back();
+                idle.pop_back();
+                return handle;
+            }
+        }
+        return curl_easy_init();
+    }
+
+    void release(CURL* handle) {
+        if (!handle) {
+            return;
+        }
+        // reset borra las opciones pero la conexión sigue viva en la caché compartida
+        curl_easy_reset(handle);
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (idle.size() < maxIdle) {
+            idle.push_back(handle);
+            return;
+        }
+        curl_easy_cleanup(handle);
+    }
+
+    void setMaxIdle(size_t value) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        maxIdle = value;
+        while (idle.size() > maxIdle) {
+            curl_easy_cleanup(idle.back());
+            idle.pop_back();
+        }
+    }
+
+    CURLSH* sharedCache() const { return share; }
+
+private:
+    CurlRuntime() {
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        share = curl_share_init();
+        if (share) {
+            curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+            curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+            curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+    }
+
+    ~CurlRuntime() {
+        for (CURL* handle : idle) {
+            curl_easy_cleanup(handle);
+        }
+        if (share) {
+            curl_share_cleanup(share);
+        }
+        curl_global_cleanup();
+    }
+
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+        static_cast<CurlRuntime*>(userptr)->shareMutexes[data].lock();
+    }
+
+    static void unlockShare(CURL*, curl_lock_data data, void* userptr) {
+        static_cast<CurlRuntime*>(userptr)->shareMutexes[data].unlock();
+    }
+
+    CURLSH* share = nullptr;
+    std::mutex shareMutexes[CURL_LOCK_DATA_LAST];
+
+    std::mutex poolMutex;
+    std::vector<CURL*> idle;
+    size_t maxIdle = 32;
+};
+
+// Una transferencia en curso: handle prestado, cabeceras y destino de la respuesta.
+// Devuelve el handle al pool al destruirse, también si se lanza una excepción.
+class Transfer {
+public:
+    Transfer() : handle(CurlRuntime::instance().acquire()) {}
+
+    ~Transfer() {
+        if (headers) {
+            curl_slist_free_all(headers);
+        }
+        CurlRuntime::instance().release(handle);
+    }
+
+    Transfer(const Transfer&) = delete;
+    Transfer& operator=(const Transfer&) = delete;
+
+    bool prepare(const std::string& url, const HttpClient::Request& request,
+                 const HttpClient::Options& options, HttpClient::Response& out) {
+        if (!handle) {
+            out.error = "Error al inicializar CURL";
+            return false;
+        }
+        response = &out;
+        response->body.clear();
+        idempotent = isIdempotent(request.method);
+
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle, CURLOPT_SHARE, CurlRuntime::instance().sharedCache());
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        if (url.compare(0, 8, "https://") == 0) {
+            // Solo con TLS se negocia HTTP/2: esperar a multiplexar sobre la conexión
+            // existente; en HTTP/1.1 la espera serializaría las peticiones
+            curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        }
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, request.timeoutMs > 0 ? request.timeoutMs : options.timeoutMs);
+        curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, options.connectTimeoutMs);
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeBody);
+        curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response->body);
+        curl_easy_setopt(handle, CURLOPT_PRIVATE, this);
+
+        if (request.method == "POST") {
+            curl_easy_setopt(handle, CURLOPT_POST, 1L);
+        } else if (request.method != "GET") {
+            curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+        }
+        if (request.method != "GET" || !request.body.empty()) {
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request.body.data());
+            curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)request.body.size());
+        }
+
+        // Sin "Expect: 100-continue": evita una ida y vuelta extra en cuerpos grandes
+        headers = curl_slist_append(headers, "Expect:");
+        for (const auto& header : request.headers) {
+            headers = curl_slist_append(headers, header.c_str());
+        }
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+        return true;
+    }
+
+    // Completa la respuesta con el resultado de la transferencia
+    void finish(CURLcode result) {
+        transient = isTransient(result, 0, idempotent);
+        if (result != CURLE_OK) {
+            response->error = curl_easy_strerror(result);
+            response->status = 0;
+            return;
+        }
+        response->error.clear();
+        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response->status);
+
+        char* contentType = nullptr;
+        if (curl_easy_getinfo(handle, CURLINFO_CONTENT_TYPE, &contentType) == CURLE_OK && contentType) {
+            response->contentType = contentType;
+        }
+        transient = isTransient(result, response->status, idempotent);
+    }
+
+    CURL* get() const { return handle; }
+    bool retryable() const { return transient; }
+
+private:
+    static size_t writeBody(void* contents, size_t size, size_t nmemb, void* userp) {
+        static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+        return size * nmemb;
+    }
+
+    static bool isIdempotent(const std::string& method) {
+        return method == "GET" || method == "HEAD" || method == "PUT" ||
+               method == "DELETE" || method == "OPTIONS";
+    }
+
+    // Sin conexión la petición no llegó a enviarse y siempre se puede repetir.
+    // Un timeout, un corte o un 502/503/504 pueden llegar después de que el
+    // servidor la procesara: solo se repiten los métodos idempotentes
+    static bool isTransient(CURLcode result, long status, bool idempotent) {
+        switch (result) {
+            case CURLE_COULDNT_RESOLVE_HOST:
+            case CURLE_COULDNT_CONNECT:
+                return true;
+            case CURLE_OK:
+                return idempotent && (status == 502 || status == 503 || status == 504);
+            case CURLE_OPERATION_TIMEDOUT:
+            case CURLE_SEND_ERROR:
+            case CURLE_RECV_ERROR:
+            case CURLE_GOT_NOTHING:
+                return idempotent;
+            default:
+                return false;
+        }
+    }
+
+    CURL* handle;
+    curl_slist* headers = nullptr;
+    HttpClient::Response* response = nullptr;
+    bool idempotent = false;
+    bool transient = false;
+};
+
+void backoff(const HttpClient::Options& options, int attempt) {
+    if (options.retryBackoffMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long>(options.retryBackoffMs) << attempt));
+    }
+}
+
+}  // namespace
+
+HttpClient::HttpClient(const std::string& baseUrl) : url(baseUrl) {
+}
+
+HttpClient& HttpClient::forUrl(const std::string& baseUrl) {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    auto it = clients.find(baseUrl);
+    if (it == clients.end()) {
+        it = clients.emplace(baseUrl, std::unique_ptr<HttpClient>(new HttpClient(baseUrl))).first;
+    }
+    return *it->second;
+}
+
+void HttpClient::configure(const std::string& baseUrl, const Options& options) {
+    HttpClient& client = forUrl(baseUrl);
+    std::lock_guard<std::mutex> lock(client.optionsMutex);
+    client.options = options;
+}
+
+void HttpClient::setMaxIdleHandles(size_t maxIdle) {
+    CurlRuntime::instance().setMaxIdle(maxIdle);
+}
+
+HttpClient::Options HttpClient::currentOptions() {
+    std::lock_guard<std::mutex> lock(optionsMutex);
+    return options;
+}
+
+HttpClient::Response HttpClient::get(const std::string& path) {
+    Request request;
+    request.path = path;
+    return perform(request);
+}
+
+HttpClient::Response HttpClient::post(const std::string& path, const std::string& body, const std::string& contentType) {
+    Request request;
+    request.method = "POST";
+    request.path = path;
+    request.body = body;
+    request.headers.push_back("Content-Type: " + contentType);
+    return perform(request);
+}
+
+HttpClient::Response HttpClient::perform(const Request& request) {
+    Options opts = currentOptions();
+    Response response;
+
+    for (int attempt = 0; ; attempt++) {
+        bool retry = false;
+        {
+            Transfer transfer;
+            if (!transfer.prepare(url + request.path, request, opts, response)) {
+                return response;
+            }
+            transfer.finish(curl_easy_perform(transfer.get()));
+            retry = transfer.retryable() && attempt < opts.retryAttempts;
+        }
+        if (!retry) {
+            return response;
+        }
+        backoff(opts, attempt);
+    }
+}
+
+std::vector<HttpClient::Response> HttpClient::performAll(const std::vector<Request>& requests) {
+    Options opts = currentOptions();
+    std::vector<Response> responses(requests.size());
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        for (auto& response : responses) {
+            response.error = "Error al inicializar CURL";
+        }
+        return responses;
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    std::vector<size_t> pending(requests.size());
+    for (size_t i = 0; i < pending.size(); i++) {
+        pending[i] = i;
+    }
+
+    // Cada ronda lanza todas las pendientes a la vez; las que fallan de forma
+    // transitoria pasan a la siguiente ronda tras la espera
+    for (int attempt = 0; !pending.empty(); attempt++) {
+        std::vector<std::unique_ptr<Transfer>> transfers;
+        std::map<CURL*, size_t> indexByHandle;
+
+        for (size_t index : pending) {
+            auto transfer = std::make_unique<Transfer>();
+            if (!transfer->prepare(url + requests[index].path, requests[index], opts, responses[index])) {
+                continue;
+            }
+            CURLMcode added = curl_multi_add_handle(multi, transfer->get());
+            if (added != CURLM_OK) {
+                responses[index].error = curl_multi_strerror(added);
+                continue;
+            }
+            indexByHandle[transfer->get()] = index;
+            transfers.push_back(std::move(transfer));
+        }
+
+        int running = 0;
+        do {
+            CURLMcode result = curl_multi_perform(multi, &running);
+            if (result != CURLM_OK) {
+                std::cerr << "Error en el bucle HTTP concurrente: " << curl_multi_strerror(result) << std::endl;
+                break;
+            }
+            if (running > 0) {
+                curl_multi_wait(multi, nullptr, 0, 100, nullptr);
+            }
+        } while (running > 0);
+
+        std::vector<size_t> retry;
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            transfer->finish(message->data.result);
+            if (transfer->retryable() && attempt < opts.retryAttempts) {
+                retry.push_back(indexByHandle[message->easy_handle]);
+            }
+            indexByHandle.erase(message->easy_handle);
+        }
+
+        // Las que no llegaron a completarse (error del bucle) cuentan como fallo de transporte
+        for (auto& entry : indexByHandle) {
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(entry.first, CURLINFO_PRIVATE, &transfer);
+            transfer->finish(CURLE_RECV_ERROR);
+        }
+
+        for (auto& transfer : transfers) {
+            curl_multi_remove_handle(multi, transfer->get());
+        }
+        transfers.clear();
+
+        pending.swap(retry);
+        if (!pending.empty()) {
+            backoff(opts, attempt);
+        }
+    }
+
+    curl_multi_cleanup(multi);
+    return responses;
+}
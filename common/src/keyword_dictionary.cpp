@@ -0,0 +1,261 @@
+#include "keyword_dictionary.h"
+#include "query_normalizer.h"
+#include <iostream>
+#include <fstream>
+#include <queue>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+const char* const KeywordDictionary::GENERAL_INTENT = "general_immigration";
+
+namespace {
+
+bool isWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+}
+
+bool isBoundary(const std::string& text, size_t pos) {
+    bool before = pos > 0 && isWordChar(text[pos - 1]);
+    bool after = pos < text.size() && isWordChar(text[pos]);
+    return before != after;
+}
+
+// Los términos se comparan con la consulta ya normalizada
+std::string normalizeTerm(const std::string& term) {
+    std::string normalized;
+    QueryNormalizer::normalize(term, normalized);
+    return normalized;
+}
+
+} // namespace
+
+KeywordDictionary::Definition KeywordDictionary::builtinDefinition() {
+    Definition definition;
+    definition.intents = {
+        {"visa_info", {"visa"}},
+        {"citizenship", {"ciudadania", "citizenship"}},
+        {"green_card", {"green card", "residencia"}},
+        {"asylum", {"asilo", "asylum"}},
+        {"deportation", {"deportacion", "deportation"}},
+        {"daca", {"daca"}},
+        {"tps", {"tps"}}
+    };
+    definition.keywords = {
+        "visa", "green card", "ciudadania", "citizenship", "residencia", "asilo", "asylum",
+        "deportacion", "deportation", "daca", "tps", "i-130", "i-485", "i-765", "i-601",
+        "i-751", "n-400", "eb1", "eb2", "eb3", "eb4", "eb5", "h1b", "h2a", "h2b", "j1", "f1",
+        "b1", "b2", "ajuste de estatus", "permiso de trabajo", "work permit",
+        "naturalizacion", "naturalization"
+    };
+    definition.formPrefixes = {"i-"};
+    definition.questions = {
+        {"como", "how"},
+        {"que", "what"}
+    };
+    return definition;
+}
+
+bool KeywordDictionary::loadDefinition(const std::string& filename, Definition& outDefinition) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    try {
+        json data;
+        file >> data;
+
+        Definition definition;
+        for (const auto& intent : data.value("intents", json::array())) {
+            definition.intents.push_back({intent.at("name").get<std::string>(),
+                                          intent.at("terms").get<std::vector<std::string>>()});
+        }
+        definition.keywords = data.value("keywords", std::vector<std::string>());
+        definition.formPrefixes = data.value("forms", std::vector<std::string>());
+        definition.questions = data.value("questions", std::vector<std::vector<std::string>>());
+
+        outDefinition = std::move(definition);
+    } catch (const std::exception& e) {
+        std::cerr << "Error al cargar el diccionario de palabras clave (" << filename << "): " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<const KeywordDictionary> KeywordDictionary::builtin() {
+    static const std::shared_ptr<const KeywordDictionary> dictionary =
+        std::make_shared<const KeywordDictionary>(builtinDefinition());
+    return dictionary;
+}
+
+KeywordDictionary::KeywordDictionary(const Definition& definition) {
+    nodes.emplace_back();
+
+    for (size_t i = 0; i < definition.intents.size(); i++) {
+        intentNames.push_back(definition.intents[i].name);
+        for (const auto& term : definition.intents[i].terms) {
+            insert(normalizeTerm(term), Kind::INTENT, i);
+        }
+    }
+
+    for (const auto& keyword : definition.keywords) {
+        std::string normalized = normalizeTerm(keyword);
+        insert(normalized, Kind::KEYWORD, keywords.size());
+        keywords.push_back(normalized);
+    }
+
+    for (size_t i = 0; i < definition.formPrefixes.size(); i++) {
+        insert(normalizeTerm(definition.formPrefixes[i]), Kind::FORM, i);
+    }
+
+    for (const auto& group : definition.questions) {
+        std::string alternation;
+        for (const auto& word : group) {
+            std::string normalized = normalizeTerm(word);
+            insert(normalized, Kind::QUESTION, questionPatterns.size());
+            alternation += (alternation.empty() ? "" : "|") + normalized;
+        }
+        questionPatterns.push_back(alternation);
+    }
+
+    buildFailureLinks();
+}
+
+int KeywordDictionary::child(int node, unsigned char c) const {
+    for (const auto& edge : nodes[node].children) {
+        if (edge.first == c) {
+            return edge.second;
+        }
+    }
+    return -1;
+}
+
+void KeywordDictionary::insert(const std::string& text, Kind kind, size_t index) {
+    if (text.empty()) {
+        return;
+    }
+
+    int node = 0;
+    for (unsigned char c : text) {
+        int next = child(node, c);
+        if (next < 0) {
+            next = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+            nodes[node].children.emplace_back(c, next);
+        }
+        node = next;
+    }
+    nodes[node].outputs.push_back(terms.size());
+    terms.push_back({kind, index, text.size()});
+}
+
+void KeywordDictionary::buildFailureLinks() {
+    std::queue<int> pending;
+    for (const auto& edge : nodes[0].children) {
+        pending.push(edge.second);
+    }
+
+    while (!pending.empty()) {
+        int node = pending.front();
+        pending.pop();
+
+        for (const auto& edge : nodes[node].children) {
+            int fail = nodes[node].fail;
+            while (fail != 0 && child(fail, edge.first) < 0) {
+                fail = nodes[fail].fail;
+            }
+            int target = child(fail, edge.first);
+            nodes[edge.second].fail = (target >= 0 && target != edge.second) ? target : 0;
+
+            const auto& inherited = nodes[nodes[edge.second].fail].outputs;
+            nodes[edge.second].outputs.insert(nodes[edge.second].outputs.end(), inherited.begin(), inherited.end());
+
+            pending.push(edge.second);
+        }
+    }
+}
+
+KeywordDictionary::Matches KeywordDictionary::scan(const std::string& normalizedQuery) const {
+    Matches matches;
+    std::vector<char> intentHits(intentNames.size(), 0);
+    std::vector<char> keywordHits(keywords.size(), 0);
+    std::vector<char> questionHits(questionPatterns.size(), 0);
+
+    int node = 0;
+    for (size_t i = 0; i < normalizedQuery.size(); i++) {
+        unsigned char c = normalizedQuery[i];
+        int next;
+        while ((next = child(node, c)) < 0 && node != 0) {
+            node = nodes[node].fail;
+        }
+        node = next >= 0 ? next : 0;
+
+        for (size_t termIndex : nodes[node].outputs) {
+            const Term& term = terms[termIndex];
+            size_t start = i + 1 - term.length;
+
+            switch (term.kind) {
+                case Kind::INTENT:
+                    intentHits[term.index] = 1;
+                    break;
+                case Kind::KEYWORD:
+                    keywordHits[term.index] = 1;
+                    break;
+                case Kind::QUESTION:
+                    // Palabras completas: "que" no debe coincidir dentro de "quedarme"
+                    if (isBoundary(normalizedQuery, start) && isBoundary(normalizedQuery, i + 1)) {
+                        questionHits[term.index] = 1;
+                    }
+                    break;
+                case Kind::FORM: {
+                    // Prefijo seguido de dígitos: i-485
+                    size_t end = i + 1;
+                    while (end < normalizedQuery.size() && normalizedQuery[end] >= '0' && normalizedQuery[end] <= '9') {
+                        end++;
+                    }
+                    if (end > i + 1) {
+                        std::string form = normalizedQuery.substr(start, end - start);
+                        if (std::find(matches.forms.begin(), matches.forms.end(), form) == matches.forms.end()) {
+                            matches.forms.push_back(form);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Intención: la primera en orden de prioridad; si no hay, el primer formulario
+    matches.intent = GENERAL_INTENT;
+    for (size_t i = 0; i < intentHits.size(); i++) {
+        if (intentHits[i]) {
+            matches.intent = intentNames[i];
+            break;
+        }
+    }
+    if (matches.intent == GENERAL_INTENT && !matches.forms.empty()) {
+        matches.intent = matches.forms.front();
+    }
+
+    for (size_t i = 0; i < keywordHits.size(); i++) {
+        if (keywordHits[i]) {
+            matches.keywords.push_back(keywords[i]);
+        }
+    }
+    for (const auto& form : matches.forms) {
+        if (std::find(matches.keywords.begin(), matches.keywords.end(), form) == matches.keywords.end()) {
+            matches.keywords.push_back(form);
+        }
+    }
+
+    for (size_t i = 0; i < questionHits.size(); i++) {
+        if (questionHits[i]) {
+            matches.questions.push_back(questionPatterns[i]);
+        }
+    }
+
+    return matches;
+}
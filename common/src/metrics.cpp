@@ -0,0 +1,328 @@
+#include "metrics.h"
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <algorithm>
+
+namespace {
+
+const size_t SUB_BUCKET_BITS = 4;
+const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+const uint64_t MAX_TRACKED_MICROS = (uint64_t(1) << 40) - 1;
+
+// Límite de series por familia: una ruta desconocida por petición (escaneos,
+// 404) no debe hacer crecer el registro sin fin
+const size_t MAX_SERIES_PER_FAMILY = 256;
+
+// Límites "le" exportados a Prometheus (us); los cubos finos se agregan en estos
+const uint64_t EXPORT_BOUNDS[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+    250000, 500000, 1000000, 2500000, 5000000, 10000000, 30000000
+};
+
+const double EXPORT_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+// Fragmento del hilo actual, asignado por turnos en su primer uso
+size_t shardIndex(size_t shardCount) {
+    static std::atomic<size_t> nextShard(0);
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+    return shard % shardCount;
+}
+
+// Ids numéricos, o tokens largos con dígitos (hashes, uuids); "v1" no
+bool isVariableSegment(const std::string& segment) {
+    size_t digits = 0;
+    for (char c : segment) {
+        if (c >= '0' && c <= '9') {
+            digits++;
+        }
+    }
+    return digits > 0 && (digits == segment.size() || segment.size() > 8);
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string seconds(uint64_t micros) {
+    std::ostringstream out;
+    out << std::setprecision(6) << micros / 1e6;
+    return out.str();
+}
+
+void writeHistogram(std::ostringstream& out, const std::string& name, const std::string& labels,
+                    const LatencyHistogram::Snapshot& snapshot) {
+    for (uint64_t bound : EXPORT_BOUNDS) {
+        out << name << "_bucket{" << labels << ",le=\"" << seconds(bound) << "\"} "
+            << snapshot.countAtOrBelow(bound) << "\n";
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << snapshot.count << "\n";
+    out << name << "_sum{" << labels << "} " << seconds(snapshot.sumMicros) << "\n";
+    out << name << "_count{" << labels << "} " << snapshot.count << "\n";
+}
+
+void writeQuantiles(std::ostringstream& out, const std::string& name, const std::string& labels,
+                    const LatencyHistogram::Snapshot& snapshot) {
+    for (double quantile : EXPORT_QUANTILES) {
+        out << name << "{" << labels << ",quantile=\"" << quantile << "\"} "
+            << seconds(snapshot.percentile(quantile)) << "\n";
+    }
+    out << name << "{" << labels << ",quantile=\"1\"} " << seconds(snapshot.maxMicros) << "\n";
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : shards(new Shard[SHARD_COUNT]) {
+    for (size_t s = 0; s < SHARD_COUNT; s++) {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            shards[s].buckets[i].store(0, std::memory_order_relaxed);
+        }
+        shards[s].sumMicros.store(0, std::memory_order_relaxed);
+        shards[s].maxMicros.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    if (micros > MAX_TRACKED_MICROS) {
+        micros = MAX_TRACKED_MICROS;
+    }
+
+    size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(micros));
+    size_t subBucket = static_cast<size_t>(micros >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+
+    size_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + subBucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    Shard& shard = shards[shardIndex(SHARD_COUNT)];
+    shard.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    shard.sumMicros.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t currentMax = shard.maxMicros.load(std::memory_order_relaxed);
+    while (micros > currentMax &&
+           !shard.maxMicros.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(BUCKET_COUNT, 0);
+
+    for (size_t s = 0; s < SHARD_COUNT; s++) {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            uint64_t bucket = shards[s].buckets[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += bucket;
+            snapshot.count += bucket;
+        }
+        snapshot.sumMicros += shards[s].sumMicros.load(std::memory_order_relaxed);
+        snapshot.maxMicros = std::max(snapshot.maxMicros, shards[s].maxMicros.load(std::memory_order_relaxed));
+    }
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(p * count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min(bucketUpperBound(i), maxMicros);
+        }
+    }
+    return maxMicros;
+}
+
+uint64_t LatencyHistogram::Snapshot::countAtOrBelow(uint64_t micros) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size() && bucketUpperBound(i) <= micros; i++) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+MetricCounter::MetricCounter() : shards(new Shard[SHARD_COUNT]) {
+    for (size_t s = 0; s < SHARD_COUNT; s++) {
+        shards[s].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricCounter::add(uint64_t value) {
+    shards[shardIndex(SHARD_COUNT)].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (size_t s = 0; s < SHARD_COUNT; s++) {
+        total += shards[s].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::shared_mutex Metrics::registryMutex;
+std::map<std::string, std::unique_ptr<LatencyHistogram>> Metrics::requestHistograms;
+std::map<std::string, std::unique_ptr<MetricCounter>> Metrics::requestCounters;
+std::map<std::string, std::unique_ptr<LatencyHistogram>> Metrics::stageHistograms;
+std::map<std::string, Metrics::Gauge> Metrics::gauges;
+
+template <typename T>
+T& Metrics::series(std::map<std::string, std::unique_ptr<T>>& family, const std::string& labels,
+                   const std::string& overflowLabels) {
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        auto it = family.find(labels);
+        if (it != family.end()) {
+            return *it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    auto it = family.find(labels);
+    if (it != family.end()) {
+        return *it->second;
+    }
+
+    std::string key = labels;
+    if (family.size() >= MAX_SERIES_PER_FAMILY) {
+        key = overflowLabels;
+        it = family.find(key);
+        if (it != family.end()) {
+            return *it->second;
+        }
+    }
+    auto& slot = family[key];
+    slot.reset(new T());
+    return *slot;
+}
+
+LatencyHistogram& Metrics::request(const std::string& route) {
+    return series(requestHistograms, "route=\"" + escapeLabel(route) + "\"", "route=\"other\"");
+}
+
+MetricCounter& Metrics::requestCount(const std::string& route, int status) {
+    return series(requestCounters, "route=\"" + escapeLabel(route) + "\",status=\"" + std::to_string(status) + "\"",
+                  "route=\"other\",status=\"other\"");
+}
+
+LatencyHistogram& Metrics::stage(const std::string& name) {
+    return series(stageHistograms, "stage=\"" + escapeLabel(name) + "\"", "stage=\"other\"");
+}
+
+void Metrics::gauge(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    gauges[name] = {help, std::move(read)};
+}
+
+std::string Metrics::routeLabel(const std::string& method, const std::string& url) {
+    std::string route = method + " ";
+
+    // Sin query string; los segmentos con dígitos (ids) se agrupan
+    size_t end = url.find('?');
+    std::string path = url.substr(0, end);
+
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string::npos) {
+            slash = path.size();
+        }
+        if (slash > start) {
+            std::string segment = path.substr(start, slash - start);
+            route += "/" + (isVariableSegment(segment) ? std::string(":id") : segment);
+        }
+        start = slash + 1;
+    }
+    return route.size() > method.size() + 1 ? route : route + "/";
+}
+
+std::string Metrics::exportPrometheus() {
+    // Tomar las instantáneas bajo el bloqueo y dar formato fuera de él; los
+    // medidores se leen sin el bloqueo por si consultan otros componentes
+    std::vector<std::pair<std::string, LatencyHistogram::Snapshot>> requests;
+    std::vector<std::pair<std::string, uint64_t>> counts;
+    std::vector<std::pair<std::string, LatencyHistogram::Snapshot>> stages;
+    std::map<std::string, Gauge> gaugesCopy;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        for (const auto& entry : requestHistograms) {
+            requests.emplace_back(entry.first, entry.second->snapshot());
+        }
+        for (const auto& entry : requestCounters) {
+            counts.emplace_back(entry.first, entry.second->value());
+        }
+        for (const auto& entry : stageHistograms) {
+            stages.emplace_back(entry.first, entry.second->snapshot());
+        }
+        gaugesCopy = gauges;
+    }
+
+    std::ostringstream out;
+
+    out << "# HELP iam_request_duration_seconds Latencia de las peticiones HTTP por ruta\n";
+    out << "# TYPE iam_request_duration_seconds histogram\n";
+    for (const auto& entry : requests) {
+        writeHistogram(out, "iam_request_duration_seconds", entry.first, entry.second);
+    }
+
+    out << "# HELP iam_request_duration_quantile_seconds Percentiles de latencia por ruta\n";
+    out << "# TYPE iam_request_duration_quantile_seconds gauge\n";
+    for (const auto& entry : requests) {
+        writeQuantiles(out, "iam_request_duration_quantile_seconds", entry.first, entry.second);
+    }
+
+    out << "# HELP iam_requests_total Peticiones HTTP por ruta y código de estado\n";
+    out << "# TYPE iam_requests_total counter\n";
+    for (const auto& entry : counts) {
+        out << "iam_requests_total{" << entry.first << "} " << entry.second << "\n";
+    }
+
+    out << "# HELP iam_stage_duration_seconds Latencia por etapa del procesamiento\n";
+    out << "# TYPE iam_stage_duration_seconds histogram\n";
+    for (const auto& entry : stages) {
+        writeHistogram(out, "iam_stage_duration_seconds", entry.first, entry.second);
+    }
+
+    out << "# HELP iam_stage_duration_quantile_seconds Percentiles de latencia por etapa\n";
+    out << "# TYPE iam_stage_duration_quantile_seconds gauge\n";
+    for (const auto& entry : stages) {
+        writeQuantiles(out, "iam_stage_duration_quantile_seconds", entry.first, entry.second);
+    }
+
+    for (const auto& entry : gaugesCopy) {
+        out << "# HELP " << entry.first << " " << entry.second.help << "\n";
+        out << "# TYPE " << entry.first << " gauge\n";
+        out << entry.first << " " << entry.second.read() << "\n";
+    }
+
+    return out.str();
+}
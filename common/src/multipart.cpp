@@ -0,0 +1,127 @@
+#include "multipart.h"
+#include <string>
+#include <cctype>
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t findIgnoreCase(std::string_view text, std::string_view needle) {
+    for (size_t i = 0; i + needle.size() <= text.size(); i++) {
+        if (equalsIgnoreCase(text.substr(i, needle.size()), needle)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Valor de un parámetro (name="...") dentro de un encabezado, sin comillas
+static std::string_view parameter(std::string_view header, std::string_view key) {
+    size_t pos = 0;
+    while ((pos = header.find(';', pos)) != std::string_view::npos) {
+        pos++;
+        std::string_view rest = header.substr(pos);
+        size_t equals = rest.find('=');
+        if (equals == std::string_view::npos) {
+            break;
+        }
+        if (!equalsIgnoreCase(trim(rest.substr(0, equals)), key)) {
+            continue;
+        }
+        std::string_view value = trim(rest.substr(equals + 1));
+        if (!value.empty() && value.front() == '"') {
+            size_t close = value.find('"', 1);
+            return close == std::string_view::npos ? std::string_view() : value.substr(1, close - 1);
+        }
+        return trim(value.substr(0, value.find(';')));
+    }
+    return {};
+}
+
+std::string_view Multipart::boundary(std::string_view contentType) {
+    if (findIgnoreCase(contentType, "multipart/form-data") != 0) {
+        return {};
+    }
+    return parameter(contentType, "boundary");
+}
+
+bool Multipart::find(std::string_view body, std::string_view boundary, std::string_view name, Part& out) {
+    if (boundary.empty()) {
+        return false;
+    }
+
+    // Cada parte empieza tras "--boundary\r\n"; la última marca es "--boundary--"
+    std::string delimiter = "--";
+    delimiter.append(boundary.data(), boundary.size());
+
+    size_t pos = body.find(delimiter);
+    while (pos != std::string_view::npos) {
+        pos += delimiter.size();
+        if (body.substr(pos, 2) == "--") {
+            return false;
+        }
+        if (body.substr(pos, 2) != "\r\n") {
+            return false;
+        }
+        pos += 2;
+
+        size_t headersEnd = body.find("\r\n\r\n", pos);
+        if (headersEnd == std::string_view::npos) {
+            return false;
+        }
+
+        Part part;
+        std::string_view headers = body.substr(pos, headersEnd - pos);
+        while (!headers.empty()) {
+            size_t lineEnd = headers.find("\r\n");
+            std::string_view line = headers.substr(0, lineEnd);
+            headers = lineEnd == std::string_view::npos ? std::string_view() : headers.substr(lineEnd + 2);
+
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                continue;
+            }
+            std::string_view field = trim(line.substr(0, colon));
+            std::string_view value = trim(line.substr(colon + 1));
+            if (equalsIgnoreCase(field, "Content-Disposition")) {
+                part.name = parameter(value, "name");
+                part.filename = parameter(value, "filename");
+            } else if (equalsIgnoreCase(field, "Content-Type")) {
+                part.contentType = value;
+            }
+        }
+
+        size_t dataStart = headersEnd + 4;
+        std::string closing = "\r\n" + delimiter;
+        size_t dataEnd = body.find(closing, dataStart);
+        if (dataEnd == std::string_view::npos) {
+            return false;
+        }
+
+        if (part.name == name) {
+            part.data = body.substr(dataStart, dataEnd - dataStart);
+            out = part;
+            return true;
+        }
+        pos = dataEnd + 2;
+    }
+    return false;
+}
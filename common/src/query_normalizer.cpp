@@ -0,0 +1,211 @@
+#include "query_normalizer.h"
+#include "hash.h"
+#include <cstring>
+#include <openssl/evp.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Plegado de U+00C0..U+00FF (segundo byte 0x80..0xBF tras 0xC3) a ASCII.
+// nullptr = copiar el carácter tal cual.
+const char* const LATIN1_FOLD[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c",   // À Á Â Ã Ä Å Æ Ç
+    "e", "e", "e", "e", "i", "i", "i", "i",    // È É Ê Ë Ì Í Î Ï
+    "d", "n", "o", "o", "o", "o", "o", nullptr, // Ð Ñ Ò Ó Ô Õ Ö ×
+    "o", "u", "u", "u", "u", "y", nullptr, "ss", // Ø Ù Ú Û Ü Ý Þ ß
+    "a", "a", "a", "a", "a", "a", "ae", "c",   // à á â ã ä å æ ç
+    "e", "e", "e", "e", "i", "i", "i", "i",    // è é ê ë ì í î ï
+    "d", "n", "o", "o", "o", "o", "o", nullptr, // ð ñ ò ó ô õ ö ÷
+    "o", "u", "u", "u", "u", "y", nullptr, "y"  // ø ù ú û ü ý þ ÿ
+};
+
+enum ByteClass : uint8_t {
+    OTHER = 0,
+    SPACE,
+    PUNCT
+};
+
+struct ByteTable {
+    uint8_t cls[256];
+    char lower[256];
+
+    ByteTable() {
+        for (int c = 0; c < 256; c++) {
+            cls[c] = OTHER;
+            lower[c] = static_cast<char>(c);
+        }
+        for (int c = 'A'; c <= 'Z'; c++) {
+            lower[c] = static_cast<char>(c + 32);
+        }
+        for (char c : std::string(" \t\n\v\f\r")) {
+            cls[static_cast<uint8_t>(c)] = SPACE;
+        }
+        // Mismo conjunto que la clase de puntuación usada antes con std::regex
+        for (char c : std::string("!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~")) {
+            cls[static_cast<uint8_t>(c)] = PUNCT;
+        }
+    }
+};
+
+const ByteTable TABLE;
+
+// Estado de la pasada: posición de salida y secuencia de puntuación en curso
+struct Writer {
+    char* out;
+    size_t pos = 0;
+    size_t punctStart = 0;
+    size_t punctCount = 0;
+
+    void space() {
+        punctCount = 0;
+        if (pos > 0 && out[pos - 1] != ' ') {
+            out[pos++] = ' ';
+        }
+    }
+
+    void punct(char c) {
+        if (punctCount == 0) {
+            punctStart = pos;
+            out[pos++] = c;
+            punctCount = 1;
+        } else if (++punctCount == 2) {
+            // Dos o más signos seguidos se reducen a un espacio
+            pos = punctStart;
+            space();
+            punctCount = 2;
+        }
+    }
+
+    void bytes(const char* data, size_t length) {
+        punctCount = 0;
+        std::memcpy(out + pos, data, length);
+        pos += length;
+    }
+
+    void byte(char c) {
+        punctCount = 0;
+        out[pos++] = c;
+    }
+};
+
+} // namespace
+
+size_t QueryNormalizer::normalize(const char* input, size_t length, char* out) {
+    Writer w{out};
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
+    size_t i = 0;
+
+    while (i < length) {
+#ifdef __SSE2__
+        // Tramos alfanuméricos ASCII: pasar a minúsculas de 16 en 16 bytes
+        if (i + 16 <= length) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                             _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+            __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+            unsigned special = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(isLetter, isDigit))) & 0xFFFF;
+            size_t run = special ? static_cast<size_t>(__builtin_ctz(special)) : 16;
+
+            if (run > 0) {
+                __m128i lowered = _mm_or_si128(v, _mm_and_si128(isLetter, _mm_set1_epi8(0x20)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + w.pos), lowered);
+                w.pos += run;
+                w.punctCount = 0;
+                i += run;
+                continue;
+            }
+        }
+#endif
+        uint8_t c = in[i];
+
+        if (c < 0x80) {
+            switch (TABLE.cls[c]) {
+                case SPACE:
+                    w.space();
+                    break;
+                case PUNCT:
+                    w.punct(static_cast<char>(c));
+                    break;
+                default:
+                    w.byte(TABLE.lower[c]);
+                    break;
+            }
+            i++;
+            continue;
+        }
+
+        // Secuencias UTF-8 de dos bytes del bloque Latin-1
+        if (i + 1 < length && (in[i + 1] & 0xC0) == 0x80) {
+            uint8_t next = in[i + 1];
+            if (c == 0xC3) {
+                const char* fold = LATIN1_FOLD[next - 0x80];
+                if (fold) {
+                    w.bytes(fold, std::strlen(fold));
+                } else {
+                    w.bytes(input + i, 2);
+                }
+                i += 2;
+                continue;
+            }
+            if (c == 0xC2) {
+                if (next == 0xA0) {
+                    w.space();                     // Espacio de no separación
+                } else if (next == 0xBF) {
+                    w.punct('?');                  // ¿
+                } else if (next == 0xA1) {
+                    w.punct('!');                  // ¡
+                } else if (next == 0xAB || next == 0xBB) {
+                    w.punct('"');                  // « »
+                } else {
+                    w.bytes(input + i, 2);
+                }
+                i += 2;
+                continue;
+            }
+        }
+
+        // Cualquier otro byte (otros alfabetos, UTF-8 inválido) se copia
+        w.byte(static_cast<char>(c));
+        i++;
+    }
+
+    if (w.pos > 0 && out[w.pos - 1] == ' ') {
+        w.pos--;
+    }
+    return w.pos;
+}
+
+void QueryNormalizer::normalize(const std::string& input, std::string& out) {
+    out.resize(input.size());
+    out.resize(normalize(input.data(), input.size(), &out[0]));
+}
+
+void QueryNormalizer::hash(const std::string& normalized, HashMode mode, std::string& outHex) {
+    if (mode == HashMode::FAST128) {
+        Hash::hex128(normalized, outHex);
+        return;
+    }
+
+    static const char* hexDigits = "0123456789abcdef";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(normalized.data(), normalized.size(), digest, &length, EVP_sha256(), nullptr);
+
+    outHex.resize(length * 2);
+    for (unsigned int i = 0; i < length; i++) {
+        outHex[2 * i] = hexDigits[digest[i] >> 4];
+        outHex[2 * i + 1] = hexDigits[digest[i] & 0x0F];
+    }
+}
+
+QueryNormalizer::HashMode QueryNormalizer::hashModeFromString(const std::string& name) {
+    if (name == "fast128" || name == "murmur3") {
+        return HashMode::FAST128;
+    }
+    return HashMode::SHA256;
+}
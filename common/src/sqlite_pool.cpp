@@ -0,0 +1,134 @@
+#include "sqlite_pool.h"
+#include "metrics.h"
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+
+// Registro de pools por ruta de base de datos
+static std::unordered_map<std::string, std::unique_ptr<SQLitePool>> pools;
+static std::mutex poolsMutex;
+
+static size_t defaultPoolSize() {
+    size_t cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 4;
+}
+
+SQLitePool::Connection::Connection(const std::string& dbPath) : db(nullptr) {
+    int rc = sqlite3_open_v2(dbPath.c_str(), &db,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        db = nullptr;
+        throw std::runtime_error("Error al abrir la conexión del pool");
+    }
+
+    // WAL permite lectores concurrentes mientras otra conexión escribe
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(db, 5000);
+}
+
+SQLitePool::Connection::~Connection() {
+    for (auto& entry : statements) {
+        sqlite3_finalize(entry.second);
+    }
+    if (db) {
+        sqlite3_close(db);
+    }
+}
+
+sqlite3_stmt* SQLitePool::Connection::prepare(const char* sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end()) {
+        return it->second;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Error al preparar la consulta: " << sqlite3_errmsg(db) << std::endl;
+        return nullptr;
+    }
+
+    statements.emplace(sql, stmt);
+    return stmt;
+}
+
+SQLitePool::Statement::~Statement() {
+    if (stmt) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+}
+
+SQLitePool::Handle::~Handle() {
+    if (conn) {
+        pool->release(conn);
+    }
+}
+
+SQLitePool& SQLitePool::forPath(const std::string& dbPath) {
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    auto it = pools.find(dbPath);
+    if (it == pools.end()) {
+        it = pools.emplace(dbPath, std::unique_ptr<SQLitePool>(new SQLitePool(dbPath, defaultPoolSize()))).first;
+    }
+    return *it->second;
+}
+
+void SQLitePool::configure(const std::string& dbPath, size_t maxConnections) {
+    if (maxConnections == 0) {
+        maxConnections = defaultPoolSize();
+    }
+
+    std::lock_guard<std::mutex> lock(poolsMutex);
+    auto it = pools.find(dbPath);
+    if (it == pools.end()) {
+        pools.emplace(dbPath, std::unique_ptr<SQLitePool>(new SQLitePool(dbPath, maxConnections)));
+    } else {
+        std::lock_guard<std::mutex> poolLock(it->second->poolMutex);
+        it->second->maxConnections = std::max(maxConnections, it->second->connections.size());
+    }
+}
+
+SQLitePool::SQLitePool(const std::string& dbPath, size_t maxConnections)
+    : dbPath(dbPath), maxConnections(maxConnections) {
+}
+
+SQLitePool::~SQLitePool() = default;
+
+SQLitePool::Handle SQLitePool::acquire() {
+    // Espera hasta obtener una conexión (incluye abrir una nueva)
+    static LatencyHistogram& waitStage = Metrics::stage("sqlite_wait");
+    Metrics::ScopedTimer timer(waitStage);
+    
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    while (idle.empty()) {
+        if (connections.size() < maxConnections) {
+            // Abrir una conexión nueva; se conserva para siempre en el pool
+            try {
+                connections.push_back(std::make_unique<Connection>(dbPath));
+            } catch (const std::exception& e) {
+                std::cerr << "Error al ampliar el pool de SQLite: " << e.what() << std::endl;
+                return Handle(this, nullptr);
+            }
+            return Handle(this, connections.back().get());
+        }
+        available.wait(lock);
+    }
+
+    Connection* conn = idle.back();
+    idle.pop_back();
+    return Handle(this, conn);
+}
+
+void SQLitePool::release(Connection* conn) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idle.push_back(conn);
+    }
+    available.notify_one();
+}
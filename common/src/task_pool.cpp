@@ -0,0 +1,134 @@
+#include "task_pool.h"
+#include <algorithm>
+
+static std::mutex sharedPoolMutex;
+static std::unique_ptr<TaskPool> sharedPool;
+static size_t sharedPoolThreads = 0;
+
+TaskPool::TaskPool(size_t threads) : running(true) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 4;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&TaskPool::workerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(batchesMutex);
+        running = false;
+    }
+    batchesSignal.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+TaskPool& TaskPool::shared() {
+    std::lock_guard<std::mutex> lock(sharedPoolMutex);
+    if (!sharedPool) {
+        sharedPool.reset(new TaskPool(sharedPoolThreads));
+    }
+    return *sharedPool;
+}
+
+void TaskPool::configure(size_t threads) {
+    std::lock_guard<std::mutex> lock(sharedPoolMutex);
+    sharedPoolThreads = threads;
+    if (!sharedPool) {
+        sharedPool.reset(new TaskPool(threads));
+    }
+}
+
+void TaskPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->fn = &fn;
+    batch->count = count;
+    {
+        std::lock_guard<std::mutex> lock(batchesMutex);
+        batches.push_back(batch);
+    }
+    // Despertar como mucho a tantos hilos como índices quedan para los demás
+    if (count - 1 >= workers.size()) {
+        batchesSignal.notify_all();
+    } else {
+        for (size_t i = 0; i < count - 1; i++) {
+            batchesSignal.notify_one();
+        }
+    }
+
+    while (runOne(*batch)) {
+    }
+    retire(batch);
+
+    {
+        std::unique_lock<std::mutex> lock(batch->doneMutex);
+        batch->doneSignal.wait(lock, [&batch]() { return batch->finished.load() == batch->count; });
+    }
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+bool TaskPool::runOne(Batch& batch) {
+    size_t index = batch.next.fetch_add(1);
+    if (index >= batch.count) {
+        return false;
+    }
+
+    try {
+        (*batch.fn)(index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(batch.doneMutex);
+        if (!batch.error) {
+            batch.error = std::current_exception();
+        }
+    }
+
+    if (batch.finished.fetch_add(1) + 1 == batch.count) {
+        std::lock_guard<std::mutex> lock(batch.doneMutex);
+        batch.doneSignal.notify_all();
+    }
+    return true;
+}
+
+void TaskPool::retire(const std::shared_ptr<Batch>& batch) {
+    std::lock_guard<std::mutex> lock(batchesMutex);
+    auto it = std::find(batches.begin(), batches.end(), batch);
+    if (it != batches.end()) {
+        batches.erase(it);
+    }
+}
+
+void TaskPool::workerLoop() {
+    size_t turn = 0;
+    while (true) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock(batchesMutex);
+            batchesSignal.wait(lock, [this]() { return !running || !batches.empty(); });
+            if (!running) {
+                return;
+            }
+            // Turnarse entre los lotes activos para que uno grande no acapare el pool
+            batch = batches[turn++ % batches.size()];
+        }
+
+        if (!runOne(*batch)) {
+            retire(batch);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
+
+// Caché LRU de documentos generados con presupuesto en bytes.
+// Las claves son hashes compactos de la solicitud canonicalizada y los datos
+// se guardan en búferes inmutables compartidos: un acierto solo copia el
+// shared_ptr. El documento se copia una vez, al cuerpo de la respuesta HTTP
+// (Crow solo lo admite como std::string). Al expulsar por presupuesto, las entradas
+// vigentes pueden bajar a un nivel en disco (spillDirectory) con su propio
+// límite; un acierto en disco vuelve a subir la entrada a memoria.
+class DocumentCache {
+public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Entry {
+        Buffer data;
+        std::string contentType;
+        time_t storedAt;
+    };
+
+    struct Stats {
+        size_t entries;
+        size_t bytes;
+        size_t spillEntries;
+        size_t spillBytes;
+        uint64_t hits;
+        uint64_t spillHits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
+    // spillDirectory vacío o maxSpillBytes 0 desactivan el nivel en disco
+    DocumentCache(size_t maxBytes, int ttlSeconds,
+                  const std::string& spillDirectory = "", size_t maxSpillBytes = 0);
+
+    bool get(const std::string& key, Entry& out);
+    void put(const std::string& key, Buffer data, const std::string& contentType);
+
+    Stats stats();
+
+private:
+    struct Node {
+        Entry entry;
+        size_t bytes;
+        std::list<std::string>::iterator position;
+    };
+
+    struct SpillNode {
+        size_t bytes;
+        std::list<std::string>::iterator position;
+    };
+
+    // Inserta conservando storedAt (las entradas subidas desde disco mantienen su edad)
+    void insert(const std::string& key, Entry entry);
+
+    // Coste contabilizado de una entrada (datos, tipo y estructura)
+    static size_t costOf(const std::string& key, const Entry& entry);
+    bool expired(const Entry& entry, time_t now) const;
+
+    // Expulsa desde el extremo menos usado hasta respetar el presupuesto;
+    // devuelve las entradas vigentes que deben bajar a disco
+    std::vector<std::pair<std::string, Entry>> evictLocked(time_t now);
+
+    std::string spillPath(const std::string& key) const;
+    void spill(const std::vector<std::pair<std::string, Entry>>& entries);
+    bool loadSpilled(const std::string& key, Entry& out);
+    void removeSpilledLocked(const std::string& key);
+
+    size_t maxBytes;
+    int ttlSeconds;
+    std::string spillDirectory;
+    size_t maxSpillBytes;
+
+    std::mutex cacheMutex;
+    std::list<std::string> lru;   // Más reciente al principio
+    std::unordered_map<std::string, Node> nodes;
+    size_t bytes;
+
+    std::list<std::string> spillLru;
+    std::unordered_map<std::string, SpillNode> spillNodes;
+    size_t spillBytes;
+
+    uint64_t hits;
+    uint64_t spillHits;
+    uint64_t misses;
+    uint64_t evictions;
+};
@@ -4,15 +4,21 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <curl/curl.h>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include "document_cache.h"
+#include "http_client.h"
 
 using json = nlohmann::json;
 
 class DocumentServiceClient {
 public:
-    DocumentServiceClient(const std::string& baseUrl = "http://localhost:5001");
-    ~DocumentServiceClient();
+    // La caché de documentos generados tiene presupuesto en bytes; con
+    // cacheSpillDirectory, lo expulsado de memoria baja a disco (hasta cacheSpillBytes)
+    DocumentServiceClient(const std::string& baseUrl = "http://localhost:5001",
+                          size_t cacheBytes = 64 * 1024 * 1024, int cacheTtlSeconds = 3600,
+                          const std::string& cacheSpillDirectory = "", size_t cacheSpillBytes = 0);
     
     struct DocumentRequest {
         std::string documentType;
@@ -23,29 +29,31 @@ public:
     struct DocumentResponse {
         bool success;
         std::string message;
-        std::vector<uint8_t> documentData;
+        DocumentCache::Buffer documentData;   // Compartido con la caché, inmutable
         std::string contentType;
     };
     
     // Métodos principales
     DocumentResponse generateDocument(const DocumentRequest& request);
+    // Varias solicitudes a la vez: las que no están en caché se envían juntas
+    // (HttpClient::performAll); las respuestas se devuelven en el mismo orden
+    std::vector<DocumentResponse> generateDocuments(const std::vector<DocumentRequest>& requests);
     std::vector<std::string> getAvailableTemplates();
+    DocumentCache::Stats cacheStats() { return cache.stats(); }
     std::vector<std::string> getTemplateQuestions(const std::string& templateId);
     
-private:
-    std::string baseUrl;
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp);
-    static size_t WriteMemoryCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    // Resolver listados y preguntas con el motor local en lugar de por HTTP
+    void setLocalTemplates(const std::string& templatesPath) { localTemplatesPath = templatesPath; }
     
-    // Caché para respuestas
-    struct CacheItem {
-        std::vector<uint8_t> data;
-        std::string contentType;
-        time_t timestamp;
-    };
+private:
+    // Cliente HTTP compartido (timeouts y reintentos según HttpClient::configure)
+    HttpClient& http;
+    std::string localTemplatesPath;
     
-    std::unordered_map<std::string, CacheItem> cache;
-    std::mutex cacheMutex;
+    // Caché de documentos generados, por hash de la solicitud canonicalizada
+    DocumentCache cache;
+    static std::string cacheKeyFor(const json& requestJson);
+    static json requestJsonFor(const DocumentRequest& request);
     
     // Utilidades HTTP
     std::string httpGet(const std::string& endpoint);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+struct DocumentTemplate;
+
+// Catálogo binario de plantillas generado por iam_template_catalog a partir
+// de document_service/templates. Contiene un índice ordenado por id, cadenas
+// internadas y las secciones ya divididas en literales y huecos, así que se
+// abre con mmap y se consulta sin leer ni parsear ningún JSON.
+//
+// Formato (little-endian, alineado a 8): cabecera, tablas de plantillas,
+// secciones, segmentos y referencias a cadenas, y el bloque de cadenas.
+class TemplateCatalog {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    // Huella del directorio de origen para detectar un catálogo desactualizado
+    struct Fingerprint {
+        uint64_t files = 0;
+        uint64_t totalBytes = 0;
+        int64_t newestWrite = 0;
+
+        bool operator==(const Fingerprint& other) const {
+            return files == other.files && totalBytes == other.totalBytes && newestWrite == other.newestWrite;
+        }
+    };
+
+    static Fingerprint fingerprintOf(const std::string& templatesPath);
+
+    // Escribe el catálogo (a un temporal y renombrando); false si falla
+    static bool write(const std::string& catalogPath,
+                      const std::vector<std::shared_ptr<const DocumentTemplate>>& templates,
+                      const Fingerprint& fingerprint);
+
+    // nullptr si no existe, la versión no coincide o el archivo está dañado
+    static std::shared_ptr<const TemplateCatalog> open(const std::string& catalogPath);
+
+    ~TemplateCatalog();
+
+    TemplateCatalog(const TemplateCatalog&) = delete;
+    TemplateCatalog& operator=(const TemplateCatalog&) = delete;
+
+    size_t size() const;
+    const Fingerprint& fingerprint() const { return source; }
+
+    std::vector<std::string> ids() const;
+    bool contains(std::string_view id) const;
+    bool questions(std::string_view id, std::vector<std::string>& out) const;
+
+    // Construye la plantilla compilada a partir de las tablas (sin parsear)
+    std::shared_ptr<const DocumentTemplate> materialize(std::string_view id) const;
+
+private:
+    struct StringRef;
+    struct Header;
+    struct TemplateRecord;
+    struct SectionRecord;
+    struct SegmentRecord;
+
+    TemplateCatalog() = default;
+
+    bool validate();
+    const TemplateRecord* findRecord(std::string_view id) const;
+    std::string_view text(const StringRef& ref) const;
+
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    Fingerprint source;
+
+    const Header* header = nullptr;
+    const TemplateRecord* templates = nullptr;
+    const SectionRecord* sections = nullptr;
+    const SegmentRecord* segments = nullptr;
+    const StringRef* refs = nullptr;
+    const char* strings = nullptr;
+};
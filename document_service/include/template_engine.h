@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "compiled_template.h"
+#include "template_catalog.h"
+#include "snapshot_ptr.h"
+
+// Plantilla de documento (document_service/templates/<id>.json) con sus
+// secciones ya compiladas, en el orden del archivo
+struct DocumentTemplate {
+    std::string id;
+    std::string name;
+    std::string description;
+    std::vector<std::string> questions;
+    std::vector<std::pair<std::string, CompiledTemplate>> sections;
+    std::vector<std::string> fields;   // Huecos de todas las secciones, sin repetir
+};
+
+// Motor de plantillas en proceso: sustituye la ida y vuelta HTTP al servicio
+// de documentos para los formatos de texto. Con un catálogo binario
+// configurado, las plantillas se reconstruyen desde él sin parsear ningún
+// JSON. Cada carga se publica como una instantánea inmutable (SnapshotPtr)
+// con todas las plantillas ya construidas: las consultas no toman ningún mutex.
+class TemplateEngine {
+public:
+    struct RenderResult {
+        std::string text;
+        std::vector<std::string> missingFields;
+    };
+
+    static TemplateEngine& forPath(const std::string& templatesPath);
+
+    // Usa catalogPath si está al día con el directorio; si falta o está
+    // desactualizado se parsean los JSON y se vuelve a escribir
+    static void configure(const std::string& templatesPath, const std::string& catalogPath);
+
+    // Lee y compila todos los <id>.json del directorio
+    static std::vector<std::shared_ptr<const DocumentTemplate>> loadDirectory(const std::string& templatesPath);
+
+    std::shared_ptr<const DocumentTemplate> find(const std::string& templateId) const;
+    std::vector<std::string> templateIds() const;
+    bool questions(const std::string& templateId, std::vector<std::string>& out) const;
+
+    // Secciones separadas por una línea en blanco; los campos sin valor quedan vacíos
+    RenderResult renderText(const DocumentTemplate& document, const nlohmann::json& parameters) const;
+
+    // Vuelve a cargar las plantillas y publica la instantánea nueva
+    size_t reload();
+
+private:
+    TemplateEngine(const std::string& templatesPath, const std::string& catalogPath);
+
+    struct Snapshot {
+        bool fromCatalog = false;
+        std::map<std::string, std::shared_ptr<const DocumentTemplate>> templates;
+    };
+
+    static std::shared_ptr<const DocumentTemplate> loadTemplate(const std::string& id, const std::string& filename);
+
+    std::string templatesPath;
+    std::string catalogPath;
+    SnapshotPtr<Snapshot> current;
+    std::mutex reloadMutex;
+
+    static std::mutex enginesMutex;
+    static std::map<std::string, std::unique_ptr<TemplateEngine>> engines;
+};
@@ -0,0 +1,222 @@
+#include "document_cache.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+// Cabecera de los archivos del nivel en disco
+static const char* SPILL_MAGIC = "IAMDOC1";
+static const char* SPILL_EXTENSION = ".doc";
+
+DocumentCache::DocumentCache(size_t maxBytes, int ttlSeconds, const std::string& spillDirectory, size_t maxSpillBytes)
+    : maxBytes(maxBytes), ttlSeconds(ttlSeconds), spillDirectory(spillDirectory), maxSpillBytes(maxSpillBytes),
+      bytes(0), spillBytes(0), hits(0), spillHits(0), misses(0), evictions(0) {
+    if (this->spillDirectory.empty() || this->maxSpillBytes == 0) {
+        this->spillDirectory.clear();
+        return;
+    }
+
+    // Los archivos de una ejecución anterior no están contabilizados: descartarlos
+    std::error_code ec;
+    fs::create_directories(this->spillDirectory, ec);
+    for (const auto& file : fs::directory_iterator(this->spillDirectory, ec)) {
+        if (file.path().extension() == SPILL_EXTENSION) {
+            fs::remove(file.path(), ec);
+        }
+    }
+    if (ec) {
+        std::cerr << "Error al preparar el directorio de caché de documentos: " << ec.message() << std::endl;
+        this->spillDirectory.clear();
+    }
+}
+
+size_t DocumentCache::costOf(const std::string& key, const Entry& entry) {
+    return (entry.data ? entry.data->size() : 0) + entry.contentType.size() + 2 * key.size() + sizeof(Node) + 64;
+}
+
+bool DocumentCache::expired(const Entry& entry, time_t now) const {
+    return ttlSeconds > 0 && now - entry.storedAt >= ttlSeconds;
+}
+
+bool DocumentCache::get(const std::string& key, Entry& out) {
+    time_t now = time(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        auto it = nodes.find(key);
+        if (it != nodes.end()) {
+            if (!expired(it->second.entry, now)) {
+                lru.splice(lru.begin(), lru, it->second.position);
+                out = it->second.entry;
+                hits++;
+                return true;
+            }
+            bytes -= it->second.bytes;
+            lru.erase(it->second.position);
+            nodes.erase(it);
+        }
+
+        if (spillDirectory.empty() || spillNodes.find(key) == spillNodes.end()) {
+            misses++;
+            return false;
+        }
+    }
+
+    // Leer del disco sin retener el mutex y subir la entrada a memoria
+    Entry spilled;
+    if (loadSpilled(key, spilled) && !expired(spilled, now)) {
+        out = spilled;
+        insert(key, std::move(spilled));
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        spillHits++;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    removeSpilledLocked(key);
+    misses++;
+    return false;
+}
+
+void DocumentCache::put(const std::string& key, Buffer data, const std::string& contentType) {
+    insert(key, Entry{std::move(data), contentType, time(nullptr)});
+}
+
+void DocumentCache::insert(const std::string& key, Entry entry) {
+    size_t cost = costOf(key, entry);
+
+    std::vector<std::pair<std::string, Entry>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        auto it = nodes.find(key);
+        if (it != nodes.end()) {
+            bytes -= it->second.bytes;
+            lru.erase(it->second.position);
+            nodes.erase(it);
+        }
+        removeSpilledLocked(key);
+
+        // Un documento mayor que todo el presupuesto no se guarda
+        if (cost > maxBytes) {
+            return;
+        }
+
+        lru.push_front(key);
+        nodes[key] = Node{std::move(entry), cost, lru.begin()};
+        bytes += cost;
+
+        evicted = evictLocked(time(nullptr));
+    }
+
+    spill(evicted);
+}
+
+std::vector<std::pair<std::string, DocumentCache::Entry>> DocumentCache::evictLocked(time_t now) {
+    std::vector<std::pair<std::string, Entry>> evicted;
+
+    while (bytes > maxBytes && !lru.empty()) {
+        auto it = nodes.find(lru.back());
+        if (!spillDirectory.empty() && !expired(it->second.entry, now)) {
+            evicted.emplace_back(it->first, it->second.entry);
+        }
+        bytes -= it->second.bytes;
+        nodes.erase(it);
+        lru.pop_back();
+        evictions++;
+    }
+    return evicted;
+}
+
+std::string DocumentCache::spillPath(const std::string& key) const {
+    return spillDirectory + "/" + key + SPILL_EXTENSION;
+}
+
+void DocumentCache::spill(const std::vector<std::pair<std::string, Entry>>& entries) {
+    for (const auto& item : entries) {
+        const Entry& entry = item.second;
+        if (!entry.data || entry.data->size() > maxSpillBytes) {
+            continue;
+        }
+
+        // Escribir a un temporal y renombrar para no dejar archivos a medias
+        std::string path = spillPath(item.first);
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "No se pudo escribir en la caché de documentos: " << temporary << std::endl;
+                continue;
+            }
+            file << SPILL_MAGIC << "\n" << entry.storedAt << "\n" << entry.contentType << "\n";
+            file.write(reinterpret_cast<const char*>(entry.data->data()), static_cast<std::streamsize>(entry.data->size()));
+            if (!file) {
+                std::remove(temporary.c_str());
+                continue;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto existing = spillNodes.find(item.first);
+        if (existing != spillNodes.end()) {
+            spillBytes -= existing->second.bytes;
+            spillLru.erase(existing->second.position);
+            spillNodes.erase(existing);
+        }
+        spillLru.push_front(item.first);
+        spillNodes[item.first] = SpillNode{entry.data->size(), spillLru.begin()};
+        spillBytes += entry.data->size();
+
+        while (spillBytes > maxSpillBytes && !spillLru.empty()) {
+            removeSpilledLocked(spillLru.back());
+        }
+    }
+}
+
+bool DocumentCache::loadSpilled(const std::string& key, Entry& out) {
+    std::ifstream file(spillPath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string magic, storedAt, contentType;
+    if (!std::getline(file, magic) || magic != SPILL_MAGIC ||
+        !std::getline(file, storedAt) || !std::getline(file, contentType)) {
+        return false;
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(file),
+                                                       std::istreambuf_iterator<char>());
+    try {
+        out.storedAt = static_cast<time_t>(std::stoll(storedAt));
+    } catch (const std::exception&) {
+        return false;
+    }
+    out.contentType = contentType;
+    out.data = std::move(data);
+    return true;
+}
+
+void DocumentCache::removeSpilledLocked(const std::string& key) {
+    auto it = spillNodes.find(key);
+    if (it == spillNodes.end()) {
+        return;
+    }
+
+    std::remove(spillPath(key).c_str());
+    spillBytes -= it->second.bytes;
+    spillLru.erase(it->second.position);
+    spillNodes.erase(it);
+}
+
+DocumentCache::Stats DocumentCache::stats() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return {nodes.size(), bytes, spillNodes.size(), spillBytes, hits, spillHits, misses, evictions};
+}
@@ -1,18 +1,21 @@
 // document_service/src/document_service_client.cpp
 #include "document_service_client.h"
+#include "hash.h"
+#include "template_engine.h"
 #include <iostream>
 #include <sstream>
 #include <chrono>
 
-DocumentServiceClient::DocumentServiceClient(const std::string& baseUrl) : baseUrl(baseUrl) {
-    curl_global_init(CURL_GLOBAL_ALL);
-}
-
-DocumentServiceClient::~DocumentServiceClient() {
-    curl_global_cleanup();
+DocumentServiceClient::DocumentServiceClient(const std::string& baseUrl, size_t cacheBytes, int cacheTtlSeconds,
+                                             const std::string& cacheSpillDirectory, size_t cacheSpillBytes)
+    : http(HttpClient::forUrl(baseUrl)), cache(cacheBytes, cacheTtlSeconds, cacheSpillDirectory, cacheSpillBytes) {
 }
 
 std::vector<std::string> DocumentServiceClient::getAvailableTemplates() {
+    if (!localTemplatesPath.empty()) {
+        return TemplateEngine::forPath(localTemplatesPath).templateIds();
+    }
+    
     std::vector<std::string> templates;
     try {
         std::string response = httpGet("/templates");
@@ -31,6 +34,11 @@ std::vector<std::string> DocumentServiceClient::getAvailableTemplates() {
 
 std::vector<std::string> DocumentServiceClient::getTemplateQuestions(const std::string& templateId) {
     std::vector<std::string> questions;
+    if (!localTemplatesPath.empty() &&
+        TemplateEngine::forPath(localTemplatesPath).questions(templateId, questions)) {
+        return questions;
+    }
+    
     try {
         std::string endpoint = "/templates/" + templateId + "/questions";
         std::string response = httpGet(endpoint);
@@ -52,27 +60,16 @@ DocumentServiceClient::DocumentResponse DocumentServiceClient::generateDocument(
     response.success = false;
     
     try {
-        // Crear JSON para la solicitud
-        json requestJson;
-        requestJson["document_type"] = request.documentType;
-        requestJson["parameters"] = request.parameters;
-        requestJson["output_format"] = request.outputFormat;
+        json requestJson = requestJsonFor(request);
         
-        // Verificar caché
-        std::string cacheKey = requestJson.dump();
-        {
-            std::lock_guard<std::mutex> lock(cacheMutex);
-            auto it = cache.find(cacheKey);
-            if (it != cache.end()) {
-                // Verificar si la caché todavía es válida (menos de 1 hora)
-                time_t now = time(nullptr);
-                if (now - it->second.timestamp < 3600) {
-                    response.success = true;
-                    response.documentData = it->second.data;
-                    response.contentType = it->second.contentType;
-                    return response;
-                }
-            }
+        // Verificar caché (la vigencia la controla DocumentCache)
+        std::string cacheKey = cacheKeyFor(requestJson);
+        DocumentCache::Entry cached;
+        if (cache.get(cacheKey, cached)) {
+            response.success = true;
+            response.documentData = cached.data;
+            response.contentType = cached.contentType;
+            return response;
         }
         
         // Enviar solicitud POST
@@ -80,18 +77,11 @@ DocumentServiceClient::DocumentResponse DocumentServiceClient::generateDocument(
         
         if (!data.empty()) {
             response.success = true;
-            response.documentData = data;
+            response.documentData = std::make_shared<const std::vector<uint8_t>>(std::move(data));
             response.contentType = contentType;
             
             // Guardar en caché
-            {
-                std::lock_guard<std::mutex> lock(cacheMutex);
-                CacheItem cacheItem;
-                cacheItem.data = data;
-                cacheItem.contentType = contentType;
-                cacheItem.timestamp = time(nullptr);
-                cache[cacheKey] = cacheItem;
-            }
+            cache.put(cacheKey, response.documentData, contentType);
         } else {
             response.message = "Error al generar documento: respuesta vacía";
         }
@@ -102,82 +92,95 @@ DocumentServiceClient::DocumentResponse DocumentServiceClient::generateDocument(
     return response;
 }
 
-// Implementación de funciones auxiliares
-size_t DocumentServiceClient::WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-
-size_t DocumentServiceClient::WriteMemoryCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t realsize = size * nmemb;
-    auto* mem = (std::pair<std::vector<uint8_t>, std::string>*)userp;
+std::vector<DocumentServiceClient::DocumentResponse> DocumentServiceClient::generateDocuments(
+    const std::vector<DocumentRequest>& requests) {
+    std::vector<DocumentResponse> responses(requests.size());
+    std::vector<std::string> cacheKeys(requests.size());
+    std::vector<size_t> misses;
+    std::vector<HttpClient::Request> posts;
     
-    size_t currentSize = mem->first.size();
-    mem->first.resize(currentSize + realsize);
-    memcpy(mem->first.data() + currentSize, contents, realsize);
+    for (size_t i = 0; i < requests.size(); i++) {
+        responses[i].success = false;
+        try {
+            json requestJson = requestJsonFor(requests[i]);
+            cacheKeys[i] = cacheKeyFor(requestJson);
+            DocumentCache::Entry cached;
+            if (cache.get(cacheKeys[i], cached)) {
+                responses[i].success = true;
+                responses[i].documentData = cached.data;
+                responses[i].contentType = cached.contentType;
+                continue;
+            }
+            
+            HttpClient::Request post;
+            post.method = "POST";
+            post.path = "/generate";
+            post.body = requestJson.dump();
+            post.headers.push_back("Content-Type: application/json");
+            posts.push_back(std::move(post));
+            misses.push_back(i);
+        } catch (const std::exception& e) {
+            responses[i].message = std::string("Error al generar documento: ") + e.what();
+        }
+    }
+    if (posts.empty()) {
+        return responses;
+    }
     
-    return realsize;
+    std::vector<HttpClient::Response> results = http.performAll(posts);
+    for (size_t k = 0; k < misses.size(); k++) {
+        HttpClient::Response& result = results[k];
+        DocumentResponse& response = responses[misses[k]];
+        if (!result.error.empty()) {
+            response.message = "Error al generar documento: " + result.error;
+        } else if (!result.ok()) {
+            response.message = "Error al generar documento: HTTP " + std::to_string(result.status);
+        } else if (result.body.empty()) {
+            response.message = "Error al generar documento: respuesta vacía";
+        } else {
+            response.success = true;
+            response.documentData = std::make_shared<const std::vector<uint8_t>>(result.body.begin(), result.body.end());
+            response.contentType = result.contentType;
+            cache.put(cacheKeys[misses[k]], response.documentData, result.contentType);
+        }
+    }
+    return responses;
+}
+
+json DocumentServiceClient::requestJsonFor(const DocumentRequest& request) {
+    json requestJson;
+    requestJson["document_type"] = request.documentType;
+    requestJson["parameters"] = request.parameters;
+    requestJson["output_format"] = request.outputFormat;
+    return requestJson;
 }
 
+std::string DocumentServiceClient::cacheKeyFor(const json& requestJson) {
+    // nlohmann::json ordena las claves de los objetos, así que dump() ya es canónico
+    return Hash::hex128(requestJson.dump());
+}
+
+// Implementación de funciones auxiliares
 std::string DocumentServiceClient::httpGet(const std::string& endpoint) {
-    CURL* curl = curl_easy_init();
-    std::string readBuffer;
-    std::string url = baseUrl + endpoint;
-    
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10);
-        
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            throw std::runtime_error(curl_easy_strerror(res));
-        }
-        
-        curl_easy_cleanup(curl);
-    } else {
-        throw std::runtime_error("Error al inicializar CURL");
+    HttpClient::Response response = http.get(endpoint);
+    if (!response.error.empty()) {
+        throw std::runtime_error(response.error);
     }
-    
-    return readBuffer;
+    if (!response.ok()) {
+        throw std::runtime_error("HTTP " + std::to_string(response.status));
+    }
+    return response.body;
 }
 
 std::pair<std::vector<uint8_t>, std::string> DocumentServiceClient::httpPostWithBinaryResponse(
     const std::string& endpoint, const std::string& jsonData) {
     
-    CURL* curl = curl_easy_init();
-    std::pair<std::vector<uint8_t>, std::string> result;
-    std::string url = baseUrl + endpoint;
-    
-    if (curl) {
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, jsonData.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30);
-        
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            throw std::runtime_error(curl_easy_strerror(res));
-        }
-        
-        // Obtener el tipo de contenido
-        char* content_type;
-        res = curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
-        if (res == CURLE_OK && content_type) {
-            result.second = content_type;
-        }
-        
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-    } else {
-        throw std::runtime_error("Error al inicializar CURL");
+    HttpClient::Response response = http.post(endpoint, jsonData);
+    if (!response.error.empty()) {
+        throw std::runtime_error(response.error);
     }
-    
-    return result;
+    if (!response.ok()) {
+        throw std::runtime_error("HTTP " + std::to_string(response.status));
+    }
+    return {std::vector<uint8_t>(response.body.begin(), response.body.end()), response.contentType};
 }
@@ -0,0 +1,404 @@
+#include "template_catalog.h"
+#include "template_engine.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+static const char CATALOG_MAGIC[8] = {'I', 'A', 'M', 'T', 'P', 'L', '\0', '\0'};
+
+struct TemplateCatalog::StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct TemplateCatalog::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t templateCount;
+    uint32_t sectionCount;
+    uint32_t segmentCount;
+    uint32_t refCount;
+    uint32_t reserved;
+    uint64_t sourceFiles;
+    uint64_t sourceBytes;
+    int64_t sourceNewestWrite;
+    uint64_t templatesOffset;
+    uint64_t sectionsOffset;
+    uint64_t segmentsOffset;
+    uint64_t refsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t fileSize;
+};
+
+// Rangos [first, first + count) sobre la tabla de referencias o de secciones
+struct TemplateCatalog::TemplateRecord {
+    StringRef id;
+    StringRef name;
+    StringRef description;
+    uint32_t firstQuestion;
+    uint32_t questionCount;
+    uint32_t firstField;
+    uint32_t fieldCount;
+    uint32_t firstSection;
+    uint32_t sectionCount;
+};
+
+struct TemplateCatalog::SectionRecord {
+    StringRef name;
+    uint32_t firstSlot;       // Nombres de los huecos, en la tabla de referencias
+    uint32_t slotCount;
+    uint32_t firstSegment;
+    uint32_t segmentCount;
+};
+
+struct TemplateCatalog::SegmentRecord {
+    StringRef literal;        // Vacío en los huecos
+    int32_t slot;             // -1 = literal; si no, índice local de la sección
+    uint32_t reserved;
+};
+
+static size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+TemplateCatalog::Fingerprint TemplateCatalog::fingerprintOf(const std::string& templatesPath) {
+    Fingerprint fingerprint;
+    std::error_code ec;
+    for (const auto& file : fs::directory_iterator(templatesPath, ec)) {
+        if (file.path().extension() != ".json") {
+            continue;
+        }
+        fingerprint.files++;
+        fingerprint.totalBytes += file.file_size(ec);
+        int64_t written = static_cast<int64_t>(file.last_write_time(ec).time_since_epoch().count());
+        fingerprint.newestWrite = std::max(fingerprint.newestWrite, written);
+    }
+    return fingerprint;
+}
+
+bool TemplateCatalog::write(const std::string& catalogPath,
+                            const std::vector<std::shared_ptr<const DocumentTemplate>>& input,
+                            const Fingerprint& fingerprint) {
+    std::vector<std::shared_ptr<const DocumentTemplate>> sorted(input);
+    sorted.erase(std::remove(sorted.begin(), sorted.end(), nullptr), sorted.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a->id < b->id; });
+
+    // Cadenas internadas: cada texto distinto se guarda una vez
+    std::string strings;
+    std::unordered_map<std::string, StringRef> interned;
+    auto intern = [&](const std::string& value) {
+        auto it = interned.find(value);
+        if (it != interned.end()) {
+            return it->second;
+        }
+        StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings.append(value);
+        interned.emplace(value, ref);
+        return ref;
+    };
+
+    std::vector<TemplateRecord> templateRecords;
+    std::vector<SectionRecord> sectionRecords;
+    std::vector<SegmentRecord> segmentRecords;
+    std::vector<StringRef> refRecords;
+
+    for (const auto& document : sorted) {
+        TemplateRecord record{};
+        record.id = intern(document->id);
+        record.name = intern(document->name);
+        record.description = intern(document->description);
+
+        record.firstQuestion = static_cast<uint32_t>(refRecords.size());
+        record.questionCount = static_cast<uint32_t>(document->questions.size());
+        for (const auto& question : document->questions) {
+            refRecords.push_back(intern(question));
+        }
+
+        record.firstField = static_cast<uint32_t>(refRecords.size());
+        record.fieldCount = static_cast<uint32_t>(document->fields.size());
+        for (const auto& field : document->fields) {
+            refRecords.push_back(intern(field));
+        }
+
+        record.firstSection = static_cast<uint32_t>(sectionRecords.size());
+        record.sectionCount = static_cast<uint32_t>(document->sections.size());
+        for (const auto& section : document->sections) {
+            const CompiledTemplate& compiled = section.second;
+            SectionRecord sectionRecord{};
+            sectionRecord.name = intern(section.first);
+
+            sectionRecord.firstSlot = static_cast<uint32_t>(refRecords.size());
+            sectionRecord.slotCount = static_cast<uint32_t>(compiled.slotNames.size());
+            for (const auto& slot : compiled.slotNames) {
+                refRecords.push_back(intern(slot));
+            }
+
+            sectionRecord.firstSegment = static_cast<uint32_t>(segmentRecords.size());
+            sectionRecord.segmentCount = static_cast<uint32_t>(compiled.segments.size());
+            for (const auto& segment : compiled.segments) {
+                SegmentRecord segmentRecord{};
+                segmentRecord.slot = segment.slot;
+                if (segment.slot < 0) {
+                    segmentRecord.literal = intern(compiled.literals.substr(segment.offset, segment.length));
+                }
+                segmentRecords.push_back(segmentRecord);
+            }
+            sectionRecords.push_back(sectionRecord);
+        }
+        templateRecords.push_back(record);
+    }
+
+    if (strings.size() > UINT32_MAX) {
+        std::cerr << "Catálogo de plantillas demasiado grande" << std::endl;
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.templateCount = static_cast<uint32_t>(templateRecords.size());
+    header.sectionCount = static_cast<uint32_t>(sectionRecords.size());
+    header.segmentCount = static_cast<uint32_t>(segmentRecords.size());
+    header.refCount = static_cast<uint32_t>(refRecords.size());
+    header.sourceFiles = fingerprint.files;
+    header.sourceBytes = fingerprint.totalBytes;
+    header.sourceNewestWrite = fingerprint.newestWrite;
+    header.templatesOffset = align8(sizeof(Header));
+    header.sectionsOffset = align8(header.templatesOffset + templateRecords.size() * sizeof(TemplateRecord));
+    header.segmentsOffset = align8(header.sectionsOffset + sectionRecords.size() * sizeof(SectionRecord));
+    header.refsOffset = align8(header.segmentsOffset + segmentRecords.size() * sizeof(SegmentRecord));
+    header.stringsOffset = align8(header.refsOffset + refRecords.size() * sizeof(StringRef));
+    header.stringsSize = strings.size();
+    header.fileSize = header.stringsOffset + strings.size();
+
+    std::vector<uint8_t> image(header.fileSize, 0);
+    auto put = [&image](uint64_t offset, const void* data, size_t size) {
+        if (size > 0) {
+            std::memcpy(image.data() + offset, data, size);
+        }
+    };
+    put(0, &header, sizeof(Header));
+    put(header.templatesOffset, templateRecords.data(), templateRecords.size() * sizeof(TemplateRecord));
+    put(header.sectionsOffset, sectionRecords.data(), sectionRecords.size() * sizeof(SectionRecord));
+    put(header.segmentsOffset, segmentRecords.data(), segmentRecords.size() * sizeof(SegmentRecord));
+    put(header.refsOffset, refRecords.data(), refRecords.size() * sizeof(StringRef));
+    put(header.stringsOffset, strings.data(), strings.size());
+
+    std::string temporary = catalogPath + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "No se pudo escribir el catálogo de plantillas: " << temporary << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!file) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), catalogPath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const TemplateCatalog> TemplateCatalog::open(const std::string& catalogPath) {
+    int fd = ::open(catalogPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "No se pudo proyectar el catálogo de plantillas: " << catalogPath << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<TemplateCatalog> catalog(new TemplateCatalog());
+    catalog->base = static_cast<const uint8_t*>(mapping);
+    catalog->length = static_cast<size_t>(info.st_size);
+    if (!catalog->validate()) {
+        std::cerr << "Catálogo de plantillas inválido o de otra versión: " << catalogPath << std::endl;
+        return nullptr;
+    }
+    return catalog;
+}
+
+TemplateCatalog::~TemplateCatalog() {
+    if (base) {
+        munmap(const_cast<uint8_t*>(base), length);
+    }
+}
+
+bool TemplateCatalog::validate() {
+    const Header* h = reinterpret_cast<const Header*>(base);
+    if (std::memcmp(h->magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 || h->version != FORMAT_VERSION ||
+        h->fileSize != length) {
+        return false;
+    }
+
+    auto fits = [this](uint64_t offset, uint64_t count, size_t size) {
+        return offset % 8 == 0 && offset <= length && count <= (length - offset) / size;
+    };
+    if (!fits(h->templatesOffset, h->templateCount, sizeof(TemplateRecord)) ||
+        !fits(h->sectionsOffset, h->sectionCount, sizeof(SectionRecord)) ||
+        !fits(h->segmentsOffset, h->segmentCount, sizeof(SegmentRecord)) ||
+        !fits(h->refsOffset, h->refCount, sizeof(StringRef)) ||
+        h->stringsOffset > length || h->stringsSize > length - h->stringsOffset) {
+        return false;
+    }
+
+    header = h;
+    templates = reinterpret_cast<const TemplateRecord*>(base + h->templatesOffset);
+    sections = reinterpret_cast<const SectionRecord*>(base + h->sectionsOffset);
+    segments = reinterpret_cast<const SegmentRecord*>(base + h->segmentsOffset);
+    refs = reinterpret_cast<const StringRef*>(base + h->refsOffset);
+    strings = reinterpret_cast<const char*>(base + h->stringsOffset);
+    source.files = h->sourceFiles;
+    source.totalBytes = h->sourceBytes;
+    source.newestWrite = h->sourceNewestWrite;
+
+    // Comprobar una vez todas las referencias para que las consultas no tengan que hacerlo
+    auto validString = [h](const StringRef& ref) {
+        return ref.offset <= h->stringsSize && ref.length <= h->stringsSize - ref.offset;
+    };
+    auto validRange = [](uint32_t first, uint32_t count, uint32_t total) {
+        return first <= total && count <= total - first;
+    };
+    for (uint32_t i = 0; i < h->refCount; i++) {
+        if (!validString(refs[i])) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->segmentCount; i++) {
+        if (!validString(segments[i].literal)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->sectionCount; i++) {
+        const SectionRecord& section = sections[i];
+        if (!validString(section.name) || !validRange(section.firstSlot, section.slotCount, h->refCount) ||
+            !validRange(section.firstSegment, section.segmentCount, h->segmentCount)) {
+            return false;
+        }
+        for (uint32_t s = 0; s < section.segmentCount; s++) {
+            int32_t slot = segments[section.firstSegment + s].slot;
+            if (slot >= static_cast<int32_t>(section.slotCount)) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < h->templateCount; i++) {
+        const TemplateRecord& record = templates[i];
+        if (!validString(record.id) || !validString(record.name) || !validString(record.description) ||
+            !validRange(record.firstQuestion, record.questionCount, h->refCount) ||
+            !validRange(record.firstField, record.fieldCount, h->refCount) ||
+            !validRange(record.firstSection, record.sectionCount, h->sectionCount)) {
+            return false;
+        }
+        if (i > 0 && !(text(templates[i - 1].id) < text(record.id))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view TemplateCatalog::text(const StringRef& ref) const {
+    return std::string_view(strings + ref.offset, ref.length);
+}
+
+size_t TemplateCatalog::size() const {
+    return header->templateCount;
+}
+
+const TemplateCatalog::TemplateRecord* TemplateCatalog::findRecord(std::string_view id) const {
+    const TemplateRecord* end = templates + header->templateCount;
+    const TemplateRecord* it = std::lower_bound(templates, end, id, [this](const TemplateRecord& record, std::string_view key) {
+        return text(record.id) < key;
+    });
+    return (it != end && text(it->id) == id) ? it : nullptr;
+}
+
+std::vector<std::string> TemplateCatalog::ids() const {
+    std::vector<std::string> result;
+    result.reserve(header->templateCount);
+    for (uint32_t i = 0; i < header->templateCount; i++) {
+        result.emplace_back(text(templates[i].id));
+    }
+    return result;
+}
+
+bool TemplateCatalog::contains(std::string_view id) const {
+    return findRecord(id) != nullptr;
+}
+
+bool TemplateCatalog::questions(std::string_view id, std::vector<std::string>& out) const {
+    const TemplateRecord* record = findRecord(id);
+    if (!record) {
+        return false;
+    }
+    out.clear();
+    out.reserve(record->questionCount);
+    for (uint32_t i = 0; i < record->questionCount; i++) {
+        out.emplace_back(text(refs[record->firstQuestion + i]));
+    }
+    return true;
+}
+
+std::shared_ptr<const DocumentTemplate> TemplateCatalog::materialize(std::string_view id) const {
+    const TemplateRecord* record = findRecord(id);
+    if (!record) {
+        return nullptr;
+    }
+
+    auto document = std::make_shared<DocumentTemplate>();
+    document->id = std::string(text(record->id));
+    document->name = std::string(text(record->name));
+    document->description = std::string(text(record->description));
+    for (uint32_t i = 0; i < record->questionCount; i++) {
+        document->questions.emplace_back(text(refs[record->firstQuestion + i]));
+    }
+    for (uint32_t i = 0; i < record->fieldCount; i++) {
+        document->fields.emplace_back(text(refs[record->firstField + i]));
+    }
+
+    for (uint32_t i = 0; i < record->sectionCount; i++) {
+        const SectionRecord& section = sections[record->firstSection + i];
+        CompiledTemplate compiled;
+        for (uint32_t s = 0; s < section.slotCount; s++) {
+            compiled.slotNames.emplace_back(text(refs[section.firstSlot + s]));
+        }
+        for (uint32_t s = 0; s < section.segmentCount; s++) {
+            const SegmentRecord& segment = segments[section.firstSegment + s];
+            if (segment.slot >= 0) {
+                compiled.segments.push_back({0, 0, segment.slot});
+            } else {
+                std::string_view literal = text(segment.literal);
+                compiled.segments.push_back({compiled.literals.size(), literal.size(), -1});
+                compiled.literals.append(literal);
+            }
+        }
+        document->sections.emplace_back(std::string(text(section.name)), std::move(compiled));
+    }
+    return document;
+}
@@ -0,0 +1,222 @@
+#include "template_engine.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+std::mutex TemplateEngine::enginesMutex;
+std::map<std::string, std::unique_ptr<TemplateEngine>> TemplateEngine::engines;
+
+static const char* SECTION_SEPARATOR = "\n\n";
+
+TemplateEngine& TemplateEngine::forPath(const std::string& templatesPath) {
+    std::lock_guard<std::mutex> lock(enginesMutex);
+    auto it = engines.find(templatesPath);
+    if (it == engines.end()) {
+        it = engines.emplace(templatesPath, std::unique_ptr<TemplateEngine>(new TemplateEngine(templatesPath, ""))).first;
+    }
+    return *it->second;
+}
+
+void TemplateEngine::configure(const std::string& templatesPath, const std::string& catalogPath) {
+    std::lock_guard<std::mutex> lock(enginesMutex);
+    auto it = engines.find(templatesPath);
+    if (it == engines.end()) {
+        engines.emplace(templatesPath, std::unique_ptr<TemplateEngine>(new TemplateEngine(templatesPath, catalogPath)));
+    } else if (it->second->catalogPath != catalogPath) {
+        {
+            std::lock_guard<std::mutex> reloadLock(it->second->reloadMutex);
+            it->second->catalogPath = catalogPath;
+        }
+        it->second->reload();
+    }
+}
+
+TemplateEngine::TemplateEngine(const std::string& templatesPath, const std::string& catalogPath)
+    : templatesPath(templatesPath), catalogPath(catalogPath) {
+    size_t loaded = reload();
+    std::cout << "Plantillas de documentos cargadas: " << loaded
+              << (current.read()->fromCatalog ? " (catálogo binario)" : "") << std::endl;
+}
+
+std::vector<std::shared_ptr<const DocumentTemplate>> TemplateEngine::loadDirectory(const std::string& templatesPath) {
+    std::vector<std::shared_ptr<const DocumentTemplate>> documents;
+
+    std::error_code ec;
+    for (const auto& file : fs::directory_iterator(templatesPath, ec)) {
+        if (file.path().extension() != ".json") {
+            continue;
+        }
+        auto document = loadTemplate(file.path().stem().string(), file.path().string());
+        if (document) {
+            documents.push_back(document);
+        }
+    }
+    if (ec) {
+        std::cerr << "Error al leer el directorio de plantillas " << templatesPath << ": " << ec.message() << std::endl;
+    }
+    return documents;
+}
+
+size_t TemplateEngine::reload() {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    auto next = std::make_shared<Snapshot>();
+
+    TemplateCatalog::Fingerprint fingerprint;
+    if (!catalogPath.empty()) {
+        // Sin directorio de origen (instalación solo con el catálogo) se usa tal cual
+        fingerprint = TemplateCatalog::fingerprintOf(templatesPath);
+        auto catalog = TemplateCatalog::open(catalogPath);
+        if (catalog && (fingerprint.files == 0 || catalog->fingerprint() == fingerprint)) {
+            // Todas se construyen al publicar: después el catálogo ya no se consulta
+            next->fromCatalog = true;
+            for (const auto& id : catalog->ids()) {
+                auto document = catalog->materialize(id);
+                if (document) {
+                    next->templates[id] = document;
+                }
+            }
+            size_t loaded = next->templates.size();
+            current.publish(std::move(next));
+            return loaded;
+        }
+        std::cerr << "Catálogo de plantillas ausente o desactualizado, leyendo " << templatesPath << std::endl;
+    }
+
+    auto documents = loadDirectory(templatesPath);
+    for (const auto& document : documents) {
+        next->templates[document->id] = document;
+    }
+    if (!catalogPath.empty() && fingerprint.files > 0 && !TemplateCatalog::write(catalogPath, documents, fingerprint)) {
+        std::cerr << "No se pudo regenerar el catálogo de plantillas: " << catalogPath << std::endl;
+    }
+
+    size_t loaded = next->templates.size();
+    current.publish(std::move(next));
+    return loaded;
+}
+
+std::shared_ptr<const DocumentTemplate> TemplateEngine::loadTemplate(const std::string& id, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "No se pudo abrir la plantilla: " << filename << std::endl;
+        return nullptr;
+    }
+
+    try {
+        // ordered_json conserva el orden de las secciones del archivo
+        nlohmann::ordered_json data = nlohmann::ordered_json::parse(file);
+        if (!data.contains("sections") || !data["sections"].is_object()) {
+            std::cerr << "Plantilla sin secciones: " << filename << std::endl;
+            return nullptr;
+        }
+
+        auto document = std::make_shared<DocumentTemplate>();
+        document->id = id;
+        document->name = data.value("name", id);
+        document->description = data.value("description", "");
+        if (data.contains("questions") && data["questions"].is_array()) {
+            for (const auto& question : data["questions"]) {
+                if (question.is_string()) {
+                    document->questions.push_back(question.get<std::string>());
+                }
+            }
+        }
+
+        for (const auto& section : data["sections"].items()) {
+            if (!section.value().is_string()) {
+                continue;
+            }
+            CompiledTemplate compiled = CompiledTemplate::compile(section.value().get<std::string>());
+            for (const auto& slot : compiled.slots()) {
+                if (std::find(document->fields.begin(), document->fields.end(), slot) == document->fields.end()) {
+                    document->fields.push_back(slot);
+                }
+            }
+            document->sections.emplace_back(section.key(), std::move(compiled));
+        }
+        return document;
+    } catch (const std::exception& e) {
+        std::cerr << "Error al cargar la plantilla " << filename << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const DocumentTemplate> TemplateEngine::find(const std::string& templateId) const {
+    auto snapshot = current.read();
+    auto it = snapshot->templates.find(templateId);
+    return it != snapshot->templates.end() ? it->second : nullptr;
+}
+
+std::vector<std::string> TemplateEngine::templateIds() const {
+    auto snapshot = current.read();
+    std::vector<std::string> ids;
+    ids.reserve(snapshot->templates.size());
+    for (const auto& entry : snapshot->templates) {
+        ids.push_back(entry.first);
+    }
+    return ids;
+}
+
+bool TemplateEngine::questions(const std::string& templateId, std::vector<std::string>& out) const {
+    auto snapshot = current.read();
+    auto it = snapshot->templates.find(templateId);
+    if (it == snapshot->templates.end()) {
+        return false;
+    }
+    out = it->second->questions;
+    return true;
+}
+
+TemplateEngine::RenderResult TemplateEngine::renderText(const DocumentTemplate& document,
+                                                        const nlohmann::json& parameters) const {
+    RenderResult result;
+
+    // Resolver cada campo una sola vez; los valores no textuales se serializan
+    std::unordered_map<std::string, std::string> converted;
+    std::unordered_map<std::string, const std::string*> fieldValues;
+    for (const auto& field : document.fields) {
+        auto it = parameters.is_object() ? parameters.find(field) : parameters.end();
+        if (it == parameters.end() || it->is_null()) {
+            result.missingFields.push_back(field);
+            continue;
+        }
+        if (it->is_string()) {
+            fieldValues[field] = it->get_ptr<const std::string*>();
+        } else {
+            fieldValues[field] = &(converted[field] = it->dump());
+        }
+    }
+
+    // Primera pasada: tamaño exacto de la salida
+    std::vector<std::vector<const std::string*>> sectionValues;
+    sectionValues.reserve(document.sections.size());
+    size_t total = 0;
+    for (const auto& section : document.sections) {
+        const auto& slots = section.second.slots();
+        std::vector<const std::string*> values(slots.size(), nullptr);
+        for (size_t i = 0; i < slots.size(); i++) {
+            auto it = fieldValues.find(slots[i]);
+            if (it != fieldValues.end()) {
+                values[i] = it->second;
+            }
+        }
+        total += section.second.renderedSize(values, CompiledTemplate::Missing::EMPTY);
+        sectionValues.push_back(std::move(values));
+    }
+    if (!document.sections.empty()) {
+        total += (document.sections.size() - 1) * std::char_traits<char>::length(SECTION_SEPARATOR);
+    }
+
+    // Segunda pasada: copiar al búfer ya reservado
+    result.text.reserve(total);
+    for (size_t i = 0; i < document.sections.size(); i++) {
+        if (i > 0) {
+            result.text.append(SECTION_SEPARATOR);
+        }
+        document.sections[i].second.renderTo(result.text, sectionValues[i], CompiledTemplate::Missing::EMPTY);
+    }
+    return result;
+}
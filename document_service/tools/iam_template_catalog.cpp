@@ -0,0 +1,40 @@
+// Compila document_service/templates en un catálogo binario para el gateway
+//
+//   iam_template_catalog <directorio_plantillas> <catalogo.cat>
+
+#include <iostream>
+#include "template_engine.h"
+#include "template_catalog.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Uso: " << argv[0] << " <directorio_plantillas> <catalogo.cat>" << std::endl;
+        return 1;
+    }
+
+    std::string templatesPath = argv[1];
+    std::string catalogPath = argv[2];
+
+    TemplateCatalog::Fingerprint fingerprint = TemplateCatalog::fingerprintOf(templatesPath);
+    auto documents = TemplateEngine::loadDirectory(templatesPath);
+    if (documents.empty()) {
+        std::cerr << "No se encontraron plantillas en " << templatesPath << std::endl;
+        return 1;
+    }
+
+    if (!TemplateCatalog::write(catalogPath, documents, fingerprint)) {
+        std::cerr << "No se pudo escribir " << catalogPath << std::endl;
+        return 1;
+    }
+
+    // Comprobar que el resultado se puede abrir
+    auto catalog = TemplateCatalog::open(catalogPath);
+    if (!catalog || catalog->size() != documents.size()) {
+        std::cerr << "El catálogo generado no es válido: " << catalogPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Catálogo de plantillas: " << catalog->size() << " de " << fingerprint.files
+              << " archivos -> " << catalogPath << std::endl;
+    return 0;
+}
@@ -4,6 +4,18 @@
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <memory>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+#include <ctime>
+#include "knowledge_index.h"
+#include "keyword_dictionary.h"
+#include "snapshot_ptr.h"
+
+class KnowledgeBase;
 
 class IAMigranteClient {
 public:
@@ -13,25 +25,81 @@ public:
         std::string source;
     };
     
-    static QueryResult processQuery(const std::string& query, const std::string& language, const std::string& knowledgeBasePath);
+    // kb se resuelve una vez (KnowledgeBase::forPath) fuera de la ruta de consulta
+    static QueryResult processQuery(const std::string& query, const std::string& language, const KnowledgeBase& kb);
     
 private:
-    static std::string detectIntentFromQuery(const std::string& query);
-    static std::vector<std::string> extractKeywords(const std::string& query);
-    static float calculateConfidence(const std::string& response);
+    static float calculateConfidence(const std::vector<KnowledgeHit>& ranked);
 };
 
+// Base de conocimiento de un directorio (knowledge_<idioma>.json y el
+// diccionario de palabras clave keywords.json).
+// Los datos se publican como una instantánea inmutable (SnapshotPtr): las
+// consultas no toman ningún mutex, ni siquiera mientras se recarga. reload() reconstruye los índices
+// fuera de la ruta de lectura; con un intervalo de recarga configurado, un hilo
+// vigila las fechas de modificación de los archivos y recarga al cambiar.
 class KnowledgeBase {
 public:
-    KnowledgeBase(const std::string& basePath);
+    struct Stats {
+        uint64_t version;
+        time_t loadedAt;
+        size_t languages;
+        size_t responses;
+    };
+    
+    // Toma el mutex del registro: resolver una vez y guardar la referencia
+    static KnowledgeBase& forPath(const std::string& basePath);
+    
+    // Ajusta la recarga automática (0 = desactivada) antes de usar la base
+    static void configure(const std::string& basePath, int reloadIntervalSeconds);
+    
+    // Respuestas ordenadas por relevancia: primero la de la intención detectada
+    // (relevancia 1.0) y después las mejores según BM25 sobre la consulta
+    std::vector<KnowledgeHit> findResponses(const std::string& intent, const std::string& query,
+                                            const std::vector<std::string>& keywords,
+                                            const std::string& language, size_t topK) const;
+    
+    std::string findResponse(const std::string& intent, const std::vector<std::string>& keywords, const std::string& language) const;
+    
+    // Diccionario de intenciones y palabras clave de esta base
+    std::shared_ptr<const KeywordDictionary> dictionary() const;
     
-    std::string findResponse(const std::string& intent, const std::vector<std::string>& keywords, const std::string& language);
+    // Relee los archivos y publica una instantánea nueva. Si un archivo no se
+    // puede leer se conservan los datos anteriores de ese idioma.
+    Stats reload();
+    
+    // Recarga solo si algún archivo cambió, apareció o desapareció
+    bool reloadIfChanged();
+    
+    Stats stats() const;
+    
+    ~KnowledgeBase();
     
 private:
+    KnowledgeBase(const std::string& basePath, int reloadIntervalSeconds);
+    
+    struct Snapshot {
+        std::unordered_map<std::string, std::shared_ptr<const KnowledgeIndex>> indexes;
+        std::shared_ptr<const KeywordDictionary> dictionary;
+        std::map<std::string, std::filesystem::file_time_type> sources;  // Archivo -> fecha
+        uint64_t version;
+        time_t loadedAt;
+    };
+    
+    std::shared_ptr<const Snapshot> buildSnapshot(const std::shared_ptr<const Snapshot>& previous) const;
+    std::map<std::string, std::filesystem::file_time_type> scanSources() const;
+    static bool loadKnowledgeData(const std::string& filename, KnowledgeIndex::Categories& outData);
+    static KnowledgeIndex::Categories defaultKnowledgeData(const std::string& language);
+    static Stats statsOf(const Snapshot& snapshot);
+    void watchLoop();
+    
     std::string basePath;
-    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<std::string>>> knowledgeData;
-    std::mutex dataMutex;
+    SnapshotPtr<Snapshot> current;
+    std::mutex reloadMutex;
     
-    void loadKnowledgeData(const std::string& language);
-    bool isDataLoaded(const std::string& language);
+    std::atomic<int> reloadIntervalSeconds;
+    std::atomic<bool> running;
+    std::mutex watchMutex;
+    std::condition_variable watchSignal;
+    std::thread watchThread;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Respuesta de la base de conocimiento con su puntuación
+struct KnowledgeHit {
+    std::string response;
+    std::string category;
+    float score;        // BM25 bruto
+    float relevance;    // score respecto al máximo alcanzable por la consulta (0..1)
+};
+
+// Índice invertido de las respuestas de un idioma con ranking BM25.
+// Se construye una vez al cargar knowledge_<idioma>.json y después solo se
+// lee, así que varias consultas pueden buscar en paralelo sin bloqueos.
+// Los términos se normalizan igual que las consultas (minúsculas, sin
+// diacríticos) y se descartan las palabras vacías más comunes en español e inglés.
+class KnowledgeIndex {
+public:
+    using Categories = std::unordered_map<std::string, std::vector<std::string>>;
+
+    explicit KnowledgeIndex(const Categories& categories);
+
+    // Las topK respuestas mejor puntuadas. Un término repetido en la consulta
+    // pesa más (se usa para reforzar las palabras clave de inmigración).
+    std::vector<KnowledgeHit> search(const std::string& query, size_t topK) const;
+
+    // Primera respuesta de una categoría (intención), con relevancia 1.0
+    bool findCategory(const std::string& category, KnowledgeHit& out) const;
+
+    // Divide un texto en términos indexables
+    static std::vector<std::string> tokenize(const std::string& text);
+
+    size_t size() const { return documents.size(); }
+
+private:
+    struct Document {
+        std::string response;
+        std::string category;
+        float length;
+    };
+
+    struct Posting {
+        uint32_t document;
+        uint32_t frequency;
+    };
+
+    struct Term {
+        float idf;
+        std::vector<Posting> postings;
+    };
+
+    std::vector<Document> documents;
+    std::unordered_map<std::string, Term> terms;
+    std::unordered_map<std::string, uint32_t> firstByCategory;
+    float averageLength = 0.0f;
+};
@@ -1,39 +1,65 @@
 #include "ia_migrante_client.h"
+#include "query_normalizer.h"
+#include "metrics.h"
 #include <iostream>
 #include <fstream>
-#include <regex>
 #include <algorithm>
+#include <chrono>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-// Singleton para la base de conocimiento
-static std::unordered_map<std::string, KnowledgeBase*> knowledgeBases;
+// Número de respuestas candidatas que se puntúan por consulta
+static const size_t KNOWLEDGE_TOP_K = 3;
+
+// Registro de bases de conocimiento por directorio
+static std::unordered_map<std::string, std::unique_ptr<KnowledgeBase>> knowledgeBases;
 static std::mutex kbMutex;
 
-KnowledgeBase* getKnowledgeBase(const std::string& basePath) {
+KnowledgeBase& KnowledgeBase::forPath(const std::string& basePath) {
     std::lock_guard<std::mutex> lock(kbMutex);
-    if (knowledgeBases.find(basePath) == knowledgeBases.end()) {
-        knowledgeBases[basePath] = new KnowledgeBase(basePath);
+    auto it = knowledgeBases.find(basePath);
+    if (it == knowledgeBases.end()) {
+        it = knowledgeBases.emplace(basePath, std::unique_ptr<KnowledgeBase>(new KnowledgeBase(basePath, 0))).first;
     }
-    return knowledgeBases[basePath];
+    return *it->second;
 }
 
-IAMigranteClient::QueryResult IAMigranteClient::processQuery(const std::string& query, const std::string& language, const std::string& knowledgeBasePath) {
-    QueryResult result;
+void KnowledgeBase::configure(const std::string& basePath, int reloadIntervalSeconds) {
+    if (reloadIntervalSeconds < 0) {
+        reloadIntervalSeconds = 0;
+    }
+    
+    std::lock_guard<std::mutex> lock(kbMutex);
+    auto it = knowledgeBases.find(basePath);
+    if (it == knowledgeBases.end()) {
+        knowledgeBases.emplace(basePath, std::unique_ptr<KnowledgeBase>(new KnowledgeBase(basePath, reloadIntervalSeconds)));
+    } else {
+        // Con watchMutex tomado, para que el vigilante no pierda el aviso entre
+        // comprobar el intervalo y ponerse a esperar
+        std::lock_guard<std::mutex> watchLock(it->second->watchMutex);
+        it->second->reloadIntervalSeconds = reloadIntervalSeconds;
+        it->second->watchSignal.notify_all();
+    }
+}
+
+IAMigranteClient::QueryResult IAMigranteClient::processQuery(const std::string& query, const std::string& language, const KnowledgeBase& kb) {
+    static LatencyHistogram& knowledgeStage = Metrics::stage("knowledge_base");
+    Metrics::ScopedTimer timer(knowledgeStage);
     
-    // Detectar la intención de la consulta
-    std::string intent = detectIntentFromQuery(query);
+    QueryResult result;
     
-    // Extraer palabras clave
-    std::vector<std::string> keywords = extractKeywords(query);
+    // Intención y palabras clave en una sola pasada del diccionario
+    thread_local std::string normalized;
+    QueryNormalizer::normalize(query, normalized);
+    KeywordDictionary::Matches matches = kb.dictionary()->scan(normalized);
     
     // Buscar en la base de conocimiento
-    KnowledgeBase* kb = getKnowledgeBase(knowledgeBasePath);
-    result.response = kb->findResponse(intent, keywords, language);
+    std::vector<KnowledgeHit> ranked = kb.findResponses(matches.intent, query, matches.keywords, language, KNOWLEDGE_TOP_K);
+    result.response = ranked.empty() ? "" : ranked.front().response;
     
-    // Calcular confianza
-    result.confidence = calculateConfidence(result.response);
+    // Calcular confianza a partir de la puntuación de la búsqueda
+    result.confidence = calculateConfidence(ranked);
     result.source = "knowledge_base";
     
     // Si la confianza es baja, podríamos implementar un fallback a OpenAI aquí
@@ -46,124 +72,93 @@ IAMigranteClient::QueryResult IAMigranteClient::processQuery(const std::string&
     return result;
 }
 
-std::string IAMigranteClient::detectIntentFromQuery(const std::string& query) {
-    // Implementación simple basada en palabras clave
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-    
-    if (lowerQuery.find("visa") != std::string::npos) {
-        return "visa_info";
-    } else if (lowerQuery.find("ciudadania") != std::string::npos || 
-              lowerQuery.find("ciudadanía") != std::string::npos || 
-              lowerQuery.find("citizenship") != std::string::npos) {
-        return "citizenship";
-    } else if (lowerQuery.find("green card") != std::string::npos || 
-              lowerQuery.find("residencia") != std::string::npos) {
-        return "green_card";
-    } else if (lowerQuery.find("asilo") != std::string::npos || 
-              lowerQuery.find("asylum") != std::string::npos) {
-        return "asylum";
-    } else if (lowerQuery.find("deportacion") != std::string::npos || 
-              lowerQuery.find("deportación") != std::string::npos || 
-              lowerQuery.find("deportation") != std::string::npos) {
-        return "deportation";
-    } else if (lowerQuery.find("daca") != std::string::npos) {
-        return "daca";
-    } else if (lowerQuery.find("tps") != std::string::npos) {
-        return "tps";
-    } else if (lowerQuery.find("i-") != std::string::npos) {
-        // Buscar formularios I-XXX
-        std::regex formRegex("i-[0-9]+");
-        std::smatch match;
-        if (std::regex_search(lowerQuery, match, formRegex)) {
-            return match.str(0);
-        }
+float IAMigranteClient::calculateConfidence(const std::vector<KnowledgeHit>& ranked) {
+    if (ranked.empty()) {
+        return 0.0;
     }
     
-    return "general_immigration";
-}
-
-std::vector<std::string> IAMigranteClient::extractKeywords(const std::string& query) {
-    std::vector<std::string> keywords;
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-    
-    // Lista de palabras clave de inmigración
-    std::vector<std::string> keywordList = {
-        "visa", "green card", "ciudadania", "ciudadanía", "citizenship", 
-        "residencia", "asilo", "asylum", "deportacion", "deportación", 
-        "deportation", "daca", "tps", "i-130", "i-485", "i-765", "i-601", 
-        "i-751", "n-400", "eb1", "eb2", "eb3", "eb4", "eb5", "h1b", 
-        "h2a", "h2b", "j1", "f1", "b1", "b2"
-    };
-    
-    for (const auto& keyword : keywordList) {
-        if (lowerQuery.find(keyword) != std::string::npos) {
-            keywords.push_back(keyword);
-        }
+    // Respuesta de la intención detectada
+    const KnowledgeHit& best = ranked.front();
+    if (best.relevance >= 1.0f && best.score == 0.0f) {
+        return 0.9;
     }
     
-    return keywords;
-}
-
-float IAMigranteClient::calculateConfidence(const std::string& response) {
-    // Implementación simple basada en longitud de respuesta
-    if (response.empty()) {
-        return 0.0;
-    }
+    // Proporción de la puntuación máxima alcanzable por la consulta: un solo
+    // término clave poco frecuente ya supera el umbral de 0.5
+    float confidence = 0.35f + 0.6f * best.relevance;
     
-    if (response.length() < 50) {
-        return 0.3;
-    } else if (response.length() < 200) {
-        return 0.6;
-    } else {
-        return 0.9;
+    // Si la segunda respuesta puntúa casi igual, la elección es ambigua
+    if (ranked.size() > 1 && ranked[1].score >= 0.9f * best.score) {
+        confidence -= 0.05f;
     }
+    
+    return std::min(confidence, 0.9f);
 }
 
 // Implementación de KnowledgeBase
-KnowledgeBase::KnowledgeBase(const std::string& basePath) : basePath(basePath) {
-    // Cargar datos iniciales en inglés y español
-    loadKnowledgeData("en");
-    loadKnowledgeData("es");
+KnowledgeBase::KnowledgeBase(const std::string& basePath, int reloadIntervalSeconds)
+    : basePath(basePath), reloadIntervalSeconds(reloadIntervalSeconds), running(true) {
+    // Cargar los datos iniciales (como mínimo inglés y español)
+    current.publish(buildSnapshot(nullptr));
+    watchThread = std::thread(&KnowledgeBase::watchLoop, this);
 }
 
-std::string KnowledgeBase::findResponse(const std::string& intent, const std::vector<std::string>& keywords, const std::string& language) {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    
-    // Asegurarse de que los datos estén cargados para este idioma
-    if (!isDataLoaded(language)) {
-        loadKnowledgeData(language);
+KnowledgeBase::~KnowledgeBase() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        running = false;
+        watchSignal.notify_all();
     }
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+}
+
+std::vector<KnowledgeHit> KnowledgeBase::findResponses(const std::string& intent, const std::string& query,
+                                                       const std::vector<std::string>& keywords,
+                                                       const std::string& language, size_t topK) const {
+    // La instantánea es inmutable: la búsqueda no toma ningún mutex
+    auto snapshot = current.read();
     
-    // Verificar si tenemos datos para este idioma
-    if (knowledgeData.find(language) == knowledgeData.end()) {
+    auto it = snapshot->indexes.find(language);
+    if (it == snapshot->indexes.end()) {
         // Fallback al inglés si el idioma solicitado no está disponible
-        if (language != "en" && knowledgeData.find("en") != knowledgeData.end()) {
-            return findResponse(intent, keywords, "en");
+        it = snapshot->indexes.find("en");
+        if (it == snapshot->indexes.end()) {
+            return {};
         }
-        return "Lo siento, no tengo información disponible en este momento.";
     }
+    const KnowledgeIndex& index = *it->second;
     
-    // Buscar respuestas basadas en intención
-    auto& langData = knowledgeData[language];
-    if (langData.find(intent) != langData.end()) {
-        // Tomar la primera respuesta disponible
-        if (!langData[intent].empty()) {
-            return langData[intent][0];
-        }
+    std::vector<KnowledgeHit> ranked;
+    KnowledgeHit intentHit;
+    if (index.findCategory(intent, intentHit)) {
+        ranked.push_back(intentHit);
     }
     
-    // Si no se encuentra por intención, buscar por palabras clave
+    // Las palabras clave de inmigración se repiten para que pesen el doble
+    std::string searchText = query;
     for (const auto& keyword : keywords) {
-        for (const auto& category : langData) {
-            for (const auto& response : category.second) {
-                // Si la respuesta contiene la palabra clave
-                if (response.find(keyword) != std::string::npos) {
-                    return response;
-                }
-            }
+        searchText += " " + keyword;
+    }
+    
+    for (auto& hit : index.search(searchText, topK)) {
+        if (ranked.size() >= topK) {
+            break;
+        }
+        if (!ranked.empty() && ranked.front().response == hit.response) {
+            continue;
         }
+        ranked.push_back(std::move(hit));
+    }
+    
+    return ranked;
+}
+
+std::string KnowledgeBase::findResponse(const std::string& intent, const std::vector<std::string>& keywords, const std::string& language) const {
+    std::vector<KnowledgeHit> ranked = findResponses(intent, "", keywords, language, 1);
+    if (!ranked.empty()) {
+        return ranked.front().response;
     }
     
     // Respuesta genérica si no se encuentra nada específico
@@ -174,33 +169,159 @@ std::string KnowledgeBase::findResponse(const std::string& intent, const std::ve
     }
 }
 
-void KnowledgeBase::loadKnowledgeData(const std::string& language) {
-    std::string filename = basePath + "/knowledge_" + language + ".json";
-    std::ifstream file(filename);
+std::shared_ptr<const KeywordDictionary> KnowledgeBase::dictionary() const {
+    return current.read()->dictionary;
+}
+
+KnowledgeBase::Stats KnowledgeBase::reload() {
+    std::lock_guard<std::mutex> lock(reloadMutex);
     
-    if (!file.is_open()) {
-        std::cerr << "No se pudo abrir el archivo de conocimiento: " << filename << std::endl;
+    std::shared_ptr<const Snapshot> snapshot = buildSnapshot(current.share());
+    current.publish(snapshot);
+    
+    Stats stats = statsOf(*snapshot);
+    std::cout << "Base de conocimiento recargada (" << basePath << "): versión " << stats.version
+              << ", " << stats.languages << " idiomas, " << stats.responses << " respuestas" << std::endl;
+    return stats;
+}
+
+bool KnowledgeBase::reloadIfChanged() {
+    if (scanSources() == current.read()->sources) {
+        return false;
+    }
+    reload();
+    return true;
+}
+
+KnowledgeBase::Stats KnowledgeBase::stats() const {
+    return statsOf(*current.read());
+}
+
+KnowledgeBase::Stats KnowledgeBase::statsOf(const Snapshot& snapshot) {
+    Stats stats{snapshot.version, snapshot.loadedAt, snapshot.indexes.size(), 0};
+    for (const auto& index : snapshot.indexes) {
+        stats.responses += index.second->size();
+    }
+    return stats;
+}
+
+// Archivo del diccionario de palabras clave dentro del directorio
+static const char* KEYWORDS_FILE = "keywords.json";
+
+// Idioma de un archivo knowledge_<idioma>.json; vacío para cualquier otro
+static std::string languageOf(const std::string& name) {
+    const std::string prefix = "knowledge_";
+    const std::string suffix = ".json";
+    if (name.size() <= prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return "";
+    }
+    return name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+}
+
+std::map<std::string, std::filesystem::file_time_type> KnowledgeBase::scanSources() const {
+    namespace fs = std::filesystem;
+    std::map<std::string, fs::file_time_type> sources;
+    
+    std::error_code ec;
+    for (fs::directory_iterator it(basePath, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (name != KEYWORDS_FILE && languageOf(name).empty()) {
+            continue;
+        }
         
-        // Crear datos de prueba básicos si no existe el archivo
-        knowledgeData[language]["visa_info"] = {
-            language == "es" ? 
-            "Las visas son permisos otorgados por el gobierno de EE.UU. para entrar al país. Existen diferentes tipos como turista (B1/B2), estudiante (F1), trabajo (H1B), entre otras." :
-            "Visas are permits granted by the U.S. government to enter the country. There are different types such as tourist (B1/B2), student (F1), work (H1B), among others."
-        };
+        std::error_code timeError;
+        auto modified = fs::last_write_time(it->path(), timeError);
+        if (!timeError) {
+            sources[name] = modified;
+        }
+    }
+    
+    return sources;
+}
+
+std::shared_ptr<const KnowledgeBase::Snapshot> KnowledgeBase::buildSnapshot(const std::shared_ptr<const Snapshot>& previous) const {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->sources = scanSources();
+    snapshot->version = previous ? previous->version + 1 : 1;
+    snapshot->loadedAt = time(nullptr);
+    
+    std::vector<std::string> failed;
+    for (const auto& source : snapshot->sources) {
+        const std::string& name = source.first;
+        const std::string language = languageOf(name);
         
-        knowledgeData[language]["green_card"] = {
-            language == "es" ? 
-            "La Green Card (Tarjeta de Residencia Permanente) permite a un extranjero vivir y trabajar permanentemente en Estados Unidos. Se puede obtener por familia, empleo, inversión, o asilo, entre otros caminos." :
-            "The Green Card (Permanent Resident Card) allows a foreign national to live and work permanently in the United States. It can be obtained through family, employment, investment, or asylum, among other paths."
-        };
+        // Reutilizar lo ya construido si el archivo no cambió
+        if (previous) {
+            auto before = previous->sources.find(name);
+            if (before != previous->sources.end() && before->second == source.second) {
+                if (name == KEYWORDS_FILE) {
+                    snapshot->dictionary = previous->dictionary;
+                    continue;
+                }
+                auto index = previous->indexes.find(language);
+                if (index != previous->indexes.end()) {
+                    snapshot->indexes[language] = index->second;
+                    continue;
+                }
+            }
+        }
         
-        knowledgeData[language]["citizenship"] = {
-            language == "es" ? 
-            "La ciudadanía estadounidense puede obtenerse por nacimiento en EE.UU., por tener padres estadounidenses, o por naturalización después de ser residente permanente durante al menos 5 años (3 años si está casado con un ciudadano estadounidense)." :
-            "U.S. citizenship can be obtained by birth in the U.S., by having U.S. citizen parents, or through naturalization after being a permanent resident for at least 5 years (3 years if married to a U.S. citizen)."
-        };
+        if (name == KEYWORDS_FILE) {
+            KeywordDictionary::Definition definition;
+            if (KeywordDictionary::loadDefinition(basePath + "/" + name, definition)) {
+                snapshot->dictionary = std::make_shared<const KeywordDictionary>(definition);
+            } else {
+                failed.push_back(name);
+            }
+            continue;
+        }
         
-        return;
+        KnowledgeIndex::Categories data;
+        if (loadKnowledgeData(basePath + "/" + name, data)) {
+            snapshot->indexes[language] = std::make_shared<const KnowledgeIndex>(data);
+        } else {
+            failed.push_back(name);
+        }
+    }
+    
+    // Un archivo a medio escribir no debe borrar los datos buenos: se conservan
+    // los datos anteriores y su fecha, para reintentar en la próxima revisión
+    for (const auto& name : failed) {
+        snapshot->sources.erase(name);
+        if (!previous || !previous->sources.count(name)) {
+            continue;
+        }
+        snapshot->sources[name] = previous->sources.at(name);
+        if (name == KEYWORDS_FILE) {
+            snapshot->dictionary = previous->dictionary;
+        } else if (previous->indexes.count(languageOf(name))) {
+            snapshot->indexes[languageOf(name)] = previous->indexes.at(languageOf(name));
+        }
+    }
+    
+    // Inglés y español siempre disponibles, aunque falte el archivo
+    for (const std::string language : {"en", "es"}) {
+        if (snapshot->indexes.find(language) == snapshot->indexes.end()) {
+            std::cerr << "No se pudo abrir el archivo de conocimiento: "
+                      << basePath << "/knowledge_" << language << ".json" << std::endl;
+            snapshot->indexes[language] = std::make_shared<const KnowledgeIndex>(defaultKnowledgeData(language));
+        }
+    }
+    
+    // Sin keywords.json se usa la lista integrada
+    if (!snapshot->dictionary) {
+        snapshot->dictionary = KeywordDictionary::builtin();
+    }
+    
+    return snapshot;
+}
+
+bool KnowledgeBase::loadKnowledgeData(const std::string& filename, KnowledgeIndex::Categories& outData) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
     }
     
     try {
@@ -212,13 +333,62 @@ void KnowledgeBase::loadKnowledgeData(const std::string& language) {
             for (auto& item : value) {
                 responses.push_back(item.get<std::string>());
             }
-            knowledgeData[language][key] = responses;
+            outData[key] = responses;
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error al cargar datos de conocimiento: " << e.what() << std::endl;
+        std::cerr << "Error al cargar datos de conocimiento (" << filename << "): " << e.what() << std::endl;
+        return false;
     }
+    
+    return true;
+}
+
+KnowledgeIndex::Categories KnowledgeBase::defaultKnowledgeData(const std::string& language) {
+    // Datos de prueba básicos si no existe el archivo
+    KnowledgeIndex::Categories data;
+    
+    data["visa_info"] = {
+        language == "es" ? 
+        "Las visas son permisos otorgados por el gobierno de EE.UU. para entrar al país. Existen diferentes tipos como turista (B1/B2), estudiante (F1), trabajo (H1B), entre otras." :
+        "Visas are permits granted by the U.S. government to enter the country. There are different types such as tourist (B1/B2), student (F1), work (H1B), among others."
+    };
+    
+    data["green_card"] = {
+        language == "es" ? 
+        "La Green Card (Tarjeta de Residencia Permanente) permite a un extranjero vivir y trabajar permanentemente en Estados Unidos. Se puede obtener por familia, empleo, inversión, o asilo, entre otros caminos." :
+        "The Green Card (Permanent Resident Card) allows a foreign national to live and work permanently in the United States. It can be obtained through family, employment, investment, or asylum, among other paths."
+    };
+    
+    data["citizenship"] = {
+        language == "es" ? 
+        "La ciudadanía estadounidense puede obtenerse por nacimiento en EE.UU., por tener padres estadounidenses, o por naturalización después de ser residente permanente durante al menos 5 años (3 años si está casado con un ciudadano estadounidense)." :
+        "U.S. citizenship can be obtained by birth in the U.S., by having U.S. citizen parents, or through naturalization after being a permanent resident for at least 5 years (3 years if married to a U.S. citizen)."
+    };
+    
+    return data;
 }
 
-bool KnowledgeBase::isDataLoaded(const std::string& language) {
-    return knowledgeData.find(language) != knowledgeData.end();
+void KnowledgeBase::watchLoop() {
+    std::unique_lock<std::mutex> lock(watchMutex);
+    while (running) {
+        int interval = reloadIntervalSeconds.load();
+        if (interval <= 0) {
+            // Sin recarga automática: esperar a que se configure o a la parada
+            watchSignal.wait(lock, [this] { return !running || reloadIntervalSeconds.load() > 0; });
+            continue;
+        }
+        
+        watchSignal.wait_for(lock, std::chrono::seconds(interval));
+        if (!running) {
+            break;
+        }
+        
+        lock.unlock();
+        try {
+            reloadIfChanged();
+        } catch (const std::exception& e) {
+            std::cerr << "Error al recargar la base de conocimiento: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
 }
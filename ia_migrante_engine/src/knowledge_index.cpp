@@ -0,0 +1,171 @@
+#include "knowledge_index.h"
+#include "query_normalizer.h"
+#include <algorithm>
+#include <unordered_set>
+#include <cmath>
+
+namespace {
+
+// Parámetros habituales de BM25
+const float K1 = 1.2f;
+const float B = 0.75f;
+
+const std::unordered_set<std::string> STOPWORDS = {
+    // Español (sin tildes, como quedan tras normalizar)
+    "a", "al", "como", "con", "cual", "cuales", "de", "del", "donde", "el", "en", "es", "esta",
+    "este", "la", "las", "lo", "los", "me", "mi", "mis", "o", "para", "por", "puedo", "que",
+    "se", "si", "sobre", "su", "sus", "un", "una", "y", "yo",
+    // Inglés
+    "an", "and", "are", "can", "do", "does", "for", "how", "i", "if", "in", "is", "it", "my",
+    "of", "on", "or", "the", "to", "what", "when", "where", "which", "with"
+};
+
+bool isTermChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+} // namespace
+
+std::vector<std::string> KnowledgeIndex::tokenize(const std::string& text) {
+    std::string normalized;
+    QueryNormalizer::normalize(text, normalized);
+
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < normalized.size()) {
+        if (!isTermChar(normalized[i])) {
+            i++;
+            continue;
+        }
+
+        // Un guion entre caracteres de término forma parte del término (i-485, n-400)
+        size_t start = i;
+        while (i < normalized.size() &&
+               (isTermChar(normalized[i]) ||
+                (normalized[i] == '-' && i + 1 < normalized.size() && isTermChar(normalized[i + 1])))) {
+            i++;
+        }
+
+        std::string token = normalized.substr(start, i - start);
+        if (STOPWORDS.find(token) == STOPWORDS.end()) {
+            tokens.push_back(std::move(token));
+        }
+    }
+    return tokens;
+}
+
+KnowledgeIndex::KnowledgeIndex(const Categories& categories) {
+    double totalLength = 0.0;
+
+    for (const auto& category : categories) {
+        // El nombre de la categoría (green_card -> "green card") cuenta como texto
+        std::string categoryText = category.first;
+        std::replace(categoryText.begin(), categoryText.end(), '_', ' ');
+
+        for (const auto& response : category.second) {
+            uint32_t documentId = static_cast<uint32_t>(documents.size());
+            std::vector<std::string> tokens = tokenize(categoryText + " " + response);
+
+            std::unordered_map<std::string, uint32_t> frequencies;
+            for (const auto& token : tokens) {
+                frequencies[token]++;
+            }
+            for (const auto& entry : frequencies) {
+                terms[entry.first].postings.push_back({documentId, entry.second});
+            }
+
+            firstByCategory.emplace(category.first, documentId);
+            documents.push_back({response, category.first, static_cast<float>(tokens.size())});
+            totalLength += tokens.size();
+        }
+    }
+
+    if (documents.empty()) {
+        return;
+    }
+
+    averageLength = static_cast<float>(totalLength / documents.size());
+
+    const double count = static_cast<double>(documents.size());
+    for (auto& entry : terms) {
+        double frequency = static_cast<double>(entry.second.postings.size());
+        entry.second.idf = static_cast<float>(std::log(1.0 + (count - frequency + 0.5) / (frequency + 0.5)));
+    }
+}
+
+bool KnowledgeIndex::findCategory(const std::string& category, KnowledgeHit& out) const {
+    auto it = firstByCategory.find(category);
+    if (it == firstByCategory.end()) {
+        return false;
+    }
+
+    const Document& document = documents[it->second];
+    out = {document.response, document.category, 0.0f, 1.0f};
+    return true;
+}
+
+std::vector<KnowledgeHit> KnowledgeIndex::search(const std::string& query, size_t topK) const {
+    std::vector<KnowledgeHit> hits;
+    if (documents.empty() || topK == 0) {
+        return hits;
+    }
+
+    std::unordered_map<std::string, float> queryTerms;
+    for (const auto& token : tokenize(query)) {
+        queryTerms[token] += 1.0f;
+    }
+
+    // Acumular solo sobre las listas de los términos de la consulta, en un
+    // vector denso reutilizado por hilo; touched guarda los documentos puntuados
+    // para devolver el vector a cero al terminar
+    thread_local std::vector<float> scores;
+    thread_local std::vector<uint32_t> touched;
+    if (scores.size() < documents.size()) {
+        scores.resize(documents.size(), 0.0f);
+    }
+    touched.clear();
+    float maxScore = 0.0f;
+
+    for (const auto& queryTerm : queryTerms) {
+        auto it = terms.find(queryTerm.first);
+        if (it == terms.end()) {
+            continue;
+        }
+
+        const Term& term = it->second;
+        float weight = queryTerm.second * term.idf;
+        maxScore += weight * (K1 + 1.0f);
+
+        for (const auto& posting : term.postings) {
+            float tf = static_cast<float>(posting.frequency);
+            float norm = K1 * (1.0f - B + B * documents[posting.document].length / averageLength);
+            if (scores[posting.document] == 0.0f) {
+                touched.push_back(posting.document);
+            }
+            scores[posting.document] += weight * tf * (K1 + 1.0f) / (tf + norm);
+        }
+    }
+
+    if (touched.empty()) {
+        return hits;
+    }
+
+    std::vector<std::pair<uint32_t, float>> ranked;
+    ranked.reserve(touched.size());
+    for (uint32_t document : touched) {
+        ranked.emplace_back(document, scores[document]);
+        scores[document] = 0.0f;
+    }
+    size_t count = std::min(topK, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const std::pair<uint32_t, float>& a, const std::pair<uint32_t, float>& b) {
+                          return a.second != b.second ? a.second > b.second : a.first < b.first;
+                      });
+
+    for (size_t i = 0; i < count; i++) {
+        const Document& document = documents[ranked[i].first];
+        hits.push_back({document.response, document.category, ranked[i].second,
+                        std::min(1.0f, ranked[i].second / maxScore)});
+    }
+    return hits;
+}
@@ -4,19 +4,47 @@
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <memory>
 #include <sqlite3.h>
+#include "pattern_matcher.h"
+#include "query_cache.h"
+#include "query_normalizer.h"
+#include "mpsc_ring.h"
+#include "keyword_dictionary.h"
 
 class LearningEngine {
 public:
-    LearningEngine(const std::string& dbPath);
+    // Devuelve el diccionario vigente (p. ej. el de una KnowledgeBase, que se recarga)
+    using DictionarySource = std::function<std::shared_ptr<const KeywordDictionary>()>;
+
+    // Sin dictionarySource se usa el diccionario integrado
+    LearningEngine(const std::string& dbPath, size_t maxCacheEntries = 10000,
+                   QueryNormalizer::HashMode hashMode = QueryNormalizer::HashMode::SHA256,
+                   size_t eventQueueSize = 8192, DictionarySource dictionarySource = nullptr);
     ~LearningEngine();
 
-    // Registro de interacciones
+    // Registro de interacciones. No escriben en la base de datos: encolan el
+    // evento y un hilo lo persiste por lotes en una sola transacción.
     void recordInteraction(const std::string& query, const std::string& response, float confidence);
     void recordFeedback(int queryId, int userId, int score, const std::string& feedbackText);
     
     // Aprendizaje
-    void updatePatterns();
+    struct PatternUpdateResult {
+        int feedbackProcessed;   // Filas nuevas de learning_feedback revisadas
+        int queriesConsidered;   // Consultas con buen feedback entre ellas
+        int patternsLearned;
+        bool cancelled;
+    };
+    
+    // Incremental: solo revisa las consultas con feedback posterior a la última
+    // ejecución, por lotes y sin retener dbMutex entre ellos. Si cancelled se
+    // activa, se detiene entre lotes y la próxima ejecución repite el tramo.
+    PatternUpdateResult updatePatterns(const std::atomic<bool>* cancelled = nullptr);
     bool learnNewPattern(const std::string& pattern, const std::string& responseTemplate);
     
     // Aplicación de conocimiento aprendido
@@ -35,14 +63,89 @@ public:
         int feedbackCount;
         float averageConfidence;
         int patternsLastMonth;
+        
+        // Cola de escritura diferida
+        size_t pendingEvents;
+        size_t eventsWritten;
+        size_t eventBatches;
+        size_t eventQueueFull;   // Veces que un productor encontró la cola llena
+        size_t eventsDropped;    // Eventos descartados porque la cola siguió llena
     };
     
     LearningStats getStatistics();
+    
+    // Eventos en cola sin escribir; no consulta la base de datos
+    size_t pendingEvents() const { return events.size(); }
+    size_t droppedEvents() const { return eventsDropped.load(); }
 
 private:
     sqlite3* db;
     std::mutex dbMutex;
     
+    // Algoritmo de las claves de query_cache
+    QueryNormalizer::HashMode hashMode;
+    
+    // Diccionario de palabras clave que se usa al extraer patrones
+    DictionarySource dictionarySource;
+    
+    // Patrones aprendidos compilados en memoria
+    PatternMatcher patternMatcher;
+    void loadPatterns();
+    
+    // Inserta o actualiza patrones en una transacción y los publica en el buscador
+    size_t storePatterns(const std::vector<PatternMatcher::Pattern>& patterns);
+    
+    // Último id de learning_feedback ya procesado por updatePatterns
+    std::mutex updateMutex;
+    int loadFeedbackWatermark();
+    void saveFeedbackWatermark(int feedbackId);
+    
+    // Caché de consultas exactas en memoria (shared_lock por fragmento)
+    QueryCache queryCache;
+    void loadQueryCache(size_t maxEntries);
+    void flushQueryCacheUses();
+    
+    // Usos de patrones pendientes de escribir (use_count/last_used por lotes)
+    std::unordered_map<std::string, int> pendingPatternUses;
+    std::mutex patternUsesMutex;
+    void recordPatternUses(const std::vector<std::string>& patterns);
+    void flushPatternUses();
+    
+    // Interacciones y feedback pendientes de escribir
+    struct LearningEvent {
+        enum class Type { INTERACTION, FEEDBACK };
+        Type type = Type::INTERACTION;
+        std::string queryHash;
+        std::string query;
+        std::string response;      // También el texto del feedback
+        float confidence = 0.0f;
+        int queryId = 0;
+        int userId = 0;
+        int score = 0;
+    };
+    
+    MpscRing<LearningEvent> events;
+    std::atomic<size_t> eventsWritten;
+    std::atomic<size_t> eventBatches;
+    std::atomic<size_t> eventQueueFull;
+    std::atomic<size_t> eventsDropped;
+    std::mutex eventWriterMutex;   // Un solo consumidor de events a la vez
+    std::mutex eventSignalMutex;
+    std::condition_variable eventSignal;
+    std::thread eventWriterThread;
+    void enqueueEvent(LearningEvent& event);
+    void eventWriterLoop();
+    size_t flushEvents();
+    void writeEvents(const std::vector<LearningEvent>& batch);
+    void learnFromFeedback(int queryId);
+    
+    // Hilo que escribe en segundo plano los usos acumulados
+    std::atomic<bool> running;
+    std::mutex writeBackMutex;
+    std::condition_variable writeBackSignal;
+    std::thread writeBackThread;
+    void writeBackLoop();
+    
     // Hash para consultas
     std::string hashQuery(const std::string& query);
     
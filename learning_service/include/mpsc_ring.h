@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Cola circular acotada sin bloqueos para varios productores y un consumidor.
+// Cada celda lleva un número de secuencia que indica si está libre para el
+// productor de esa vuelta o lista para el consumidor, así que tryPush solo
+// compite por la posición de escritura con un compare-and-swap y nunca espera.
+// La capacidad se redondea a la siguiente potencia de dos.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        mask = rounded - 1;
+        cells.reset(new Cell[rounded]);
+        for (size_t i = 0; i < rounded; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // false si la cola está llena; el valor no se mueve en ese caso
+    bool tryPush(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Solo desde el hilo consumidor
+    bool tryPop(T& out) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Cell& cell = cells[position & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != position + 1) {
+            return false;
+        }
+
+        out = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        tail.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Aproximado mientras hay productores activos
+    size_t size() const {
+        size_t written = head.load(std::memory_order_relaxed);
+        size_t read = tail.load(std::memory_order_relaxed);
+        return written > read ? written - read : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    // Productores y consumidor en líneas de caché distintas
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include "snapshot_ptr.h"
+
+// Buscador de patrones aprendidos compilado en memoria.
+// Todos los patrones se compilan una sola vez en un autómata Aho-Corasick:
+//  - los literales y las alternancias de palabras clave (".*(visa|asilo).*",
+//    "\b(como|how)\b") se resuelven directamente en el autómata;
+//  - el resto se compila a std::regex una vez y solo se evalúa cuando su
+//    literal obligatorio más largo aparece en la consulta.
+// Así una consulta se recorre una sola vez, sin depender del tamaño de la tabla.
+// El autómata se publica en un SnapshotPtr: match() no toma ningún mutex.
+class PatternMatcher {
+public:
+    struct Pattern {
+        std::string text;
+        std::string responseTemplate;
+        float confidence;
+    };
+
+    PatternMatcher();
+
+    // Reemplaza todos los patrones (p. ej. al cargar learned_patterns)
+    void rebuild(std::vector<Pattern> patterns);
+
+    // Añade o actualiza patrones y publica un autómata nuevo
+    void add(const std::vector<Pattern>& patterns);
+
+    // Busca en una consulta ya normalizada. Devuelve el patrón de mayor
+    // confianza y, en matchedTexts, todos los patrones que coincidieron.
+    bool match(const std::string& normalizedQuery, Pattern& best, std::vector<std::string>& matchedTexts) const;
+
+    size_t size() const;
+
+private:
+    struct Compiled;
+
+    static std::shared_ptr<const Compiled> compile(std::vector<Pattern> patterns);
+
+    SnapshotPtr<Compiled> current;
+    std::mutex writeMutex;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <ctime>
+
+// Caché concurrente en memoria delante de la tabla query_cache.
+// Cada fragmento tiene su propio shared_mutex: las lecturas toman solo el
+// shared_lock de su fragmento y las escrituras se modifican en el sitio.
+// El desalojo es un reloj (segunda oportunidad): una lectura marca la entrada
+// como usada y la aguja salta las marcadas, sin recorrer el fragmento entero.
+// Los usos (use_count/last_used) se acumulan en contadores atómicos y se
+// recogen con drainPendingUses() para escribirlos en segundo plano.
+class QueryCache {
+public:
+    struct PendingUse {
+        std::string queryHash;
+        int uses;
+        time_t lastUsed;
+    };
+
+    explicit QueryCache(size_t capacity = 10000, size_t shardCount = 64);
+
+    // Busca una entrada vigente y registra el uso (shared_lock del fragmento)
+    bool lookup(const std::string& queryHash, time_t now, std::string& outResponse, float& outConfidence);
+
+    // Inserta o reemplaza una entrada (escrituras serializadas por fragmento)
+    void put(const std::string& queryHash, const std::string& response, float confidence,
+             time_t validUntil, int pendingUses = 0);
+
+    void erase(const std::string& queryHash);
+
+    // Extrae y pone a cero los usos acumulados desde la última llamada
+    std::vector<PendingUse> drainPendingUses();
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string queryHash;
+        std::string response;
+        float confidence;
+        time_t validUntil;
+        std::atomic<int> pendingUses{0};
+        std::atomic<time_t> lastUsed{0};
+        std::atomic<bool> referenced{false};   // Leída desde la última pasada de la aguja
+    };
+
+    struct Shard {
+        std::unordered_map<std::string, size_t> index;   // Posición en slots
+        std::vector<std::unique_ptr<Entry>> slots;
+        size_t hand = 0;
+        std::vector<PendingUse> evictedUses;             // Usos de entradas ya desalojadas
+        mutable std::shared_mutex mutex;
+    };
+
+    Shard& shardFor(const std::string& queryHash) const;
+
+    // Con el mutex del fragmento en exclusiva
+    size_t evict(Shard& shard, time_t now);
+    void retire(Shard& shard, Entry& entry);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardCapacity;
+};
@@ -1,267 +1,676 @@
 #include "learning_engine.h"
+#include "metrics.h"
+#include "compiled_template.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
-#include <regex>
 #include <chrono>
-#include <openssl/sha.h>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-LearningEngine::LearningEngine(const std::string& dbPath) {
+// Cada cuánto se escriben los usos acumulados de caché y patrones
+static const int WRITE_BACK_INTERVAL_MS = 2000;
+
+// Vigencia de las respuestas guardadas en query_cache
+static const time_t QUERY_CACHE_TTL_SECONDS = 3 * 24 * 3600;
+
+// Consultas revisadas por cada toma de dbMutex en updatePatterns
+static const int PATTERN_UPDATE_BATCH = 100;
+
+// Escritura diferida de interacciones y feedback: espera máxima entre lotes y
+// tamaño máximo de cada transacción
+static const int EVENT_FLUSH_INTERVAL_MS = 50;
+static const size_t EVENT_BATCH_SIZE = 1024;
+
+// Con la cola llena, el hilo de la petición reintenta como mucho este número
+// de veces (1 ms cada una) antes de descartar el evento
+static const int EVENT_FULL_RETRIES = 2;
+
+LearningEngine::LearningEngine(const std::string& dbPath, size_t maxCacheEntries, QueryNormalizer::HashMode hashMode,
+                               size_t eventQueueSize, DictionarySource dictionarySource)
+    : hashMode(hashMode), dictionarySource(std::move(dictionarySource)), queryCache(maxCacheEntries), events(eventQueueSize),
+      eventsWritten(0), eventBatches(0), eventQueueFull(0), eventsDropped(0), running(true) {
     int rc = sqlite3_open(dbPath.c_str(), &db);
     if (rc) {
         std::cerr << "No se pudo abrir la base de datos: " << sqlite3_errmsg(db) << std::endl;
         sqlite3_close(db);
         throw std::runtime_error("Error al abrir la base de datos de aprendizaje");
     }
+    
+    // Estado persistente del aprendizaje incremental
+    sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS learning_state (key TEXT PRIMARY KEY, value INTEGER)",
+                 nullptr, nullptr, nullptr);
+    
+    loadPatterns();
+    loadQueryCache(maxCacheEntries);
+    
+    writeBackThread = std::thread(&LearningEngine::writeBackLoop, this);
+    eventWriterThread = std::thread(&LearningEngine::eventWriterLoop, this);
 }
 
 LearningEngine::~LearningEngine() {
+    {
+        std::lock_guard<std::mutex> lock(writeBackMutex);
+        running = false;
+    }
+    writeBackSignal.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(eventSignalMutex);
+    }
+    eventSignal.notify_all();
+    if (writeBackThread.joinable()) {
+        writeBackThread.join();
+    }
+    if (eventWriterThread.joinable()) {
+        eventWriterThread.join();
+    }
+    
+    // Persistir lo que quedó en cola
+    while (flushEvents() > 0) {
+    }
+    flushQueryCacheUses();
+    flushPatternUses();
     if (db) {
         sqlite3_close(db);
     }
 }
 
-void LearningEngine::recordInteraction(const std::string& query, const std::string& response, float confidence) {
-    std::string queryHash = hashQuery(query);
-    
-    const char* sql = "INSERT OR REPLACE INTO query_cache (query_hash, query_text, response_text, confidence, last_used, use_count, valid_until) "
-                      "VALUES (?, ?, ?, ?, datetime('now'), COALESCE((SELECT use_count + 1 FROM query_cache WHERE query_hash = ?), 1), datetime('now', '+3 days'))";
+void LearningEngine::writeBackLoop() {
+    std::unique_lock<std::mutex> lock(writeBackMutex);
+    while (running) {
+        writeBackSignal.wait_for(lock, std::chrono::milliseconds(WRITE_BACK_INTERVAL_MS), [this] { return !running; });
+        if (!running) {
+            break;
+        }
+        
+        lock.unlock();
+        flushQueryCacheUses();
+        flushPatternUses();
+        lock.lock();
+    }
+}
+
+void LearningEngine::loadQueryCache(size_t maxEntries) {
+    // Precargar las entradas vigentes más usadas
+    const char* sql = "SELECT query_hash, response_text, confidence, CAST(strftime('%s', valid_until) AS INTEGER) "
+                      "FROM query_cache WHERE valid_until > datetime('now') "
+                      "ORDER BY use_count DESC, last_used DESC LIMIT ?";
     
-    sqlite3_stmt* stmt;
     std::lock_guard<std::mutex> lock(dbMutex);
     
+    sqlite3_stmt* stmt;
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
-        std::cerr << "Error al preparar la consulta: " << sqlite3_errmsg(db) << std::endl;
+        std::cerr << "Error al cargar la caché de consultas: " << sqlite3_errmsg(db) << std::endl;
         return;
     }
     
-    sqlite3_bind_text(stmt, 1, queryHash.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, query.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, response.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 4, confidence);
-    sqlite3_bind_text(stmt, 5, queryHash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(maxEntries));
     
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        std::cerr << "Error al insertar en caché: " << sqlite3_errmsg(db) << std::endl;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        queryCache.put(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                       reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                       sqlite3_column_double(stmt, 2),
+                       static_cast<time_t>(sqlite3_column_int64(stmt, 3)));
     }
     
     sqlite3_finalize(stmt);
 }
 
-void LearningEngine::recordFeedback(int queryId, int userId, int score, const std::string& feedbackText) {
-    const char* sql = "INSERT INTO learning_feedback (query_id, user_id, feedback_score, feedback_text) VALUES (?, ?, ?, ?)";
+void LearningEngine::flushQueryCacheUses() {
+    auto uses = queryCache.drainPendingUses();
+    if (uses.empty()) {
+        return;
+    }
     
-    sqlite3_stmt* stmt;
     std::lock_guard<std::mutex> lock(dbMutex);
     
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Error al preparar la inserción de feedback: " << sqlite3_errmsg(db) << std::endl;
+    const char* updateSql = "UPDATE query_cache SET use_count = use_count + ?, last_used = datetime(?, 'unixepoch') WHERE query_hash = ?";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, updateSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error al preparar la actualización de la caché: " << sqlite3_errmsg(db) << std::endl;
         return;
     }
     
-    sqlite3_bind_int(stmt, 1, queryId);
-    sqlite3_bind_int(stmt, 2, userId);
-    sqlite3_bind_int(stmt, 3, score);
-    sqlite3_bind_text(stmt, 4, feedbackText.c_str(), -1, SQLITE_STATIC);
-    
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        std::cerr << "Error al insertar feedback: " << sqlite3_errmsg(db) << std::endl;
+    sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+    for (const auto& use : uses) {
+        sqlite3_bind_int(stmt, 1, use.uses);
+        sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(use.lastUsed));
+        sqlite3_bind_text(stmt, 3, use.queryHash.c_str(), -1, SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
     }
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
     
     sqlite3_finalize(stmt);
+}
+
+void LearningEngine::loadPatterns() {
+    const char* sql = "SELECT pattern_text, response_template, confidence FROM learned_patterns "
+                      "ORDER BY confidence DESC, use_count DESC";
+    
+    std::vector<PatternMatcher::Pattern> patterns;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        
+        sqlite3_stmt* stmt;
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        if (rc != SQLITE_OK) {
+            std::cerr << "Error al cargar patrones aprendidos: " << sqlite3_errmsg(db) << std::endl;
+            return;
+        }
+        
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            PatternMatcher::Pattern pattern;
+            pattern.text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            pattern.responseTemplate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            pattern.confidence = sqlite3_column_double(stmt, 2);
+            patterns.push_back(std::move(pattern));
+        }
+        
+        sqlite3_finalize(stmt);
+    }
+    
+    patternMatcher.rebuild(std::move(patterns));
+}
+
+void LearningEngine::recordInteraction(const std::string& query, const std::string& response, float confidence) {
+    LearningEvent event;
+    event.type = LearningEvent::Type::INTERACTION;
+    event.queryHash = hashQuery(query);
+    event.query = query;
+    event.response = response;
+    event.confidence = confidence;
+    
+    // Visible en la caché en memoria de inmediato; la fila se escribe en el próximo lote
+    queryCache.put(event.queryHash, response, confidence, time(nullptr) + QUERY_CACHE_TTL_SECONDS);
+    enqueueEvent(event);
+}
+
+void LearningEngine::recordFeedback(int queryId, int userId, int score, const std::string& feedbackText) {
+    LearningEvent event;
+    event.type = LearningEvent::Type::FEEDBACK;
+    event.queryId = queryId;
+    event.userId = userId;
+    event.score = score;
+    event.response = feedbackText;
+    enqueueEvent(event);
+}
+
+void LearningEngine::enqueueEvent(LearningEvent& event) {
+    if (events.tryPush(event)) {
+        // Despertar al escritor antes de tiempo si la cola va por la mitad
+        if (events.size() >= events.capacity() / 2) {
+            eventSignal.notify_one();
+        }
+        return;
+    }
+    
+    // Cola llena: esperar un poco al escritor, pero nunca retener la petición
+    // más de EVENT_FULL_RETRIES ms; si sigue llena el evento se descarta
+    eventQueueFull++;
+    for (int attempt = 0; attempt < EVENT_FULL_RETRIES && running; attempt++) {
+        eventSignal.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (events.tryPush(event)) {
+            return;
+        }
+    }
+    
+    if (!running) {
+        // Durante el cierre el escritor ya no consume: escribir directamente
+        writeEvents({event});
+        return;
+    }
+    eventsDropped++;
+}
+
+void LearningEngine::eventWriterLoop() {
+    std::unique_lock<std::mutex> lock(eventSignalMutex);
+    while (running) {
+        eventSignal.wait_for(lock, std::chrono::milliseconds(EVENT_FLUSH_INTERVAL_MS));
+        
+        lock.unlock();
+        while (flushEvents() == EVENT_BATCH_SIZE) {
+        }
+        lock.lock();
+    }
+}
+
+size_t LearningEngine::flushEvents() {
+    std::vector<LearningEvent> batch;
+    {
+        std::lock_guard<std::mutex> lock(eventWriterMutex);
+        
+        LearningEvent event;
+        while (batch.size() < EVENT_BATCH_SIZE && events.tryPop(event)) {
+            batch.push_back(std::move(event));
+        }
+    }
+    
+    if (!batch.empty()) {
+        writeEvents(batch);
+    }
+    return batch.size();
+}
+
+void LearningEngine::writeEvents(const std::vector<LearningEvent>& batch) {
+    // El upsert conserva el id de la fila (referenciado por learning_feedback)
+    const char* interactionSql = "INSERT INTO query_cache (query_hash, query_text, response_text, confidence, last_used, use_count, valid_until) "
+                                 "VALUES (?, ?, ?, ?, datetime('now'), 1, datetime('now', '+3 days')) "
+                                 "ON CONFLICT(query_hash) DO UPDATE SET query_text = excluded.query_text, "
+                                 "response_text = excluded.response_text, confidence = excluded.confidence, "
+                                 "last_used = excluded.last_used, use_count = use_count + 1, valid_until = excluded.valid_until";
+    const char* feedbackSql = "INSERT INTO learning_feedback (query_id, user_id, feedback_score, feedback_text) VALUES (?, ?, ?, ?)";
+    
+    std::vector<int> positiveFeedback;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        
+        sqlite3_stmt* interactionStmt;
+        sqlite3_stmt* feedbackStmt;
+        if (sqlite3_prepare_v2(db, interactionSql, -1, &interactionStmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error al preparar la consulta: " << sqlite3_errmsg(db) << std::endl;
+            return;
+        }
+        if (sqlite3_prepare_v2(db, feedbackSql, -1, &feedbackStmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error al preparar la inserción de feedback: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_finalize(interactionStmt);
+            return;
+        }
+        
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+        for (const auto& event : batch) {
+            if (event.type == LearningEvent::Type::INTERACTION) {
+                sqlite3_bind_text(interactionStmt, 1, event.queryHash.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(interactionStmt, 2, event.query.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(interactionStmt, 3, event.response.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_double(interactionStmt, 4, event.confidence);
+                
+                if (sqlite3_step(interactionStmt) != SQLITE_DONE) {
+                    std::cerr << "Error al insertar en caché: " << sqlite3_errmsg(db) << std::endl;
+                }
+                sqlite3_reset(interactionStmt);
+            } else {
+                sqlite3_bind_int(feedbackStmt, 1, event.queryId);
+                sqlite3_bind_int(feedbackStmt, 2, event.userId);
+                sqlite3_bind_int(feedbackStmt, 3, event.score);
+                sqlite3_bind_text(feedbackStmt, 4, event.response.c_str(), -1, SQLITE_STATIC);
+                
+                if (sqlite3_step(feedbackStmt) != SQLITE_DONE) {
+                    std::cerr << "Error al insertar feedback: " << sqlite3_errmsg(db) << std::endl;
+                } else if (event.score >= 4) {
+                    positiveFeedback.push_back(event.queryId);
+                }
+                sqlite3_reset(feedbackStmt);
+            }
+        }
+        sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+        
+        sqlite3_finalize(interactionStmt);
+        sqlite3_finalize(feedbackStmt);
+    }
+    
+    eventsWritten += batch.size();
+    eventBatches++;
     
     // Si el feedback es positivo, considerar aprender de él
-    if (score >= 4) {
+    for (int queryId : positiveFeedback) {
+        learnFromFeedback(queryId);
+    }
+}
+
+void LearningEngine::learnFromFeedback(int queryId) {
+    std::string query, response;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        
         // Obtener la consulta relacionada
-        sql = "SELECT query_text, response_text FROM query_cache WHERE id = ?";
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-        if (rc != SQLITE_OK) {
+        sqlite3_stmt* stmt;
+        const char* sql = "SELECT query_text, response_text FROM query_cache WHERE id = ?";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
             return;
         }
         
         sqlite3_bind_int(stmt, 1, queryId);
         
-        std::string query, response;
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             query = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
             response = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         }
         
         sqlite3_finalize(stmt);
-        
-        if (!query.empty() && !response.empty()) {
-            // Extraer posibles patrones
-            auto patterns = extractPossiblePatterns(query);
-            for (const auto& pattern : patterns) {
-                // Verificar si ya existe un patrón similar
-                if (calculatePatternSuccessRate(pattern) > 0.7) {
-                    learnNewPattern(pattern, response);
-                }
+    }
+    
+    // calculatePatternSuccessRate y learnNewPattern toman dbMutex
+    if (!query.empty() && !response.empty()) {
+        // Extraer posibles patrones
+        auto patterns = extractPossiblePatterns(query);
+        for (const auto& pattern : patterns) {
+            // Verificar si ya existe un patrón similar
+            if (calculatePatternSuccessRate(pattern) > 0.7) {
+                learnNewPattern(pattern, response);
             }
         }
     }
 }
 
-void LearningEngine::updatePatterns() {
-    std::lock_guard<std::mutex> lock(dbMutex);
+LearningEngine::PatternUpdateResult LearningEngine::updatePatterns(const std::atomic<bool>* cancelled) {
+    PatternUpdateResult result{0, 0, 0, false};
     
-    // Buscar consultas frecuentes con buen feedback
-    const char* sql = "SELECT qc.query_text, qc.response_text, AVG(lf.feedback_score) as avg_score, COUNT(lf.id) as feedback_count "
-                      "FROM query_cache qc "
-                      "JOIN learning_feedback lf ON qc.id = lf.query_id "
-                      "GROUP BY qc.id "
-                      "HAVING avg_score >= 4.0 AND feedback_count >= 3 "
-                      "ORDER BY feedback_count DESC, avg_score DESC "
-                      "LIMIT 100";
+    // Una sola actualización a la vez; las consultas siguen usando dbMutex entre lotes
+    std::lock_guard<std::mutex> updateLock(updateMutex);
     
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Error al preparar actualización de patrones: " << sqlite3_errmsg(db) << std::endl;
-        return;
+    int fromFeedbackId = loadFeedbackWatermark();
+    int toFeedbackId = fromFeedbackId;
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        
+        sqlite3_stmt* stmt;
+        const char* rangeSql = "SELECT COALESCE(MAX(id), 0), COUNT(*) FROM learning_feedback WHERE id > ?";
+        if (sqlite3_prepare_v2(db, rangeSql, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error al preparar actualización de patrones: " << sqlite3_errmsg(db) << std::endl;
+            return result;
+        }
+        sqlite3_bind_int(stmt, 1, fromFeedbackId);
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 1) > 0) {
+            toFeedbackId = sqlite3_column_int(stmt, 0);
+            result.feedbackProcessed = sqlite3_column_int(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
     }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        std::string query = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        std::string response = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (toFeedbackId <= fromFeedbackId) {
+        return result;
+    }
+    
+    // Consultas con feedback nuevo que, contando todo su feedback, cumplen el umbral
+    const char* sql = "SELECT qc.id, qc.query_text, qc.response_text "
+                      "FROM query_cache qc "
+                      "JOIN learning_feedback lf ON qc.id = lf.query_id "
+                      "WHERE qc.id > ? AND lf.id <= ? "
+                      "AND qc.id IN (SELECT query_id FROM learning_feedback WHERE id > ? AND id <= ?) "
+                      "GROUP BY qc.id "
+                      "HAVING AVG(lf.feedback_score) >= 4.0 AND COUNT(lf.id) >= 3 "
+                      "ORDER BY qc.id "
+                      "LIMIT ?";
+    
+    int lastQueryId = 0;
+    while (true) {
+        if (cancelled && cancelled->load()) {
+            result.cancelled = true;
+            return result;
+        }
         
-        // Generar patrones a partir de consultas populares
-        auto patterns = extractPossiblePatterns(query);
-        for (const auto& pattern : patterns) {
-            if (!pattern.empty()) {
-                learnNewPattern(pattern, response);
+        std::vector<std::pair<std::string, std::string>> rows;
+        {
+            std::lock_guard<std::mutex> lock(dbMutex);
+            
+            sqlite3_stmt* stmt;
+            if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+                std::cerr << "Error al preparar actualización de patrones: " << sqlite3_errmsg(db) << std::endl;
+                return result;
+            }
+            
+            sqlite3_bind_int(stmt, 1, lastQueryId);
+            sqlite3_bind_int(stmt, 2, toFeedbackId);
+            sqlite3_bind_int(stmt, 3, fromFeedbackId);
+            sqlite3_bind_int(stmt, 4, toFeedbackId);
+            sqlite3_bind_int(stmt, 5, PATTERN_UPDATE_BATCH);
+            
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                lastQueryId = sqlite3_column_int(stmt, 0);
+                rows.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                  reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
+            }
+            
+            sqlite3_finalize(stmt);
+        }
+        
+        // Generar patrones a partir de las consultas del lote, ya sin dbMutex
+        std::vector<PatternMatcher::Pattern> patterns;
+        for (const auto& row : rows) {
+            for (const auto& pattern : extractPossiblePatterns(row.first)) {
+                if (!pattern.empty()) {
+                    patterns.push_back({pattern, row.second, 0.8f});
+                }
             }
         }
+        
+        result.queriesConsidered += static_cast<int>(rows.size());
+        result.patternsLearned += static_cast<int>(storePatterns(patterns));
+        
+        if (static_cast<int>(rows.size()) < PATTERN_UPDATE_BATCH) {
+            break;
+        }
     }
     
-    sqlite3_finalize(stmt);
+    saveFeedbackWatermark(toFeedbackId);
+    return result;
 }
 
 bool LearningEngine::learnNewPattern(const std::string& pattern, const std::string& responseTemplate) {
-    // Evitar patrones muy cortos o genéricos
-    if (pattern.length() < 10) {
-        return false;
+    return storePatterns({{pattern, responseTemplate, 0.8f}}) == 1;
+}
+
+size_t LearningEngine::storePatterns(const std::vector<PatternMatcher::Pattern>& patterns) {
+    std::vector<PatternMatcher::Pattern> stored;
+    
+    {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        
+        // learned_patterns no tiene clave única en pattern_text: actualizar y, si no existe, insertar
+        const char* updateSql = "UPDATE learned_patterns SET response_template = ?, confidence = ? WHERE pattern_text = ?";
+        const char* insertSql = "INSERT INTO learned_patterns (pattern_type, pattern_text, response_template, confidence) "
+                                "VALUES ('regex', ?, ?, ?)";
+        
+        sqlite3_stmt* updateStmt;
+        sqlite3_stmt* insertStmt;
+        if (sqlite3_prepare_v2(db, updateSql, -1, &updateStmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error al preparar inserción de patrón: " << sqlite3_errmsg(db) << std::endl;
+            return 0;
+        }
+        if (sqlite3_prepare_v2(db, insertSql, -1, &insertStmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error al preparar inserción de patrón: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_finalize(updateStmt);
+            return 0;
+        }
+        
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+        for (const auto& pattern : patterns) {
+            // Evitar patrones muy cortos o genéricos
+            if (pattern.text.length() < 10) {
+                continue;
+            }
+            
+            sqlite3_bind_text(updateStmt, 1, pattern.responseTemplate.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_double(updateStmt, 2, pattern.confidence);
+            sqlite3_bind_text(updateStmt, 3, pattern.text.c_str(), -1, SQLITE_STATIC);
+            bool success = sqlite3_step(updateStmt) == SQLITE_DONE;
+            sqlite3_reset(updateStmt);
+            
+            if (success && sqlite3_changes(db) == 0) {
+                sqlite3_bind_text(insertStmt, 1, pattern.text.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(insertStmt, 2, pattern.responseTemplate.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_double(insertStmt, 3, pattern.confidence);
+                success = sqlite3_step(insertStmt) == SQLITE_DONE;
+                sqlite3_reset(insertStmt);
+            }
+            
+            if (success) {
+                stored.push_back(pattern);
+            } else {
+                std::cerr << "Error al guardar patrón: " << sqlite3_errmsg(db) << std::endl;
+            }
+        }
+        sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+        
+        sqlite3_finalize(updateStmt);
+        sqlite3_finalize(insertStmt);
     }
     
-    const char* sql = "INSERT OR REPLACE INTO learned_patterns (pattern_type, pattern_text, response_template, confidence) "
-                      "VALUES ('regex', ?, ?, 0.8)";
+    // Publicar los patrones en el buscador compilado sin releer la tabla
+    if (!stored.empty()) {
+        patternMatcher.add(stored);
+    }
     
-    sqlite3_stmt* stmt;
+    return stored.size();
+}
+
+int LearningEngine::loadFeedbackWatermark() {
     std::lock_guard<std::mutex> lock(dbMutex);
     
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Error al preparar inserción de patrón: " << sqlite3_errmsg(db) << std::endl;
-        return false;
+    int feedbackId = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT value FROM learning_state WHERE key = 'feedback_watermark'", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            feedbackId = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
     }
+    return feedbackId;
+}
+
+void LearningEngine::saveFeedbackWatermark(int feedbackId) {
+    std::lock_guard<std::mutex> lock(dbMutex);
     
-    sqlite3_bind_text(stmt, 1, pattern.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, responseTemplate.c_str(), -1, SQLITE_STATIC);
-    
-    rc = sqlite3_step(stmt);
-    bool success = (rc == SQLITE_DONE);
-    
+    sqlite3_stmt* stmt;
+    const char* sql = "INSERT OR REPLACE INTO learning_state (key, value) VALUES ('feedback_watermark', ?)";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error al guardar el estado de aprendizaje: " << sqlite3_errmsg(db) << std::endl;
+        return;
+    }
+    sqlite3_bind_int(stmt, 1, feedbackId);
+    sqlite3_step(stmt);
     sqlite3_finalize(stmt);
-    return success;
 }
 
 LearningEngine::PatternMatch LearningEngine::findMatchingPattern(const std::string& query) {
+    static LatencyHistogram& patternStage = Metrics::stage("pattern_match");
+    Metrics::ScopedTimer timer(patternStage);
+    
     PatternMatch result;
     result.confidence = 0.0;
     result.isExactMatch = false;
     
-    // Primero buscar en caché para consulta exacta
-    std::string queryHash = hashQuery(query);
-    const char* cacheSql = "SELECT response_text, confidence FROM query_cache "
-                          "WHERE query_hash = ? AND valid_until > datetime('now') "
-                          "ORDER BY use_count DESC, last_used DESC LIMIT 1";
-    
-    sqlite3_stmt* stmt;
-    std::lock_guard<std::mutex> lock(dbMutex);
-    
-    int rc = sqlite3_prepare_v2(db, cacheSql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        return result;
-    }
-    
-    sqlite3_bind_text(stmt, 1, queryHash.c_str(), -1, SQLITE_STATIC);
+    // Normalizar una sola vez para el hash y para los patrones
+    thread_local std::string normalized;
+    QueryNormalizer::normalize(query, normalized);
     
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result.responseTemplate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        result.confidence = sqlite3_column_double(stmt, 1);
+    // Primero buscar en la caché en memoria (solo lecturas compartidas)
+    std::string queryHash;
+    QueryNormalizer::hash(normalized, hashMode, queryHash);
+    time_t now = time(nullptr);
+    if (queryCache.lookup(queryHash, now, result.responseTemplate, result.confidence)) {
         result.isExactMatch = true;
-        
-        // Actualizar estadísticas de uso
-        const char* updateSql = "UPDATE query_cache SET use_count = use_count + 1, last_used = datetime('now') WHERE query_hash = ?";
-        sqlite3_stmt* updateStmt;
-        sqlite3_prepare_v2(db, updateSql, -1, &updateStmt, nullptr);
-        sqlite3_bind_text(updateStmt, 1, queryHash.c_str(), -1, SQLITE_STATIC);
-        sqlite3_step(updateStmt);
-        sqlite3_finalize(updateStmt);
+        return result;
     }
     
-    sqlite3_finalize(stmt);
+    // Fallo en memoria: consultar SQLite y publicar la entrada si existe
+    const char* cacheSql = "SELECT response_text, confidence, CAST(strftime('%s', valid_until) AS INTEGER) FROM query_cache "
+                          "WHERE query_hash = ? AND valid_until > datetime('now') "
+                          "ORDER BY use_count DESC, last_used DESC LIMIT 1";
     
-    // Si no hay coincidencia exacta, buscar patrones aprendidos
-    if (!result.isExactMatch) {
-        const char* patternSql = "SELECT pattern_text, response_template, confidence FROM learned_patterns "
-                               "ORDER BY confidence DESC, use_count DESC";
+    {
+        sqlite3_stmt* stmt;
+        std::lock_guard<std::mutex> lock(dbMutex);
         
-        rc = sqlite3_prepare_v2(db, patternSql, -1, &stmt, nullptr);
+        int rc = sqlite3_prepare_v2(db, cacheSql, -1, &stmt, nullptr);
         if (rc != SQLITE_OK) {
             return result;
         }
         
-        std::string normalizedQuery = normalizeQuery(query);
+        sqlite3_bind_text(stmt, 1, queryHash.c_str(), -1, SQLITE_STATIC);
         
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            std::string pattern = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            std::string response = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            float confidence = sqlite3_column_double(stmt, 2);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            result.responseTemplate = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            result.confidence = sqlite3_column_double(stmt, 1);
+            result.isExactMatch = true;
             
-            try {
-                std::regex re(pattern, std::regex::icase);
-                if (std::regex_search(normalizedQuery, re)) {
-                    // Actualizar estadísticas del patrón
-                    const char* updateSql = "UPDATE learned_patterns SET use_count = use_count + 1, last_used = datetime('now') WHERE pattern_text = ?";
-                    sqlite3_stmt* updateStmt;
-                    sqlite3_prepare_v2(db, updateSql, -1, &updateStmt, nullptr);
-                    sqlite3_bind_text(updateStmt, 1, pattern.c_str(), -1, SQLITE_STATIC);
-                    sqlite3_step(updateStmt);
-                    sqlite3_finalize(updateStmt);
-                    
-                    // Si encontramos un patrón con mayor confianza, actualizamos el resultado
-                    if (confidence > result.confidence) {
-                        result.responseTemplate = response;
-                        result.confidence = confidence;
-                    }
-                }
-            } catch (const std::regex_error& e) {
-                // Ignorar patrones con expresiones regulares inválidas
-                continue;
-            }
+            // El uso se contabiliza en memoria y se escribe en segundo plano
+            queryCache.put(queryHash, result.responseTemplate, result.confidence,
+                           static_cast<time_t>(sqlite3_column_int64(stmt, 2)), 1);
         }
         
         sqlite3_finalize(stmt);
     }
     
+    // Si no hay coincidencia exacta, buscar patrones aprendidos (sin bloquear la base de datos)
+    if (!result.isExactMatch) {
+        PatternMatcher::Pattern best;
+        std::vector<std::string> matched;
+        
+        if (patternMatcher.match(normalized, best, matched)) {
+            result.responseTemplate = best.responseTemplate;
+            result.confidence = best.confidence;
+        }
+        
+        if (!matched.empty()) {
+            recordPatternUses(matched);
+        }
+    }
+    
     return result;
 }
 
+void LearningEngine::recordPatternUses(const std::vector<std::string>& patterns) {
+    std::lock_guard<std::mutex> lock(patternUsesMutex);
+    for (const auto& pattern : patterns) {
+        pendingPatternUses[pattern]++;
+    }
+}
+
+void LearningEngine::flushPatternUses() {
+    std::unordered_map<std::string, int> batch;
+    {
+        std::lock_guard<std::mutex> lock(patternUsesMutex);
+        batch.swap(pendingPatternUses);
+    }
+    
+    if (batch.empty()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(dbMutex);
+    
+    const char* updateSql = "UPDATE learned_patterns SET use_count = use_count + ?, last_used = datetime('now') WHERE pattern_text = ?";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, updateSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error al preparar la actualización de patrones: " << sqlite3_errmsg(db) << std::endl;
+        return;
+    }
+    
+    // Un solo commit para todo el lote
+    sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+    for (const auto& entry : batch) {
+        sqlite3_bind_int(stmt, 1, entry.second);
+        sqlite3_bind_text(stmt, 2, entry.first.c_str(), -1, SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    
+    sqlite3_finalize(stmt);
+}
+
 LearningEngine::LearningStats LearningEngine::getStatistics() {
+    // Incluir en las estadísticas los eventos y usos aún no escritos
+    flushEvents();
+    flushQueryCacheUses();
+    flushPatternUses();
+    
     LearningStats stats;
     stats.totalPatterns = 0;
     stats.totalQueries = 0;
     stats.feedbackCount = 0;
     stats.averageConfidence = 0.0;
     stats.patternsLastMonth = 0;
+    stats.pendingEvents = events.size();
+    stats.eventsWritten = eventsWritten;
+    stats.eventBatches = eventBatches;
+    stats.eventQueueFull = eventQueueFull;
+    stats.eventsDropped = eventsDropped;
     
     std::lock_guard<std::mutex> lock(dbMutex);
     
@@ -316,22 +725,13 @@ LearningEngine::LearningStats LearningEngine::getStatistics() {
 }
 
 std::string LearningEngine::hashQuery(const std::string& query) {
-    // Normalizar la consulta antes de calcular el hash
-    std::string normalized = normalizeQuery(query);
+    // Normalizar la consulta antes de calcular el hash (búfer reutilizado por hilo)
+    thread_local std::string normalized;
+    QueryNormalizer::normalize(query, normalized);
     
-    // Calcular SHA-256
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    SHA256_Update(&sha256, normalized.c_str(), normalized.length());
-    SHA256_Final(hash, &sha256);
-    
-    // Convertir a hexadecimal
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-    }
-    return ss.str();
+    std::string hash;
+    QueryNormalizer::hash(normalized, hashMode, hash);
+    return hash;
 }
 
 std::vector<std::string> LearningEngine::extractPossiblePatterns(const std::string& query) {
@@ -341,19 +741,15 @@ std::vector<std::string> LearningEngine::extractPossiblePatterns(const std::stri
     // Extraer frases completas
     patterns.push_back(normalized);
     
-    // Extraer palabras clave de inmigración
-    std::vector<std::string> keywords = {
-        "visa", "green card", "ciudadanía", "citizenship", "i-485", "i-130", 
-        "ajuste de estatus", "tps", "daca", "asylum", "asilo", "permiso de trabajo",
-        "work permit", "naturalización", "naturalization", "deportación", "deportation",
-        "eb1", "eb2", "eb3", "h1b", "f1", "j1", "b1", "b2"
-    };
+    // Palabras clave e interrogativas en una pasada del diccionario de la base
+    std::shared_ptr<const KeywordDictionary> dictionary = dictionarySource
+        ? dictionarySource()
+        : KeywordDictionary::builtin();
+    KeywordDictionary::Matches matches = dictionary->scan(normalized);
     
     std::string pattern;
-    for (const auto& keyword : keywords) {
-        if (normalized.find(keyword) != std::string::npos) {
-            pattern += keyword + "|";
-        }
+    for (const auto& keyword : matches.keywords) {
+        pattern += keyword + "|";
     }
     
     if (!pattern.empty()) {
@@ -361,17 +757,9 @@ std::vector<std::string> LearningEngine::extractPossiblePatterns(const std::stri
         patterns.push_back(".*(" + pattern + ").*");
     }
     
-    // Intentar identificar patrones de preguntas
-    if (normalized.find("cómo") != std::string::npos || 
-        normalized.find("como") != std::string::npos || 
-        normalized.find("how") != std::string::npos) {
-        patterns.push_back(".*\\b(como|cómo|how)\\b.*");
-    }
-    
-    if (normalized.find("qué") != std::string::npos || 
-        normalized.find("que") != std::string::npos || 
-        normalized.find("what") != std::string::npos) {
-        patterns.push_back(".*\\b(que|qué|what)\\b.*");
+    // Patrones de preguntas: .*\b(como|how)\b.*
+    for (const auto& question : matches.questions) {
+        patterns.push_back(".*\\b(" + question + ")\\b.*");
     }
     
     return patterns;
@@ -404,48 +792,13 @@ float LearningEngine::calculatePatternSuccessRate(const std::string& pattern) {
 }
 
 std::string LearningEngine::normalizeQuery(const std::string& query) {
-    std::string result = query;
-    
-    // Convertir a minúsculas
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-    
-    // Eliminar caracteres especiales y acentos
-    std::string accents = "áéíóúüñÁÉÍÓÚÜÑ";
-    std::string replacements = "aeiouunAEIOUUN";
-    
-    for (size_t i = 0; i < result.length(); i++) {
-        size_t pos = accents.find(result[i]);
-        if (pos != std::string::npos) {
-            result[i] = replacements[pos];
-        }
-    }
-    
-    // Eliminar signos de puntuación extra
-    std::regex punct_re("[!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~]{2,}");
-    result = std::regex_replace(result, punct_re, " ");
-    
-    // Eliminar espacios extras
-    std::regex space_re("\\s+");
-    result = std::regex_replace(result, space_re, " ");
-    
-    // Recortar espacios al inicio y final
-    result = std::regex_replace(result, std::regex("^\\s+|\\s+$"), "");
-    
+    // Minúsculas, sin acentos, espacios y puntuación colapsados, en una sola pasada
+    std::string result;
+    QueryNormalizer::normalize(query, result);
     return result;
 }
 
 std::string LearningEngine::fillResponseTemplate(const std::string& templ, const std::unordered_map<std::string, std::string>& vars) {
-    std::string result = templ;
-    
-    // Reemplazar variables en el template
-    for (const auto& var : vars) {
-        std::string placeholder = "{{" + var.first + "}}";
-        size_t pos = result.find(placeholder);
-        while (pos != std::string::npos) {
-            result.replace(pos, placeholder.length(), var.second);
-            pos = result.find(placeholder, pos + var.second.length());
-        }
-    }
-    
-    return result;
+    // Una sola pasada; los marcadores sin variable se conservan tal cual
+    return CompiledTemplate::compile(templ).render(vars, CompiledTemplate::Missing::KEEP);
 }
@@ -0,0 +1,370 @@
+#include "pattern_matcher.h"
+#include <iostream>
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <cstring>
+
+namespace {
+
+const char* REGEX_METACHARS = "\\.^$|?*+()[]{}";
+
+bool isMetachar(char c) {
+    return std::strchr(REGEX_METACHARS, c) != nullptr;
+}
+
+// Mismo criterio que \b en std::regex (solo ASCII alfanumérico y '_')
+bool isWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool isBoundary(const std::string& text, size_t pos) {
+    bool before = pos > 0 && isWordChar(text[pos - 1]);
+    bool after = pos < text.size() && isWordChar(text[pos]);
+    return before != after;
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Intenta reducir el patrón a una lista de literales alternativos con
+// límites de palabra opcionales, p. ej. ".*\b(como|how)\b.*"
+bool parseKeywordPattern(const std::string& pattern, std::vector<std::string>& alternatives,
+                         bool& leftBoundary, bool& rightBoundary) {
+    std::string body = pattern;
+    while (startsWith(body, ".*")) {
+        body.erase(0, 2);
+    }
+    while (endsWith(body, ".*") && !endsWith(body, "\\.*")) {
+        body.erase(body.size() - 2);
+    }
+
+    leftBoundary = startsWith(body, "\\b");
+    if (leftBoundary) {
+        body.erase(0, 2);
+    }
+    rightBoundary = endsWith(body, "\\b");
+    if (rightBoundary) {
+        body.erase(body.size() - 2);
+    }
+
+    if (body.size() >= 2 && body.front() == '(' && body.back() == ')') {
+        body = body.substr(1, body.size() - 2);
+    } else if (body.find('|') != std::string::npos) {
+        return false;
+    }
+
+    alternatives.clear();
+    std::string current;
+    for (char c : body) {
+        if (c == '|') {
+            alternatives.push_back(current);
+            current.clear();
+        } else if (isMetachar(c)) {
+            return false;
+        } else {
+            current += c;
+        }
+    }
+    alternatives.push_back(current);
+
+    for (const auto& alternative : alternatives) {
+        if (alternative.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Literal que toda coincidencia del regex debe contener (el tramo sin
+// metacaracteres más largo fuera de grupos y cuantificadores). Vacío si no
+// se puede garantizar, p. ej. con alternancia de primer nivel.
+std::string requiredLiteral(const std::string& pattern) {
+    int depth = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] == '\\') {
+            i++;
+        } else if (pattern[i] == '(' || pattern[i] == '[') {
+            depth++;
+        } else if (pattern[i] == ')' || pattern[i] == ']') {
+            depth--;
+        } else if (pattern[i] == '|' && depth == 0) {
+            return "";
+        }
+    }
+
+    std::string best, run;
+    auto endRun = [&]() {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    depth = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        if (c == '\\') {
+            endRun();
+            i++;
+        } else if (c == '(' || c == '[') {
+            endRun();
+            depth++;
+        } else if (c == ')' || c == ']') {
+            endRun();
+            depth--;
+        } else if (depth > 0) {
+            continue;
+        } else if (c == '?' || c == '*' || c == '{') {
+            // El carácter anterior es opcional o repetible: no es obligatorio
+            if (!run.empty()) {
+                run.pop_back();
+            }
+            endRun();
+            if (c == '{') {
+                while (i < pattern.size() && pattern[i] != '}') {
+                    i++;
+                }
+            }
+        } else if (isMetachar(c)) {
+            endRun();
+        } else {
+            run += c;
+        }
+    }
+    endRun();
+
+    return toLower(best);
+}
+
+} // namespace
+
+struct PatternMatcher::Compiled {
+    struct Literal {
+        size_t target;       // Índice del patrón o del regex (si es prefiltro)
+        size_t length;
+        bool leftBoundary;
+        bool rightBoundary;
+        bool prefilter;
+    };
+
+    struct Node {
+        std::vector<std::pair<unsigned char, int>> children;
+        int fail = 0;
+        std::vector<size_t> outputs;  // Índices en literals
+    };
+
+    struct CompiledRegex {
+        size_t pattern;
+        std::regex re;
+        bool prefiltered;
+    };
+
+    std::vector<Pattern> patterns;
+    std::vector<Literal> literals;
+    std::vector<Node> nodes;
+    std::vector<CompiledRegex> regexes;
+
+    int child(int node, unsigned char c) const {
+        for (const auto& edge : nodes[node].children) {
+            if (edge.first == c) {
+                return edge.second;
+            }
+        }
+        return -1;
+    }
+
+    void insert(const std::string& text, const Literal& literal) {
+        int node = 0;
+        for (unsigned char c : text) {
+            int next = child(node, c);
+            if (next < 0) {
+                next = static_cast<int>(nodes.size());
+                nodes.emplace_back();
+                nodes[node].children.emplace_back(c, next);
+            }
+            node = next;
+        }
+        nodes[node].outputs.push_back(literals.size());
+        literals.push_back(literal);
+    }
+
+    void buildFailureLinks() {
+        std::queue<int> pending;
+        for (const auto& edge : nodes[0].children) {
+            nodes[edge.second].fail = 0;
+            pending.push(edge.second);
+        }
+
+        while (!pending.empty()) {
+            int node = pending.front();
+            pending.pop();
+
+            for (const auto& edge : nodes[node].children) {
+                int fail = nodes[node].fail;
+                while (fail != 0 && child(fail, edge.first) < 0) {
+                    fail = nodes[fail].fail;
+                }
+                int target = child(fail, edge.first);
+                nodes[edge.second].fail = (target >= 0 && target != edge.second) ? target : 0;
+
+                // Heredar las salidas del sufijo para no recorrer enlaces al buscar
+                const auto& inherited = nodes[nodes[edge.second].fail].outputs;
+                nodes[edge.second].outputs.insert(nodes[edge.second].outputs.end(), inherited.begin(), inherited.end());
+
+                pending.push(edge.second);
+            }
+        }
+    }
+};
+
+PatternMatcher::PatternMatcher() : current(compile({})) {
+}
+
+std::shared_ptr<const PatternMatcher::Compiled> PatternMatcher::compile(std::vector<Pattern> patterns) {
+    auto compiled = std::make_shared<Compiled>();
+    compiled->nodes.emplace_back();
+    compiled->patterns = std::move(patterns);
+
+    for (size_t i = 0; i < compiled->patterns.size(); i++) {
+        const std::string& text = compiled->patterns[i].text;
+
+        std::vector<std::string> alternatives;
+        bool leftBoundary, rightBoundary;
+        if (parseKeywordPattern(text, alternatives, leftBoundary, rightBoundary)) {
+            for (const auto& alternative : alternatives) {
+                std::string literal = toLower(alternative);
+                compiled->insert(literal, {i, literal.size(), leftBoundary, rightBoundary, false});
+            }
+            continue;
+        }
+
+        try {
+            std::regex re(text, std::regex::icase | std::regex::optimize);
+            std::string literal = requiredLiteral(text);
+            bool prefiltered = literal.size() >= 2;
+
+            size_t regexIndex = compiled->regexes.size();
+            compiled->regexes.push_back({i, std::move(re), prefiltered});
+            if (prefiltered) {
+                compiled->insert(literal, {regexIndex, literal.size(), false, false, true});
+            }
+        } catch (const std::regex_error& e) {
+            // Ignorar patrones con expresiones regulares inválidas
+            continue;
+        }
+    }
+
+    compiled->buildFailureLinks();
+    return compiled;
+}
+
+void PatternMatcher::rebuild(std::vector<Pattern> patterns) {
+    auto compiled = compile(std::move(patterns));
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    current.publish(std::move(compiled));
+}
+
+void PatternMatcher::add(const std::vector<Pattern>& patterns) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    std::vector<Pattern> merged = current.read()->patterns;
+    std::unordered_map<std::string, size_t> positions;
+    for (size_t i = 0; i < merged.size(); i++) {
+        positions[merged[i].text] = i;
+    }
+
+    for (const auto& pattern : patterns) {
+        auto it = positions.find(pattern.text);
+        if (it != positions.end()) {
+            merged[it->second] = pattern;
+        } else {
+            positions[pattern.text] = merged.size();
+            merged.push_back(pattern);
+        }
+    }
+
+    current.publish(compile(std::move(merged)));
+}
+
+bool PatternMatcher::match(const std::string& normalizedQuery, Pattern& best, std::vector<std::string>& matchedTexts) const {
+    auto compiled = current.read();
+    if (compiled->patterns.empty()) {
+        return false;
+    }
+
+    std::vector<char> matched(compiled->patterns.size(), 0);
+    std::vector<char> candidates(compiled->regexes.size(), 0);
+
+    // Una sola pasada del autómata sobre la consulta
+    int node = 0;
+    for (size_t i = 0; i < normalizedQuery.size(); i++) {
+        unsigned char c = normalizedQuery[i];
+        int next;
+        while ((next = compiled->child(node, c)) < 0 && node != 0) {
+            node = compiled->nodes[node].fail;
+        }
+        node = next >= 0 ? next : 0;
+
+        for (size_t literalIndex : compiled->nodes[node].outputs) {
+            const auto& literal = compiled->literals[literalIndex];
+            if (literal.prefilter) {
+                candidates[literal.target] = 1;
+                continue;
+            }
+
+            size_t start = i + 1 - literal.length;
+            if ((literal.leftBoundary && !isBoundary(normalizedQuery, start)) ||
+                (literal.rightBoundary && !isBoundary(normalizedQuery, i + 1))) {
+                continue;
+            }
+            matched[literal.target] = 1;
+        }
+    }
+
+    // Solo se evalúan los regex cuyo literal obligatorio apareció
+    for (size_t r = 0; r < compiled->regexes.size(); r++) {
+        const auto& entry = compiled->regexes[r];
+        if (matched[entry.pattern] || (entry.prefiltered && !candidates[r])) {
+            continue;
+        }
+        if (std::regex_search(normalizedQuery, entry.re)) {
+            matched[entry.pattern] = 1;
+        }
+    }
+
+    // Mayor confianza; a igualdad, el primero en orden de carga
+    const Pattern* bestPattern = nullptr;
+    for (size_t p = 0; p < matched.size(); p++) {
+        if (!matched[p]) {
+            continue;
+        }
+        const Pattern& pattern = compiled->patterns[p];
+        matchedTexts.push_back(pattern.text);
+        if (!bestPattern || pattern.confidence > bestPattern->confidence) {
+            bestPattern = &pattern;
+        }
+    }
+
+    if (!bestPattern) {
+        return false;
+    }
+
+    best = *bestPattern;
+    return true;
+}
+
+size_t PatternMatcher::size() const {
+    return current.read()->patterns.size();
+}
@@ -0,0 +1,148 @@
+#include "query_cache.h"
+#include <functional>
+
+QueryCache::QueryCache(size_t capacity, size_t shardCount) {
+    if (shardCount == 0) {
+        shardCount = 1;
+    }
+    for (size_t i = 0; i < shardCount; i++) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    shardCapacity = capacity / shardCount > 0 ? capacity / shardCount : 1;
+}
+
+QueryCache::Shard& QueryCache::shardFor(const std::string& queryHash) const {
+    return *shards[std::hash<std::string>()(queryHash) % shards.size()];
+}
+
+bool QueryCache::lookup(const std::string& queryHash, time_t now, std::string& outResponse, float& outConfidence) {
+    Shard& shard = shardFor(queryHash);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(queryHash);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    Entry& entry = *shard.slots[it->second];
+    if (entry.validUntil <= now) {
+        return false;
+    }
+
+    entry.pendingUses.fetch_add(1, std::memory_order_relaxed);
+    if (entry.lastUsed.load(std::memory_order_relaxed) != now) {
+        entry.lastUsed.store(now, std::memory_order_relaxed);
+    }
+    if (!entry.referenced.load(std::memory_order_relaxed)) {
+        entry.referenced.store(true, std::memory_order_relaxed);
+    }
+
+    outResponse = entry.response;
+    outConfidence = entry.confidence;
+    return true;
+}
+
+void QueryCache::put(const std::string& queryHash, const std::string& response, float confidence,
+                     time_t validUntil, int pendingUses) {
+    Shard& shard = shardFor(queryHash);
+    time_t now = time(nullptr);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    Entry* entry;
+    auto it = shard.index.find(queryHash);
+    if (it != shard.index.end()) {
+        // Reemplazo en el sitio: los usos aún no escritos se conservan
+        entry = shard.slots[it->second].get();
+    } else if (shard.slots.size() < shardCapacity) {
+        shard.slots.push_back(std::make_unique<Entry>());
+        entry = shard.slots.back().get();
+        shard.index.emplace(queryHash, shard.slots.size() - 1);
+    } else {
+        size_t slot = evict(shard, now);
+        entry = shard.slots[slot].get();
+        shard.index.erase(entry->queryHash);
+        shard.index.emplace(queryHash, slot);
+        entry->pendingUses = 0;
+    }
+
+    entry->queryHash = queryHash;
+    entry->response = response;
+    entry->confidence = confidence;
+    entry->validUntil = validUntil;
+    entry->pendingUses += pendingUses;
+    entry->lastUsed = now;
+    entry->referenced = false;
+}
+
+size_t QueryCache::evict(Shard& shard, time_t now) {
+    // Reloj: las entradas leídas desde la última vuelta pierden la marca y se
+    // saltan; la primera sin marca (o caducada) es la víctima. Como mucho da
+    // una vuelta completa antes de encontrarla.
+    while (true) {
+        if (shard.hand >= shard.slots.size()) {
+            shard.hand = 0;
+        }
+        Entry& candidate = *shard.slots[shard.hand];
+        size_t slot = shard.hand++;
+        if (candidate.validUntil <= now || !candidate.referenced.exchange(false)) {
+            retire(shard, candidate);
+            return slot;
+        }
+    }
+}
+
+void QueryCache::retire(Shard& shard, Entry& entry) {
+    int pending = entry.pendingUses.exchange(0);
+    if (pending > 0) {
+        shard.evictedUses.push_back({entry.queryHash, pending, entry.lastUsed.load()});
+    }
+}
+
+void QueryCache::erase(const std::string& queryHash) {
+    Shard& shard = shardFor(queryHash);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(queryHash);
+    if (it == shard.index.end()) {
+        return;
+    }
+    size_t slot = it->second;
+    shard.index.erase(it);
+    retire(shard, *shard.slots[slot]);
+
+    // La última entrada ocupa el hueco para que slots siga compacto
+    if (slot != shard.slots.size() - 1) {
+        shard.slots[slot] = std::move(shard.slots.back());
+        shard.index[shard.slots[slot]->queryHash] = slot;
+    }
+    shard.slots.pop_back();
+}
+
+std::vector<QueryCache::PendingUse> QueryCache::drainPendingUses() {
+    std::vector<PendingUse> uses;
+
+    for (const auto& shard : shards) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        uses.insert(uses.end(), shard->evictedUses.begin(), shard->evictedUses.end());
+        shard->evictedUses.clear();
+        lock.unlock();
+
+        std::shared_lock<std::shared_mutex> readLock(shard->mutex);
+        for (const auto& entry : shard->slots) {
+            int pending = entry->pendingUses.exchange(0);
+            if (pending > 0) {
+                uses.push_back({entry->queryHash, pending, entry->lastUsed.load()});
+            }
+        }
+    }
+
+    return uses;
+}
+
+size_t QueryCache::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->index.size();
+    }
+    return total;
+}
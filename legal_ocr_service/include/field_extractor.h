@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+// Extractor de campos de formularios definido por datos
+// (legal_ocr_service/data/field_rules.json). Las etiquetas de todos los campos
+// y los marcadores de tipo de formulario se compilan una sola vez en un
+// autómata Aho-Corasick que recorre el texto del OCR en una pasada,
+// sin distinguir mayúsculas. Tras cada etiqueta se lee el valor con el
+// analizador de su tipo (fecha, A-Number, número de recibo...). Añadir un campo
+// o un formulario es un cambio en el archivo de reglas, no en el código.
+class FieldExtractor {
+public:
+    struct Field {
+        std::string name;
+        std::string value;       // Normalizado (p. ej. fechas MM/DD/YYYY)
+        size_t offset = 0;       // Posición del valor en el texto
+        size_t length = 0;
+        float confidence = 0.0f; // Según lo estricto del formato y las correcciones aplicadas
+    };
+
+    struct Result {
+        std::string documentType = "unknown";
+        std::vector<Field> fields;   // En orden de aparición
+    };
+
+    static FieldExtractor& forPath(const std::string& rulesPath);
+
+    Result extract(const std::string& text) const;
+
+    size_t ruleCount() const { return rules.size(); }
+
+private:
+    enum class ValueKind {
+        WORDS,            // Nombres y países: letras, espacios, guiones y apóstrofos
+        LINE,             // Resto de la línea
+        DATE,             // MM/DD/YYYY (también con - o .)
+        A_NUMBER,         // A + 7 a 9 dígitos, se normaliza a 9
+        RECEIPT_NUMBER,   // Tres letras + 10 dígitos (MSC2109876543)
+        DIGITS            // Exactamente length dígitos
+    };
+
+    struct Rule {
+        std::string name;
+        ValueKind kind;
+        size_t length = 0;
+        std::vector<int> forms;   // Índices en documentTypes; vacío = todos
+    };
+
+    // Etiqueta de una regla o marcador de un tipo de formulario
+    struct Pattern {
+        size_t length;
+        int rule;                 // -1 si es un marcador
+        int documentType;         // -1 si es una etiqueta
+    };
+
+    struct Value {
+        std::string text;
+        size_t offset = 0;
+        size_t length = 0;
+        float confidence = 0.0f;
+    };
+
+    explicit FieldExtractor(const std::string& rulesPath);
+
+    bool load(const std::string& rulesPath);
+    void build(const std::vector<std::string>& texts);
+
+    static bool parseValue(const std::string& text, size_t pos, const Rule& rule, Value& value);
+
+    std::vector<std::string> documentTypes;   // Orden del archivo (desempata)
+    std::vector<Rule> rules;
+    std::vector<Pattern> patterns;
+
+    // Autómata determinista: transitions[estado * classCount + clase]
+    uint8_t classOf[256] = {};
+    size_t classCount = 1;                    // Clase 0 = byte que no aparece en ningún patrón
+    std::vector<uint32_t> transitions;
+    std::vector<uint32_t> outputStart;        // Patrones que terminan en cada estado:
+    std::vector<int> outputPatterns;          // outputPatterns[outputStart[e] .. outputStart[e + 1])
+
+    static std::mutex extractorsMutex;
+    static std::map<std::string, std::unique_ptr<FieldExtractor>> extractors;
+};
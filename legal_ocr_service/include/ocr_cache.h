@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include "ocr_client.h"
+
+// Caché de resultados OCR direccionada por contenido. Los mismos pasaportes,
+// actas y avisos I-797 se suben una y otra vez en los casos de una familia;
+// la clave es un hash de 128 bits de los bytes decodificados y de los ajustes
+// que cambian el reconocimiento (formato, idiomas, versión del pipeline), así
+// que un acierto evita el reconocimiento entero. Se guardan las páginas en un
+// formato binario compacto en la tabla ocr_cache de SQLite; los campos se
+// vuelven a extraer en cada uso para que un cambio de reglas no invalide nada.
+class OCRCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+    };
+
+    // ttlSeconds = 0: sin caducidad; maxEntries = 0: sin límite
+    OCRCache(const std::string& dbPath, int ttlSeconds, size_t maxEntries);
+
+    static std::string keyFor(std::string_view data, const std::string& settings);
+
+    bool get(const std::string& key, std::vector<OCRClient::PageResult>& pages);
+    void put(const std::string& key, const std::vector<OCRClient::PageResult>& pages);
+
+    // Borra lo caducado y, por encima de maxEntries, lo usado hace más tiempo
+    size_t prune();
+
+    Stats stats() const;
+
+    static std::string encode(const std::vector<OCRClient::PageResult>& pages);
+    static bool decode(const uint8_t* data, size_t length, std::vector<OCRClient::PageResult>& pages);
+
+private:
+    std::string dbPath;
+    int ttlSeconds;
+    size_t maxEntries;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> stores;
+};
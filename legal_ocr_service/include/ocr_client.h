@@ -1,22 +1,88 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
+#include <functional>
 #include <unordered_map>
 
+struct Pix;
+class OCRCache;
+
+// OCR de documentos por páginas: cada página pasa por decodificar →
+// binarizar/enderezar → reconocer en un hilo del TaskPool compartido, con su
+// propio motor del TesseractPool, y los resultados se reúnen en el orden de
+// las páginas antes de extraer los campos del texto completo. La latencia de
+// un expediente largo pasa a depender de la página más lenta y no de la suma.
 class OCRClient {
 public:
+    struct PageResult {
+        size_t index = 0;          // Desde 0, en el orden del documento
+        std::string text;
+        float confidence = 0.0f;
+        size_t words = 0;
+        std::string error;
+    };
+    
+    struct ExtractedField {
+        std::string name;
+        std::string value;
+        size_t page = 0;           // Desde 0
+        size_t offset = 0;         // En fullText
+        float confidence = 0.0f;   // Del formato del valor por la confianza OCR de su página
+    };
+    
     struct OCRResult {
         std::string fullText;
-        float confidence;
+        float confidence = 0.0f;   // Media de las confianzas por palabra de Tesseract (0..1)
         std::vector<std::string> pages;
-        std::unordered_map<std::string, std::string> extractedFields;
+        std::vector<float> pageConfidences;
+        std::string documentType = "unknown";
+        std::vector<ExtractedField> fields;
+        std::unordered_map<std::string, std::string> extractedFields;   // Nombre → valor
+        bool cached = false;       // Páginas tomadas de la caché, sin reconocimiento
+        std::string error;         // Vacío si el reconocimiento fue bien
     };
     
-    static OCRResult processDocument(const std::vector<uint8_t>& documentData, const std::string& documentFormat);
+    // Se llama al terminar cada página, en orden de terminación y nunca a la vez
+    using PageCallback = std::function<void(const PageResult&)>;
+    
+    // Reglas de extracción de campos (legal_ocr_service/data/field_rules.json por defecto);
+    // se fija al arrancar, antes de atender peticiones
+    static void setFieldRules(const std::string& rulesPath);
+    
+    // Caché de resultados por contenido (nullptr = desactivada); se fija al arrancar
+    static void setCache(std::shared_ptr<OCRCache> resultCache);
+    
+    // Resultado completo desde la caché, si estos bytes ya se reconocieron con
+    // los mismos ajustes; no decodifica ni reconoce nada
+    static bool cachedResult(std::string_view documentData, const std::string& documentFormat,
+                             OCRResult& result);
+    
+    // Formatos de imagen que Leptonica decodifica directamente
+    static bool isSupportedFormat(const std::string& documentFormat);
+    
+    // Reconoce siempre el documento y guarda las páginas en la caché si está activa.
+    // documentData es una vista de los bytes del archivo (sin copia); debe
+    // seguir viva hasta que vuelva la llamada
+    static OCRResult processDocument(std::string_view documentData, const std::string& documentFormat,
+                                     const PageCallback& onPage = nullptr);
     
 private:
-    static std::string detectDocumentType(const std::string& text);
-    static std::unordered_map<std::string, std::string> extractFields(const std::string& text, const std::string& documentType);
-    static float calculateOCRConfidence(const std::string& text);
+    static size_t countPages(std::string_view documentData, const std::string& documentFormat);
+    static Pix* decodePage(std::string_view documentData, const std::string& documentFormat, size_t index);
+    // Gris → umbral de Otsu sobre el fondo normalizado → corrección de inclinación
+    static Pix* preprocessPage(Pix* pix);
+    static PageResult recognizePage(std::string_view documentData, const std::string& documentFormat, size_t index);
+    static std::string cacheKey(std::string_view documentData, const std::string& documentFormat);
+    // Texto completo, confianza global y campos a partir de las páginas en orden
+    static void assemble(std::vector<PageResult>& pages, OCRResult& result);
+    static void extractFields(OCRResult& result);
+    
+    // Sube si cambia el preprocesado o el reconocimiento: invalida la caché
+    static const int PIPELINE_VERSION = 1;
+    
+    static std::string fieldRulesPath;
+    static std::shared_ptr<OCRCache> cache;
 };
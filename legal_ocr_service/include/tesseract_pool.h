@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+namespace tesseract {
+class TessBaseAPI;
+}
+
+// Pool de motores Tesseract ya inicializados. Cargar los modelos (Init) tarda
+// segundos y cada TessBaseAPI solo puede usarse desde un hilo a la vez, así que
+// los motores se crean una sola vez al arrancar y cada petición toma uno
+// prestado mientras reconoce.
+class TesseractPool {
+public:
+    // Préstamo RAII de un motor; se devuelve al pool al destruirse
+    class Lease {
+    public:
+        Lease(TesseractPool* pool, tesseract::TessBaseAPI* api) : pool(pool), api(api) {}
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease(Lease&& other) noexcept : pool(other.pool), api(other.api) { other.api = nullptr; }
+
+        tesseract::TessBaseAPI* operator->() const { return api; }
+        tesseract::TessBaseAPI* get() const { return api; }
+        explicit operator bool() const { return api != nullptr; }
+
+    private:
+        TesseractPool* pool;
+        tesseract::TessBaseAPI* api;
+    };
+
+    static TesseractPool& instance();
+
+    // Carga los modelos de dataPath (vacío = TESSDATA_PREFIX o la ruta del
+    // sistema) para language, p. ej. "eng+spa". engines = 0: uno por núcleo.
+    // Devuelve el número de motores inicializados.
+    static size_t configure(const std::string& dataPath, const std::string& language, size_t engines);
+
+    // Espera a que haya un motor libre; vacío si no se pudo inicializar ninguno
+    Lease acquire();
+
+    size_t size() const;
+    const std::string& language() const { return languages; }
+
+    ~TesseractPool();
+
+private:
+    TesseractPool() = default;
+
+    void release(tesseract::TessBaseAPI* api);
+
+    std::string dataPath;
+    std::string languages;
+
+    std::vector<std::unique_ptr<tesseract::TessBaseAPI>> engines;
+    std::vector<tesseract::TessBaseAPI*> idle;
+    mutable std::mutex poolMutex;
+    std::condition_variable available;
+};
@@ -0,0 +1,512 @@
+#include "field_extractor.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <deque>
+#include <cctype>
+#include <cstdio>
+
+std::mutex FieldExtractor::extractorsMutex;
+std::map<std::string, std::unique_ptr<FieldExtractor>> FieldExtractor::extractors;
+
+static bool isAsciiAlnum(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isLetter(char c) {
+    // Los bytes UTF-8 no ASCII cuentan como letras (Ñ, acentos)
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Dígito leído por el OCR, aceptando las confusiones habituales (O→0, l→1, S→5...)
+static int digitValue(char c, bool& corrected) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    int value = -1;
+    switch (c) {
+        case 'O': case 'o': value = 0; break;
+        case 'I': case 'l': case '|': value = 1; break;
+        case 'Z': case 'z': value = 2; break;
+        case 'S': case 's': value = 5; break;
+        case 'B': value = 8; break;
+        default: break;
+    }
+    if (value >= 0) {
+        corrected = true;
+    }
+    return value;
+}
+
+// Lee dígitos (con separadores '-' o ' ' entre grupos) hasta maxDigits
+static size_t readDigits(const std::string& text, size_t pos, size_t end, size_t maxDigits,
+                         std::string& digits, bool& corrected) {
+    size_t i = pos;
+    size_t last = pos;
+    while (i < end && digits.size() < maxDigits) {
+        bool fixed = false;
+        int value = digitValue(text[i], fixed);
+        if (value >= 0) {
+            // Una letra confundible solo cuenta si va pegada a otros dígitos
+            if (fixed && digits.empty() && i + 1 < end && !(text[i + 1] >= '0' && text[i + 1] <= '9')) {
+                break;
+            }
+            digits += static_cast<char>('0' + value);
+            corrected = corrected || fixed;
+            i++;
+            last = i;
+        } else if ((text[i] == '-' || text[i] == ' ') && !digits.empty() && i + 1 < end && text[i + 1] != ' ') {
+            i++;
+        } else {
+            break;
+        }
+    }
+    return last;
+}
+
+FieldExtractor& FieldExtractor::forPath(const std::string& rulesPath) {
+    std::lock_guard<std::mutex> lock(extractorsMutex);
+    auto it = extractors.find(rulesPath);
+    if (it == extractors.end()) {
+        it = extractors.emplace(rulesPath, std::unique_ptr<FieldExtractor>(new FieldExtractor(rulesPath))).first;
+    }
+    return *it->second;
+}
+
+FieldExtractor::FieldExtractor(const std::string& rulesPath) {
+    transitions.assign(1, 0);
+    outputStart.assign(2, 0);
+    if (load(rulesPath)) {
+        std::cout << "Reglas de extracción de campos cargadas: " << rules.size() << " campos, "
+                  << documentTypes.size() << " formularios" << std::endl;
+    }
+}
+
+bool FieldExtractor::load(const std::string& rulesPath) {
+    std::ifstream file(rulesPath);
+    if (!file.is_open()) {
+        std::cerr << "No se pudo abrir el archivo de reglas de campos: " << rulesPath << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> texts;
+    auto addPatternText = [this, &texts](const std::string& text, int rule, int documentType) {
+        if (text.empty()) {
+            return;
+        }
+        std::string lower = text;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        patterns.push_back({lower.size(), rule, documentType});
+        texts.push_back(std::move(lower));
+    };
+
+    try {
+        nlohmann::json data = nlohmann::json::parse(file);
+
+        std::map<std::string, int> typeIndex;
+        for (const auto& entry : data.value("document_types", nlohmann::json::array())) {
+            std::string type = entry.value("type", "");
+            if (type.empty() || typeIndex.count(type)) {
+                continue;
+            }
+            int index = static_cast<int>(documentTypes.size());
+            typeIndex[type] = index;
+            documentTypes.push_back(type);
+            for (const auto& marker : entry.value("markers", std::vector<std::string>{type})) {
+                addPatternText(marker, -1, index);
+            }
+        }
+
+        static const std::map<std::string, ValueKind> kinds = {
+            {"words", ValueKind::WORDS},
+            {"line", ValueKind::LINE},
+            {"date", ValueKind::DATE},
+            {"a_number", ValueKind::A_NUMBER},
+            {"receipt_number", ValueKind::RECEIPT_NUMBER},
+            {"digits", ValueKind::DIGITS},
+        };
+
+        for (const auto& entry : data.value("fields", nlohmann::json::array())) {
+            Rule rule;
+            rule.name = entry.value("name", "");
+            auto kind = kinds.find(entry.value("kind", "line"));
+            if (rule.name.empty() || kind == kinds.end()) {
+                std::cerr << "Regla de campo no válida en " << rulesPath << ": " << entry.dump() << std::endl;
+                continue;
+            }
+            rule.kind = kind->second;
+            rule.length = entry.value("length", 0);
+            if (rule.kind == ValueKind::DIGITS && rule.length == 0) {
+                std::cerr << "Regla de dígitos sin length en " << rulesPath << ": " << rule.name << std::endl;
+                continue;
+            }
+            for (const auto& form : entry.value("forms", std::vector<std::string>{})) {
+                auto type = typeIndex.find(form);
+                if (type == typeIndex.end()) {
+                    std::cerr << "Formulario desconocido en la regla " << rule.name << ": " << form << std::endl;
+                    continue;
+                }
+                rule.forms.push_back(type->second);
+            }
+
+            int index = static_cast<int>(rules.size());
+            rules.push_back(std::move(rule));
+            for (const auto& label : entry.value("labels", std::vector<std::string>{})) {
+                addPatternText(label, index, -1);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error al cargar las reglas de campos " << rulesPath << ": " << e.what() << std::endl;
+        documentTypes.clear();
+        rules.clear();
+        patterns.clear();
+        return false;
+    }
+
+    build(texts);
+    return true;
+}
+
+void FieldExtractor::build(const std::vector<std::string>& texts) {
+    // Alfabeto reducido: solo los bytes que aparecen en algún patrón
+    std::fill(std::begin(classOf), std::end(classOf), 0);
+    classCount = 1;
+    for (const auto& text : texts) {
+        for (char c : text) {
+            uint8_t byte = static_cast<uint8_t>(c);
+            if (classOf[byte] == 0) {
+                classOf[byte] = static_cast<uint8_t>(classCount++);
+                classOf[static_cast<uint8_t>(std::toupper(byte))] = classOf[byte];
+            }
+        }
+    }
+    if (classOf[static_cast<uint8_t>(' ')] != 0) {
+        classOf[static_cast<uint8_t>('\t')] = classOf[static_cast<uint8_t>(' ')];
+    }
+
+    // Trie de los patrones
+    std::vector<std::vector<int32_t>> trie(1, std::vector<int32_t>(classCount, -1));
+    std::vector<std::vector<int>> outputs(1);
+    for (size_t p = 0; p < texts.size(); p++) {
+        int32_t state = 0;
+        for (char c : texts[p]) {
+            uint8_t cls = classOf[static_cast<uint8_t>(c)];
+            if (trie[state][cls] < 0) {
+                trie[state][cls] = static_cast<int32_t>(trie.size());
+                trie.emplace_back(classCount, -1);
+                outputs.emplace_back();
+            }
+            state = trie[state][cls];
+        }
+        outputs[state].push_back(static_cast<int>(p));
+    }
+
+    // Enlaces de fallo por anchura, resueltos directamente en la tabla de transiciones
+    std::vector<int32_t> next(trie.size() * classCount, 0);
+    std::vector<int32_t> fail(trie.size(), 0);
+    std::deque<int32_t> queue;
+    for (size_t cls = 0; cls < classCount; cls++) {
+        int32_t child = trie[0][cls];
+        if (child > 0) {
+            next[cls] = child;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        int32_t state = queue.front();
+        queue.pop_front();
+        const auto& inherited = outputs[fail[state]];
+        outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+
+        for (size_t cls = 0; cls < classCount; cls++) {
+            int32_t child = trie[state][cls];
+            int32_t fallback = next[fail[state] * classCount + cls];
+            if (child > 0) {
+                fail[child] = fallback;
+                next[state * classCount + cls] = child;
+                queue.push_back(child);
+            } else {
+                next[state * classCount + cls] = fallback;
+            }
+        }
+    }
+
+    // Cada entrada guarda el inicio de la fila destino y, en el bit bajo, si en
+    // ese estado termina algún patrón: el bucle de búsqueda no toca outputs en
+    // los bytes que no cierran ninguna etiqueta
+    outputStart.assign(1, 0);
+    outputPatterns.clear();
+    for (const auto& list : outputs) {
+        outputPatterns.insert(outputPatterns.end(), list.begin(), list.end());
+        outputStart.push_back(static_cast<uint32_t>(outputPatterns.size()));
+    }
+    transitions.resize(next.size());
+    for (size_t i = 0; i < next.size(); i++) {
+        uint32_t target = static_cast<uint32_t>(next[i]);
+        transitions[i] = (target * static_cast<uint32_t>(classCount)) << 1 | (outputs[target].empty() ? 0u : 1u);
+    }
+}
+
+bool FieldExtractor::parseValue(const std::string& text, size_t pos, const Rule& rule, Value& value) {
+    size_t end = text.find('\n', pos);
+    if (end == std::string::npos) {
+        end = text.size();
+    }
+    if (end > pos && text[end - 1] == '\r') {
+        end--;
+    }
+
+    // Separadores tras la etiqueta y una indicación de formato, p. ej. "(mm/dd/yyyy):"
+    size_t i = pos;
+    bool hint = false;
+    while (i < end) {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == ':' || c == '#' || c == '.' || c == '-') {
+            i++;
+        } else if (c == '(' && !hint && rule.kind != ValueKind::LINE) {
+            size_t close = text.find(')', i);
+            if (close == std::string::npos || close >= end) {
+                break;
+            }
+            hint = true;
+            i = close + 1;
+        } else {
+            break;
+        }
+    }
+    if (i >= end) {
+        return false;
+    }
+
+    value.offset = i;
+    bool corrected = false;
+
+    switch (rule.kind) {
+        case ValueKind::WORDS:
+        case ValueKind::LINE: {
+            if (rule.kind == ValueKind::WORDS && !isLetter(text[i])) {
+                return false;
+            }
+            // Dos espacios o un tabulador separan columnas del formulario
+            size_t j = i;
+            while (j < end && text[j] != '\t' && !(text[j] == ' ' && j + 1 < end && text[j + 1] == ' ')) {
+                char c = text[j];
+                if (rule.kind == ValueKind::WORDS &&
+                    !(isLetter(c) || c == ' ' || c == '-' || c == '\'' || c == ',' || c == '.')) {
+                    break;
+                }
+                j++;
+            }
+            while (j > i && (text[j - 1] == ' ' || text[j - 1] == ',' || text[j - 1] == '-')) {
+                j--;
+            }
+            if (j - i < 2) {
+                return false;
+            }
+            value.text = text.substr(i, j - i);
+            value.length = j - i;
+            value.confidence = rule.kind == ValueKind::WORDS ? 0.8f : 0.6f;
+            return true;
+        }
+
+        case ValueKind::DATE: {
+            int parts[3] = {0, 0, 0};
+            size_t j = i;
+            for (int part = 0; part < 3; part++) {
+                size_t maxDigits = part == 2 ? 4 : 2;
+                size_t digits = 0;
+                while (j < end && digits < maxDigits) {
+                    int digit = digitValue(text[j], corrected);
+                    if (digit < 0) {
+                        break;
+                    }
+                    parts[part] = parts[part] * 10 + digit;
+                    digits++;
+                    j++;
+                }
+                if (digits == 0 || (part == 2 && digits != 4)) {
+                    return false;
+                }
+                if (part < 2) {
+                    if (j >= end || (text[j] != '/' && text[j] != '-' && text[j] != '.')) {
+                        return false;
+                    }
+                    j++;
+                }
+            }
+            if (j < end && isAsciiAlnum(text[j])) {
+                return false;
+            }
+            if (parts[0] < 1 || parts[0] > 12 || parts[1] < 1 || parts[1] > 31) {
+                return false;
+            }
+            char buffer[11];
+            snprintf(buffer, sizeof(buffer), "%02d/%02d/%04d", parts[0], parts[1], parts[2]);
+            value.text = buffer;
+            value.length = j - i;
+            value.confidence = corrected ? 0.7f : 1.0f;
+            return true;
+        }
+
+        case ValueKind::A_NUMBER: {
+            size_t j = i;
+            if (text[j] == 'A' || text[j] == 'a') {
+                j++;
+                if (j < end && (text[j] == '-' || text[j] == ' ')) {
+                    j++;
+                }
+            }
+            std::string digits;
+            j = readDigits(text, j, end, 9, digits, corrected);
+            if (digits.size() < 7 || (j < end && isAsciiAlnum(text[j]))) {
+                return false;
+            }
+            value.text = "A" + std::string(9 - digits.size(), '0') + digits;
+            value.length = j - i;
+            value.confidence = corrected ? 0.7f : (digits.size() == 9 ? 1.0f : 0.9f);
+            return true;
+        }
+
+        case ValueKind::RECEIPT_NUMBER: {
+            if (end - i < 13) {
+                return false;
+            }
+            std::string receipt;
+            for (size_t k = 0; k < 3; k++) {
+                char c = text[i + k];
+                if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
+                    return false;
+                }
+                receipt += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            size_t j = i + 3;
+            if (j < end && (text[j] == ' ' || text[j] == '-')) {
+                j++;
+            }
+            std::string digits;
+            j = readDigits(text, j, end, 10, digits, corrected);
+            if (digits.size() != 10 || (j < end && isAsciiAlnum(text[j]))) {
+                return false;
+            }
+            value.text = receipt + digits;
+            value.length = j - i;
+            value.confidence = corrected ? 0.7f : 1.0f;
+            return true;
+        }
+
+        case ValueKind::DIGITS: {
+            std::string digits;
+            size_t j = readDigits(text, i, end, rule.length, digits, corrected);
+            if (digits.size() != rule.length || (j < end && isAsciiAlnum(text[j]))) {
+                return false;
+            }
+            value.text = digits;
+            value.length = j - i;
+            value.confidence = corrected ? 0.7f : 1.0f;
+            return true;
+        }
+    }
+    return false;
+}
+
+FieldExtractor::Result FieldExtractor::extract(const std::string& text) const {
+    Result result;
+
+    const size_t npos = std::string::npos;
+    std::vector<size_t> typeSeen(documentTypes.size(), npos);
+
+    // Primera coincidencia de cada regla; ante etiquetas solapadas gana la que
+    // empieza antes y, a igualdad, la más larga ("Applicant Name" frente a "Applicant")
+    struct Match {
+        size_t labelStart = std::string::npos;
+        size_t labelLength = 0;
+        Value value;
+    };
+    std::vector<Match> matches(rules.size());
+
+    uint32_t row = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        uint32_t entry = transitions[row + classOf[static_cast<uint8_t>(text[i])]];
+        row = entry >> 1;
+        if (!(entry & 1)) {
+            continue;
+        }
+        size_t state = row / classCount;
+        for (uint32_t k = outputStart[state]; k < outputStart[state + 1]; k++) {
+            const Pattern& pattern = patterns[outputPatterns[k]];
+            size_t start = i + 1 - pattern.length;
+            size_t after = i + 1;
+            if (start > 0 && isAsciiAlnum(text[start - 1])) {
+                continue;
+            }
+            if (after < text.size() && isAsciiAlnum(text[after]) && isAsciiAlnum(text[i])) {
+                continue;
+            }
+
+            if (pattern.rule < 0) {
+                typeSeen[pattern.documentType] = std::min(typeSeen[pattern.documentType], start);
+                continue;
+            }
+
+            Match& match = matches[pattern.rule];
+            if (match.labelStart != npos &&
+                !(start < match.labelStart || (start == match.labelStart && pattern.length > match.labelLength))) {
+                continue;
+            }
+            Value value;
+            if (parseValue(text, after, rules[pattern.rule], value)) {
+                match.labelStart = start;
+                match.labelLength = pattern.length;
+                match.value = std::move(value);
+            }
+        }
+    }
+
+    // El título del formulario va al principio; los demás que aparezcan son solo citas.
+    // A igual posición decide el orden del archivo de reglas.
+    int type = -1;
+    for (size_t t = 0; t < documentTypes.size(); t++) {
+        if (typeSeen[t] != npos && (type < 0 || typeSeen[t] < typeSeen[type])) {
+            type = static_cast<int>(t);
+        }
+    }
+    if (type >= 0) {
+        result.documentType = documentTypes[type];
+    }
+
+    for (size_t r = 0; r < rules.size(); r++) {
+        if (matches[r].labelStart == npos) {
+            continue;
+        }
+        const auto& forms = rules[r].forms;
+        if (!forms.empty() && std::find(forms.begin(), forms.end(), type) == forms.end()) {
+            continue;
+        }
+        Field field;
+        field.name = rules[r].name;
+        field.value = std::move(matches[r].value.text);
+        field.offset = matches[r].value.offset;
+        field.length = matches[r].value.length;
+        field.confidence = matches[r].value.confidence;
+        result.fields.push_back(std::move(field));
+    }
+
+    // Varias reglas pueden compartir nombre (una por formulario): se queda la primera en el texto
+    std::sort(result.fields.begin(), result.fields.end(), [](const Field& a, const Field& b) {
+        return a.offset < b.offset;
+    });
+    std::vector<Field> unique;
+    for (auto& field : result.fields) {
+        bool seen = std::any_of(unique.begin(), unique.end(), [&field](const Field& other) {
+            return other.name == field.name;
+        });
+        if (!seen) {
+            unique.push_back(std::move(field));
+        }
+    }
+    result.fields = std::move(unique);
+    return result;
+}
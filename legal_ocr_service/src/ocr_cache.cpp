@@ -0,0 +1,206 @@
+#include "ocr_cache.h"
+#include "sqlite_pool.h"
+#include "hash.h"
+#include <iostream>
+#include <cstring>
+#include <ctime>
+
+// Cambia si cambia el formato binario de las páginas
+static const uint8_t ENCODING_VERSION = 1;
+
+template <typename T>
+static void append(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool read(const uint8_t*& cursor, const uint8_t* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(value));
+    cursor += sizeof(value);
+    return true;
+}
+
+OCRCache::OCRCache(const std::string& dbPath, int ttlSeconds, size_t maxEntries)
+    : dbPath(dbPath), ttlSeconds(ttlSeconds), maxEntries(maxEntries), hits(0), misses(0), stores(0) {
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
+        std::cerr << "No se pudo abrir la base de datos para la caché de OCR" << std::endl;
+        return;
+    }
+    sqlite3_exec(conn.db(),
+                 "CREATE TABLE IF NOT EXISTS ocr_cache ("
+                 "content_key TEXT PRIMARY KEY, pages BLOB NOT NULL, "
+                 "created_at INTEGER NOT NULL, last_used INTEGER NOT NULL)",
+                 nullptr, nullptr, nullptr);
+    sqlite3_exec(conn.db(), "CREATE INDEX IF NOT EXISTS idx_ocr_cache_last_used ON ocr_cache(last_used)",
+                 nullptr, nullptr, nullptr);
+}
+
+std::string OCRCache::keyFor(std::string_view data, const std::string& settings) {
+    // Hash de los bytes (sin copiarlos) y después de ese hash junto a los ajustes
+    uint64_t contentHash[2];
+    Hash::murmur3_128(data.data(), data.size(), 0, contentHash);
+
+    std::string material(reinterpret_cast<const char*>(contentHash), sizeof(contentHash));
+    material += settings;
+
+    return Hash::hex128(material);
+}
+
+std::string OCRCache::encode(const std::vector<OCRClient::PageResult>& pages) {
+    size_t size = 1 + sizeof(uint32_t);
+    for (const auto& page : pages) {
+        size += 2 * sizeof(uint32_t) + sizeof(float) + page.text.size();
+    }
+
+    std::string out;
+    out.reserve(size);
+    append(out, ENCODING_VERSION);
+    append(out, static_cast<uint32_t>(pages.size()));
+    for (const auto& page : pages) {
+        append(out, static_cast<uint32_t>(page.words));
+        append(out, page.confidence);
+        append(out, static_cast<uint32_t>(page.text.size()));
+        out += page.text;
+    }
+    return out;
+}
+
+bool OCRCache::decode(const uint8_t* data, size_t length, std::vector<OCRClient::PageResult>& pages) {
+    const uint8_t* cursor = data;
+    const uint8_t* end = data + length;
+
+    uint8_t version = 0;
+    uint32_t count = 0;
+    if (!read(cursor, end, version) || version != ENCODING_VERSION || !read(cursor, end, count)) {
+        return false;
+    }
+
+    pages.clear();
+    pages.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        OCRClient::PageResult page;
+        uint32_t words = 0;
+        uint32_t textLength = 0;
+        if (!read(cursor, end, words) || !read(cursor, end, page.confidence) || !read(cursor, end, textLength) ||
+            static_cast<size_t>(end - cursor) < textLength) {
+            return false;
+        }
+        page.index = i;
+        page.words = words;
+        page.text.assign(reinterpret_cast<const char*>(cursor), textLength);
+        cursor += textLength;
+        pages.push_back(std::move(page));
+    }
+    return cursor == end && !pages.empty();
+}
+
+bool OCRCache::get(const std::string& key, std::vector<OCRClient::PageResult>& pages) {
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
+        misses++;
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    bool found = false;
+    {
+        auto stmt = conn.prepare("SELECT pages, created_at FROM ocr_cache WHERE content_key = ?");
+        if (!stmt) {
+            misses++;
+            return false;
+        }
+        sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+            sqlite3_int64 createdAt = sqlite3_column_int64(stmt.get(), 1);
+            const void* blob = sqlite3_column_blob(stmt.get(), 0);
+            int length = sqlite3_column_bytes(stmt.get(), 0);
+            bool fresh = ttlSeconds <= 0 || createdAt + ttlSeconds > now;
+            found = fresh && blob && decode(static_cast<const uint8_t*>(blob), static_cast<size_t>(length), pages);
+        }
+    }
+    if (!found) {
+        misses++;
+        return false;
+    }
+
+    auto touch = conn.prepare("UPDATE ocr_cache SET last_used = ? WHERE content_key = ?");
+    if (touch) {
+        sqlite3_bind_int64(touch.get(), 1, static_cast<sqlite3_int64>(now));
+        sqlite3_bind_text(touch.get(), 2, key.c_str(), -1, SQLITE_STATIC);
+        sqlite3_step(touch.get());
+    }
+    hits++;
+    return true;
+}
+
+void OCRCache::put(const std::string& key, const std::vector<OCRClient::PageResult>& pages) {
+    // Un resultado con páginas fallidas no se reutiliza
+    for (const auto& page : pages) {
+        if (!page.error.empty()) {
+            return;
+        }
+    }
+
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
+        return;
+    }
+    auto stmt = conn.prepare("INSERT OR REPLACE INTO ocr_cache (content_key, pages, created_at, last_used) "
+                             "VALUES (?, ?, ?, ?)");
+    if (!stmt) {
+        return;
+    }
+
+    std::string encoded = encode(pages);
+    sqlite3_int64 now = static_cast<sqlite3_int64>(time(nullptr));
+    sqlite3_bind_text(stmt.get(), 1, key.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_blob(stmt.get(), 2, encoded.data(), static_cast<int>(encoded.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt.get(), 3, now);
+    sqlite3_bind_int64(stmt.get(), 4, now);
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+        std::cerr << "Error al guardar en la caché de OCR: " << sqlite3_errmsg(conn.db()) << std::endl;
+        return;
+    }
+    stores++;
+}
+
+size_t OCRCache::prune() {
+    auto conn = SQLitePool::forPath(dbPath).acquire();
+    if (!conn) {
+        return 0;
+    }
+
+    size_t removed = 0;
+    if (ttlSeconds > 0) {
+        auto stmt = conn.prepare("DELETE FROM ocr_cache WHERE created_at <= ?");
+        if (stmt) {
+            sqlite3_bind_int64(stmt.get(), 1, static_cast<sqlite3_int64>(time(nullptr) - ttlSeconds));
+            if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+                removed += static_cast<size_t>(sqlite3_changes(conn.db()));
+            }
+        }
+    }
+    if (maxEntries > 0) {
+        auto stmt = conn.prepare("DELETE FROM ocr_cache WHERE content_key IN "
+                                 "(SELECT content_key FROM ocr_cache ORDER BY last_used DESC LIMIT -1 OFFSET ?)");
+        if (stmt) {
+            sqlite3_bind_int64(stmt.get(), 1, static_cast<sqlite3_int64>(maxEntries));
+            if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+                removed += static_cast<size_t>(sqlite3_changes(conn.db()));
+            }
+        }
+    }
+    return removed;
+}
+
+OCRCache::Stats OCRCache::stats() const {
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.stores = stores.load();
+    return stats;
+}
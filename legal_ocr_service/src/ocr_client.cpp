@@ -1,125 +1,270 @@
 #include "ocr_client.h"
+#include "metrics.h"
+#include "tesseract_pool.h"
+#include "task_pool.h"
+#include "field_extractor.h"
+#include "ocr_cache.h"
+#include <tesseract/baseapi.h>
+#include <leptonica/allheaders.h>
 #include <iostream>
-#include <regex>
+#include <cstdio>
+#include <mutex>
+#include <algorithm>
 
-OCRClient::OCRResult OCRClient::processDocument(const std::vector<uint8_t>& documentData, const std::string& documentFormat) {
-    OCRResult result;
+std::string OCRClient::fieldRulesPath = "legal_ocr_service/data/field_rules.json";
+std::shared_ptr<OCRCache> OCRClient::cache;
+
+void OCRClient::setFieldRules(const std::string& rulesPath) {
+    fieldRulesPath = rulesPath;
+    FieldExtractor::forPath(fieldRulesPath);
+}
+
+void OCRClient::setCache(std::shared_ptr<OCRCache> resultCache) {
+    cache = std::move(resultCache);
+}
+
+bool OCRClient::isSupportedFormat(const std::string& documentFormat) {
+    return documentFormat == "png" || documentFormat == "jpg" || documentFormat == "jpeg" ||
+           documentFormat == "tif" || documentFormat == "tiff";
+}
+
+static const l_uint8* bytes(std::string_view data) {
+    return reinterpret_cast<const l_uint8*>(data.data());
+}
+
+static bool isTiff(const std::string& documentFormat) {
+    return documentFormat == "tif" || documentFormat == "tiff";
+}
+
+size_t OCRClient::countPages(std::string_view documentData, const std::string& documentFormat) {
+    if (!isTiff(documentFormat)) {
+        return documentData.empty() ? 0 : 1;
+    }
     
-    // En un sistema real, aquí utilizaríamos Tesseract para procesar el documento
-    // Para este ejemplo, simularemos el resultado
-    
-    // Simular el texto extraído según el formato
-    if (documentFormat == "pdf" || documentFormat == "jpg" || documentFormat == "png") {
-        // Texto simulado de un documento de inmigración
-        result.fullText = "DEPARTMENT OF HOMELAND SECURITY\n"
-                         "U.S. Citizenship and Immigration Services\n\n"
-                         "I-485, APPLICATION TO REGISTER PERMANENT RESIDENCE\n\n"
-                         "Applicant: JOHN DOE\n"
-                         "A-Number: A123456789\n"
-                         "Date of Birth: 01/01/1980\n"
-                         "Country of Birth: MEXICO\n"
-                         "Current Status: B-2 VISITOR\n"
-                         "Receipt Number: MSC2109876543\n"
-                         "Priority Date: 06/15/2018\n\n"
-                         "This document contains information about your application...";
-        
-        // Simular páginas
-        result.pages.push_back("Page 1: Header and Personal Information");
-        result.pages.push_back("Page 2: Application Details");
-        
-        // Detectar tipo de documento
-        std::string documentType = detectDocumentType(result.fullText);
-        
-        // Extraer campos específicos
-        result.extractedFields = extractFields(result.fullText, documentType);
-        
-        // Calcular confianza
-        result.confidence = calculateOCRConfidence(result.fullText);
+    // Solo se recorre el índice de directorios; las páginas se decodifican en paralelo
+    FILE* fp = fopenReadFromMemory(bytes(documentData), documentData.size());
+    if (!fp) {
+        return 0;
+    }
+    l_int32 count = 0;
+    if (tiffGetCount(fp, &count) != 0) {
+        count = 0;
+    }
+    fclose(fp);
+    return static_cast<size_t>(std::max(count, 0));
+}
+
+Pix* OCRClient::decodePage(std::string_view documentData, const std::string& documentFormat, size_t index) {
+    if (isTiff(documentFormat)) {
+        return pixReadMemTiff(bytes(documentData), documentData.size(), static_cast<l_int32>(index));
+    }
+    return pixReadMem(bytes(documentData), documentData.size());
+}
+
+Pix* OCRClient::preprocessPage(Pix* pix) {
+    Pix* binary = nullptr;
+    if (pixGetDepth(pix) == 1) {
+        binary = pixClone(pix);
     } else {
-        // Formato no soportado
-        result.fullText = "Unsupported document format";
-        result.confidence = 0.0;
+        Pix* gray = pixConvertTo8(pix, 0);
+        if (!gray) {
+            return nullptr;
+        }
+        // El umbral local soporta fondos irregulares (fotocopias, sellos, fotos con sombra)
+        binary = pixOtsuThreshOnBackgroundNorm(gray, nullptr, 10, 15, 100, 50, 255, 2, 2, 0.1f, nullptr);
+        pixDestroy(&gray);
+        if (!binary) {
+            return nullptr;
+        }
     }
     
-    return result;
+    Pix* deskewed = pixDeskew(binary, 0);
+    if (!deskewed) {
+        return binary;
+    }
+    pixDestroy(&binary);
+    return deskewed;
 }
 
-std::string OCRClient::detectDocumentType(const std::string& text) {
-    // Detectar el tipo de formulario basado en patrones en el texto
-    if (text.find("I-485") != std::string::npos) {
-        return "I-485";
-    } else if (text.find("I-130") != std::string::npos) {
-        return "I-130";
-    } else if (text.find("I-751") != std::string::npos) {
-        return "I-751";
-    } else if (text.find("N-400") != std::string::npos) {
-        return "N-400";
-    } else if (text.find("I-765") != std::string::npos) {
-        return "I-765";
-    } else if (text.find("I-601") != std::string::npos) {
-        return "I-601";
-    }
-    
-    return "unknown";
+OCRClient::PageResult OCRClient::recognizePage(std::string_view documentData, const std::string& documentFormat,
+                                               size_t index) {
+    static LatencyHistogram& pageStage = Metrics::stage("ocr_page");
+    Metrics::ScopedTimer timer(pageStage);
+    
+    PageResult page;
+    page.index = index;
+    
+    Pix* original = decodePage(documentData, documentFormat, index);
+    if (!original) {
+        page.error = "Could not decode page " + std::to_string(index + 1);
+        return page;
+    }
+    // Sin DPI en la imagen Tesseract supone 70 y escala mal el texto pequeño
+    l_int32 resolution = pixGetXRes(original) > 0 ? pixGetXRes(original) : 300;
+    
+    Pix* pix = preprocessPage(original);
+    if (pix) {
+        pixDestroy(&original);
+    } else {
+        pix = original;
+    }
+    
+    {
+        TesseractPool::Lease engine = TesseractPool::instance().acquire();
+        if (!engine) {
+            pixDestroy(&pix);
+            page.error = "OCR engine not available";
+            return page;
+        }
+        
+        engine->SetImage(pix);
+        engine->SetSourceResolution(resolution);
+        
+        if (engine->Recognize(nullptr) == 0) {
+            char* text = engine->GetUTF8Text();
+            if (text) {
+                page.text = text;
+                delete[] text;
+            }
+            
+            int* confidences = engine->AllWordConfidences();
+            if (confidences) {
+                long sum = 0;
+                for (int* c = confidences; *c >= 0; c++) {
+                    sum += *c;
+                    page.words++;
+                }
+                delete[] confidences;
+                page.confidence = page.words > 0 ? static_cast<float>(sum) / page.words / 100.0f : 0.0f;
+            }
+        } else {
+            page.error = "Recognition failed on page " + std::to_string(index + 1);
+        }
+        engine->Clear();
+    }
+    
+    pixDestroy(&pix);
+    return page;
 }
 
-std::unordered_map<std::string, std::string> OCRClient::extractFields(const std::string& text, const std::string& documentType) {
-    std::unordered_map<std::string, std::string> fields;
+OCRClient::OCRResult OCRClient::processDocument(std::string_view documentData, const std::string& documentFormat,
+                                                const PageCallback& onPage) {
+    static LatencyHistogram& ocrStage = Metrics::stage("ocr");
+    Metrics::ScopedTimer timer(ocrStage);
     
-    // Extraer campos comunes usando expresiones regulares
-    std::regex nameRegex("Applicant:\\s*([A-Z\\s]+)");
-    std::regex aNumberRegex("A-Number:\\s*(A[0-9]+)");
-    std::regex dobRegex("Date of Birth:\\s*([0-9]{2}/[0-9]{2}/[0-9]{4})");
-    std::regex countryRegex("Country of Birth:\\s*([A-Z\\s]+)");
-    
-    std::smatch match;
+    OCRResult result;
     
-    if (std::regex_search(text, match, nameRegex) && match.size() > 1) {
-        fields["applicant_name"] = match[1];
+    if (!isSupportedFormat(documentFormat)) {
+        // Los PDF escaneados hay que rasterizarlos antes; Leptonica no los lee
+        result.error = "Unsupported document format: " + documentFormat;
+        return result;
     }
     
-    if (std::regex_search(text, match, aNumberRegex) && match.size() > 1) {
-        fields["a_number"] = match[1];
+    size_t pageCount = countPages(documentData, documentFormat);
+    if (pageCount == 0) {
+        result.error = "Could not decode " + documentFormat + " image";
+        return result;
+    }
+    if (TesseractPool::instance().size() == 0) {
+        result.error = "OCR engine not available";
+        return result;
     }
     
-    if (std::regex_search(text, match, dobRegex) && match.size() > 1) {
-        fields["date_of_birth"] = match[1];
+    // Las páginas se reparten entre los hilos; cada una escribe solo su hueco
+    std::vector<PageResult> pages(pageCount);
+    std::mutex callbackMutex;
+    TaskPool::shared().parallelFor(pageCount, [&](size_t i) {
+        pages[i] = recognizePage(documentData, documentFormat, i);
+        if (onPage) {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            onPage(pages[i]);
+        }
+    });
+    
+    if (cache) {
+        cache->put(cacheKey(documentData, documentFormat), pages);
     }
     
-    if (std::regex_search(text, match, countryRegex) && match.size() > 1) {
-        fields["country_of_birth"] = match[1];
+    assemble(pages, result);
+    return result;
+}
+
+bool OCRClient::cachedResult(std::string_view documentData, const std::string& documentFormat,
+                             OCRResult& result) {
+    if (!cache || !isSupportedFormat(documentFormat)) {
+        return false;
     }
     
-    // Campos específicos según el tipo de documento
-    if (documentType == "I-485") {
-        std::regex receiptRegex("Receipt Number:\\s*([A-Z0-9]+)");
-        std::regex priorityRegex("Priority Date:\\s*([0-9]{2}/[0-9]{2}/[0-9]{4})");
-        
-        if (std::regex_search(text, match, receiptRegex) && match.size() > 1) {
-            fields["receipt_number"] = match[1];
+    std::vector<PageResult> pages;
+    if (!cache->get(cacheKey(documentData, documentFormat), pages)) {
+        return false;
+    }
+    result = OCRResult();
+    result.cached = true;
+    assemble(pages, result);
+    return true;
+}
+
+std::string OCRClient::cacheKey(std::string_view documentData, const std::string& documentFormat) {
+    // Todo lo que cambia el texto reconocido para los mismos bytes
+    std::string settings = isTiff(documentFormat) ? "tiff" : "image";
+    settings += '|';
+    settings += TesseractPool::instance().language();
+    settings += '|';
+    settings += std::to_string(PIPELINE_VERSION);
+    return OCRCache::keyFor(documentData, settings);
+}
+
+void OCRClient::assemble(std::vector<PageResult>& pages, OCRResult& result) {
+    // Reunir en orden; la confianza global pondera cada página por sus palabras
+    double confidenceSum = 0.0;
+    size_t wordCount = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < pages.size(); i++) {
+        PageResult& page = pages[i];
+        if (!page.error.empty()) {
+            std::cerr << "OCR: " << page.error << std::endl;
+            failed++;
         }
-        
-        if (std::regex_search(text, match, priorityRegex) && match.size() > 1) {
-            fields["priority_date"] = match[1];
+        if (i > 0) {
+            result.fullText += "\n";
         }
+        result.fullText += page.text;
+        confidenceSum += static_cast<double>(page.confidence) * page.words;
+        wordCount += page.words;
+        result.pageConfidences.push_back(page.confidence);
+        result.pages.push_back(std::move(page.text));
+    }
+    if (failed == pages.size()) {
+        result.error = pages.front().error;
+        return;
     }
+    result.confidence = wordCount > 0 ? static_cast<float>(confidenceSum / wordCount) : 0.0f;
     
-    return fields;
+    // Los campos pueden estar en cualquier página: se extraen del texto completo
+    extractFields(result);
 }
 
-float OCRClient::calculateOCRConfidence(const std::string& text) {
-    // En un sistema real, esto se basaría en la confianza que reporta Tesseract
-    // Para este ejemplo, simularemos basado en la longitud del texto
+void OCRClient::extractFields(OCRResult& result) {
+    FieldExtractor::Result extracted = FieldExtractor::forPath(fieldRulesPath).extract(result.fullText);
+    result.documentType = extracted.documentType;
     
-    if (text.empty()) {
-        return 0.0;
+    // Inicio de cada página en fullText (unidas con un salto de línea)
+    std::vector<size_t> pageStarts;
+    size_t start = 0;
+    for (const auto& page : result.pages) {
+        pageStarts.push_back(start);
+        start += page.size() + 1;
     }
     
-    if (text.length() < 100) {
-        return 0.5; // Poca confianza si hay poco texto
-    } else if (text.length() < 500) {
-        return 0.8; // Confianza media
-    } else {
-        return 0.95; // Alta confianza para documentos con mucho texto
+    for (auto& field : extracted.fields) {
+        ExtractedField out;
+        out.offset = field.offset;
+        out.page = std::upper_bound(pageStarts.begin(), pageStarts.end(), field.offset) - pageStarts.begin() - 1;
+        out.confidence = field.confidence * result.pageConfidences[out.page];
+        out.name = std::move(field.name);
+        out.value = std::move(field.value);
+        result.extractedFields[out.name] = out.value;
+        result.fields.push_back(std::move(out));
     }
 }
@@ -0,0 +1,92 @@
+#include "tesseract_pool.h"
+#include "metrics.h"
+#include <tesseract/baseapi.h>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+TesseractPool::Lease::~Lease() {
+    if (api) {
+        pool->release(api);
+    }
+}
+
+TesseractPool& TesseractPool::instance() {
+    static TesseractPool pool;
+    return pool;
+}
+
+size_t TesseractPool::configure(const std::string& dataPath, const std::string& language, size_t engines) {
+    if (engines == 0) {
+        // El reconocimiento es CPU puro: más motores que núcleos solo añade memoria
+        engines = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    TesseractPool& pool = instance();
+    std::lock_guard<std::mutex> lock(pool.poolMutex);
+    if (pool.idle.size() != pool.engines.size()) {
+        std::cerr << "No se puede reconfigurar el pool de Tesseract con motores en uso" << std::endl;
+        return pool.engines.size();
+    }
+
+    for (auto& api : pool.engines) {
+        api->End();
+    }
+    pool.engines.clear();
+    pool.idle.clear();
+    pool.dataPath = dataPath;
+    pool.languages = language;
+
+    for (size_t i = 0; i < engines; i++) {
+        auto api = std::make_unique<tesseract::TessBaseAPI>();
+        if (api->Init(dataPath.empty() ? nullptr : dataPath.c_str(), language.c_str(), tesseract::OEM_DEFAULT) != 0) {
+            std::cerr << "Error al inicializar Tesseract (" << language << ") con los modelos de "
+                      << (dataPath.empty() ? "TESSDATA_PREFIX" : dataPath) << std::endl;
+            break;
+        }
+        api->SetPageSegMode(tesseract::PSM_AUTO);
+        pool.idle.push_back(api.get());
+        pool.engines.push_back(std::move(api));
+    }
+
+    std::cout << "Motores OCR inicializados: " << pool.engines.size() << " (" << language << ")" << std::endl;
+    return pool.engines.size();
+}
+
+TesseractPool::~TesseractPool() {
+    for (auto& api : engines) {
+        api->End();
+    }
+}
+
+size_t TesseractPool::size() const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return engines.size();
+}
+
+TesseractPool::Lease TesseractPool::acquire() {
+    // Espera hasta que otra petición devuelva un motor
+    static LatencyHistogram& waitStage = Metrics::stage("ocr_wait");
+    Metrics::ScopedTimer timer(waitStage);
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    if (engines.empty()) {
+        return Lease(this, nullptr);
+    }
+    available.wait(lock, [this] { return !idle.empty(); });
+
+    tesseract::TessBaseAPI* api = idle.back();
+    idle.pop_back();
+    return Lease(this, api);
+}
+
+void TesseractPool::release(tesseract::TessBaseAPI* api) {
+    // Sin resultados ni adaptación de la petición anterior
+    api->Clear();
+    api->ClearAdaptiveClassifier();
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        idle.push_back(api);
+    }
+    available.notify_one();
+}
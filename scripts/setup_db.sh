@@ -96,6 +96,21 @@ CREATE TABLE IF NOT EXISTS learned_patterns (
     use_count INTEGER DEFAULT 0
 );
 
+-- Estado del aprendizaje incremental (último feedback procesado)
+CREATE TABLE IF NOT EXISTS learning_state (
+    key TEXT PRIMARY KEY,
+    value INTEGER
+);
+
+-- Caché de resultados OCR por contenido (páginas en binario)
+CREATE TABLE IF NOT EXISTS ocr_cache (
+    content_key TEXT PRIMARY KEY,
+    pages BLOB NOT NULL,
+    created_at INTEGER NOT NULL,
+    last_used INTEGER NOT NULL
+);
+CREATE INDEX IF NOT EXISTS idx_ocr_cache_last_used ON ocr_cache(last_used);
+
 -- Inicializar cuotas por nivel si no existen
 INSERT OR IGNORE INTO quotas (tier, daily_queries, monthly_documents, openai_usage, monthly_ocr, monthly_tts_minutes, has_advanced_features)
 VALUES 
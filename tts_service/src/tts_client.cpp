@@ -1,8 +1,12 @@
 #include "tts_client.h"
+#include "metrics.h"
 #include <iostream>
 #include <random>
 
 TTSClient::TTSResult TTSClient::synthesizeSpeech(const std::string& text, const TTSOptions& options) {
+    static LatencyHistogram& ttsStage = Metrics::stage("tts");
+    Metrics::ScopedTimer timer(ttsStage);
+    
     TTSResult result;
     
     // En un sistema real, aquí utilizaríamos eSpeak o alguna otra biblioteca TTS